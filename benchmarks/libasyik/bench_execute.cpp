@@ -0,0 +1,165 @@
+/**
+ * libasyik cross-thread execute() throughput benchmark
+ *
+ * One service thread, 1..N producer threads that each post a fixed number of
+ * trivial tasks with as->execute(). Reports the aggregate rate (tasks/s until
+ * every task has run) for each producer count, in both run modes.
+ *
+ * A second table covers execute() and execute_detached() called from a fiber
+ * on the service itself, together with the heap allocations each task costs
+ * once the service is warm (counted by replacing global operator new).
+ *
+ * Usage:
+ *   ./bench_execute [max_producers] [tasks_per_producer]
+ *       max_producers       highest producer count        (default 8)
+ *       tasks_per_producer  tasks posted by each producer (default 200000)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "aixlog.hpp"
+#include "libasyik/service.hpp"
+
+namespace {
+std::atomic<long> heap_allocs{0};
+}
+
+void* operator new(std::size_t n)
+{
+  heap_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct local_result {
+  double rate;
+  double allocs_per_task;
+};
+
+// Posts @p tasks from a fiber on the service itself, in windows of 256, once
+// to warm up and once measured.
+local_result run_local(bool detached, int tasks)
+{
+  auto as = asyik::make_service();
+  local_result r{};
+  as->execute([&]() {
+    const int window = 256;
+    int done = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+      long allocs0 = heap_allocs.load();
+      auto t0 = clock_type::now();
+      for (int posted = 0; posted < tasks;) {
+        int n = std::min(window, tasks - posted);
+        int target = done + n;
+        for (int i = 0; i < n; ++i) {
+          if (detached)
+            as->execute_detached([&done]() { ++done; });
+          else
+            as->execute([&done]() { ++done; });
+        }
+        posted += n;
+        while (done < target) boost::this_fiber::yield();
+      }
+      double secs =
+          std::chrono::duration<double>(clock_type::now() - t0).count();
+      r = {tasks / secs, double(heap_allocs.load() - allocs0) / tasks};
+    }
+    as->stop();
+  });
+  as->run();
+  return r;
+}
+
+double run(asyik::service_run_mode mode, int producers, int tasks)
+{
+  asyik::service_ptr as;
+  std::atomic<bool> ready{false};
+  std::thread th([&]() {
+    as = asyik::make_service();
+    as->set_run_mode(mode);
+    ready = true;
+    as->run();
+  });
+  while (!ready) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // every execute() spawns a fiber; cap the tasks each producer has in
+  // flight so the run measures hand-off rate rather than stack allocation
+  const int window = 256;
+  const long total = static_cast<long>(producers) * tasks;
+  long done = 0;  // only touched on the service thread
+  fibers::promise<void> finished;
+  auto finished_future = finished.get_future();
+
+  std::atomic<bool> go{false};
+  std::vector<std::thread> ths;
+  std::vector<std::atomic<int>> completed(producers);
+  for (int p = 0; p < producers; ++p)
+    ths.emplace_back([&, p]() {
+      auto& c = completed[p];
+      while (!go) std::this_thread::yield();
+      for (int i = 0; i < tasks; ++i) {
+        while (i - c.load(std::memory_order_relaxed) >= window)
+          std::this_thread::yield();
+        as->execute([&done, &finished, &c, total]() {
+          c.fetch_add(1, std::memory_order_relaxed);
+          if (++done == total) finished.set_value();
+        });
+      }
+    });
+
+  auto t0 = clock_type::now();
+  go = true;
+  for (auto& t : ths) t.join();
+  finished_future.wait();
+  double secs =
+      std::chrono::duration<double>(clock_type::now() - t0).count();
+
+  as->stop();
+  th.join();
+  return total / secs;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  int max_producers = argc > 1 ? std::max(1, std::atoi(argv[1])) : 8;
+  int tasks = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200000;
+
+  std::printf("[bench_execute] %d tasks per producer\n", tasks);
+  std::printf("  %9s | %16s | %16s\n", "producers", "polling tasks/s",
+              "event tasks/s");
+  std::printf("  ----------+------------------+-----------------\n");
+
+  for (int p = 1; p <= max_producers; p *= 2) {
+    double polling = run(asyik::service_run_mode::polling, p, tasks);
+    double event = run(asyik::service_run_mode::event_driven, p, tasks);
+    std::printf("  %9d | %16.0f | %16.0f\n", p, polling, event);
+  }
+
+  std::printf("\n[bench_execute] same-thread, %d tasks\n", tasks);
+  std::printf("  %-16s | %12s | %12s\n", "call", "tasks/s", "allocs/task");
+  std::printf("  -----------------+--------------+-------------\n");
+  auto e = run_local(false, tasks);
+  std::printf("  %-16s | %12.0f | %12.2f\n", "execute", e.rate,
+              e.allocs_per_task);
+  auto d = run_local(true, tasks);
+  std::printf("  %-16s | %12.0f | %12.2f\n", "execute_detached", d.rate,
+              d.allocs_per_task);
+  return 0;
+}
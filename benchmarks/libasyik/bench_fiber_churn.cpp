@@ -0,0 +1,213 @@
+/**
+ * libasyik fiber churn benchmark — pooled vs. fresh execute() fibers
+ *
+ * Short-lived connections cost one execute() fiber each. This compares a
+ * service that creates and tears down a fiber per task (fiber pool size 0)
+ * against one that hands tasks to parked fibers (service default):
+ *
+ *   1. synthetic – a fiber on the service posts tasks that suspend twice
+ *                  (standing in for the read and the write of a request)
+ *   2. tcp       – client threads open a connection, send a few bytes, read
+ *                  the reply and reset the connection, paced to a target
+ *                  rate; the server spawns one fiber per accepted socket
+ *
+ * For tcp it reports the achieved connections/s and the CPU time the service
+ * thread spent per connection (getrusage(RUSAGE_THREAD), sampled in-thread).
+ *
+ * Usage:
+ *   ./bench_fiber_churn [target_rate] [seconds] [clients] [port]
+ *       target_rate  tcp connections per second to aim for  (default 100000)
+ *       seconds      duration of every tcp run              (default 5)
+ *       clients      client threads opening connections      (default 4)
+ *       port         tcp port                               (default 8097)
+ */
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/ssl/error.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "aixlog.hpp"
+#include "libasyik/error.hpp"
+#include "libasyik/internal/asio_internal.hpp"
+#include "libasyik/service.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+long thread_cpu_us()
+{
+  struct rusage ru;
+  getrusage(RUSAGE_THREAD, &ru);
+  return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000L +
+         ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+double run_synthetic(std::size_t pool, int tasks)
+{
+  auto as = asyik::make_service();
+  as->set_fiber_pool_size(pool);
+  double rate = 0;
+  as->execute([&]() {
+    const int window = 256;
+    int done = 0;
+    for (int pass = 0; pass < 2; ++pass) {  // warm-up, then measured
+      auto t0 = clock_type::now();
+      for (int posted = 0; posted < tasks;) {
+        int n = std::min(window, tasks - posted);
+        int target = done + n;
+        for (int i = 0; i < n; ++i)
+          as->execute_detached([&done]() {
+            boost::this_fiber::yield();
+            boost::this_fiber::yield();
+            ++done;
+          });
+        posted += n;
+        while (done < target) boost::this_fiber::yield();
+      }
+      rate = tasks / std::chrono::duration<double>(clock_type::now() - t0)
+                         .count();
+    }
+    as->stop();
+  });
+  as->run();
+  return rate;
+}
+
+struct tcp_result {
+  double conn_per_sec;
+  double cpu_us_per_conn;
+  long failed;
+};
+
+tcp_result run_tcp(std::size_t pool, int rate, int seconds, int clients,
+                   uint16_t port)
+{
+  asyik::service_ptr as;
+  std::shared_ptr<tcp::acceptor> acceptor;
+  std::atomic<bool> ready{false};
+
+  std::thread th([&]() {
+    as = asyik::make_service();
+    as->set_fiber_pool_size(pool);
+    acceptor = std::make_shared<tcp::acceptor>(
+        as->get_io_service(),
+        tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), port));
+    acceptor->listen(4096);
+
+    as->execute([as, acceptor]() {
+      try {
+        for (;;) {
+          tcp::socket s(as->get_io_service());
+          acceptor->async_accept(s, asyik::use_fiber_future).get();
+          as->execute_detached([s = std::move(s)]() mutable {
+            try {
+              char buf[64];
+              s.async_read_some(boost::asio::buffer(buf),
+                                asyik::use_fiber_future)
+                  .get();
+              boost::asio::async_write(s, boost::asio::buffer("ok", 2),
+                                       asyik::use_fiber_future)
+                  .get();
+            } catch (...) {
+            }
+          });
+        }
+      } catch (...) {
+        // acceptor closed
+      }
+    });
+    ready = true;
+    as->run();
+  });
+  while (!ready) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  std::atomic<long> done{0}, failed{0};
+  auto deadline = clock_type::now() + std::chrono::seconds(seconds);
+  const auto interval =
+      std::chrono::duration_cast<clock_type::duration>(
+          std::chrono::duration<double>(double(clients) / rate));
+
+  auto cpu0 = as->execute([]() { return thread_cpu_us(); }).get();
+  auto t0 = clock_type::now();
+
+  std::vector<std::thread> ths;
+  for (int c = 0; c < clients; ++c)
+    ths.emplace_back([&]() {
+      boost::asio::io_context io;
+      tcp::endpoint ep(boost::asio::ip::make_address("127.0.0.1"), port);
+      auto next = clock_type::now();
+      while (clock_type::now() < deadline) {
+        try {
+          tcp::socket s(io);
+          s.connect(ep);
+          boost::asio::write(s, boost::asio::buffer("ping", 4));
+          char buf[2];
+          boost::asio::read(s, boost::asio::buffer(buf));
+          // RST instead of FIN: no TIME_WAIT pile-up at high churn
+          s.set_option(boost::asio::socket_base::linger(true, 0));
+          s.close();
+          done.fetch_add(1, std::memory_order_relaxed);
+        } catch (...) {
+          failed.fetch_add(1, std::memory_order_relaxed);
+        }
+        // paced, but never sleep to catch up on a schedule already missed
+        next += interval;
+        auto now = clock_type::now();
+        if (next > now)
+          std::this_thread::sleep_until(next);
+        else
+          next = now;
+      }
+    });
+  for (auto& t : ths) t.join();
+
+  double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+  auto cpu1 = as->execute([]() { return thread_cpu_us(); }).get();
+
+  as->execute([acceptor]() { acceptor->close(); }).get();
+  as->stop();
+  th.join();
+
+  long n = std::max(1L, done.load());
+  return {n / secs, double(cpu1 - cpu0) / n, failed.load()};
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  int rate = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+  int seconds = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+  int clients = argc > 3 ? std::max(1, std::atoi(argv[3])) : 4;
+  uint16_t port = argc > 4 ? static_cast<uint16_t>(std::atoi(argv[4])) : 8097;
+
+  const std::size_t pooled = asyik::make_service()->get_fiber_pool_size();
+
+  std::printf("[bench_fiber_churn] synthetic, 200000 tasks\n");
+  std::printf("  %10s | %12s\n", "fiber pool", "tasks/s");
+  std::printf("  -----------+-------------\n");
+  for (std::size_t pool : {std::size_t(0), pooled})
+    std::printf("  %10zu | %12.0f\n", pool, run_synthetic(pool, 200000));
+
+  std::printf("\n[bench_fiber_churn] tcp, target %d conn/s, %d s, %d clients\n",
+              rate, seconds, clients);
+  std::printf("  %10s | %12s | %16s | %8s\n", "fiber pool", "conn/s",
+              "server cpu us/c", "failed");
+  std::printf("  -----------+--------------+------------------+---------\n");
+  for (std::size_t pool : {std::size_t(0), pooled}) {
+    auto r = run_tcp(pool, rate, seconds, clients, port);
+    std::printf("  %10zu | %12.0f | %16.2f | %8ld\n", pool, r.conn_per_sec,
+                r.cpu_us_per_conn, r.failed);
+  }
+  return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * libasyik idle-behaviour benchmark — service run modes
+ *
+ * Compares service_run_mode::polling (poll + yield/sleep tiers),
+ * service_run_mode::event_driven (block in the io_context reactor) and
+ * service_run_mode::busy_poll (never sleep, with SO_BUSY_POLL on the
+ * accepted socket) on the two numbers that matter for bursty traffic:
+ *
+ *   1. idle CPU   – CPU time burnt by the service thread while nothing
+ *                   happens (getrusage(RUSAGE_THREAD) sampled in-thread)
+ *   2. wake-up    – latency of the first request after an idle gap:
+ *        - socket:  GET /plaintext on an already-open keep-alive connection
+ *        - execute: cross-thread as->execute() until the fiber starts
+ *
+ * For busy_poll it also prints how many rounds of the run-loop found no
+ * work at all.
+ *
+ * Usage:
+ *   ./bench_idle [idle_ms] [samples] [port]
+ *       idle_ms  idle gap before every sample / idle CPU window (default 200)
+ *       samples  wake-up samples per mode                        (default 50)
+ *       port     HTTP port used for the socket test              (default 8095)
+ */
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aixlog.hpp"
+#include "libasyik/http.hpp"
+#include "libasyik/service.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+long thread_cpu_us()
+{
+  struct rusage ru;
+  getrusage(RUSAGE_THREAD, &ru);
+  return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000L +
+         ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+struct latency_summary {
+  double p50_us, p99_us, max_us;
+};
+
+latency_summary summarize(std::vector<double> v)
+{
+  std::sort(v.begin(), v.end());
+  auto at = [&v](double q) {
+    return v[std::min(v.size() - 1, static_cast<size_t>(q * v.size()))];
+  };
+  return {at(0.50), at(0.99), v.back()};
+}
+
+double elapsed_us(clock_type::time_point from)
+{
+  return std::chrono::duration<double, std::micro>(clock_type::now() - from)
+      .count();
+}
+
+void run_mode(const char* name, asyik::service_run_mode mode, int idle_ms,
+              int samples, uint16_t port)
+{
+  asyik::service_ptr as;
+  std::atomic<bool> ready{false};
+
+  std::thread th([&]() {
+    as = asyik::make_service();
+    as->set_run_mode(mode);
+    auto server = asyik::make_http_server(as, "127.0.0.1", port);
+    if (mode == asyik::service_run_mode::busy_poll)
+      server->set_busy_poll(std::chrono::microseconds(50));
+    server->on_http_request("/plaintext", "GET", [](auto req, auto /*args*/) {
+      req->response.headers.set("content-type", "text/plain");
+      req->response.body = "Hello, World!";
+      req->response.result(200);
+    });
+    ready = true;
+    as->run();
+  });
+  while (!ready) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // ── 1. idle CPU ──────────────────────────────────────────────────────────
+  // measured inside the service thread so only its own CPU time counts
+  long idle_cpu_us = as->execute([idle_ms]() {
+                         long start = thread_cpu_us();
+                         asyik::sleep_for(std::chrono::milliseconds(idle_ms));
+                         return thread_cpu_us() - start;
+                       })
+                         .get();
+
+  // ── 2a. first-request-after-idle over a keep-alive socket ────────────────
+  asio::io_context client_io;
+  tcp::socket sock(client_io);
+  sock.connect(tcp::endpoint(asio::ip::make_address("127.0.0.1"), port));
+  sock.set_option(tcp::no_delay(true));
+  const std::string request =
+      "GET /plaintext HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+  std::vector<double> socket_us, execute_us;
+  char buf[1024];
+  for (int i = 0; i <= samples; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(idle_ms));
+    auto t0 = clock_type::now();
+    asio::write(sock, asio::buffer(request));
+    size_t n = sock.read_some(asio::buffer(buf));
+    double us = elapsed_us(t0);
+    if (n && i) socket_us.push_back(us);  // first sample warms the path up
+  }
+
+  // ── 2b. first cross-thread execute() after idle ──────────────────────────
+  for (int i = 0; i <= samples; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(idle_ms));
+    auto t0 = clock_type::now();
+    double us = as->execute([t0]() { return elapsed_us(t0); }).get();
+    if (i) execute_us.push_back(us);
+  }
+
+  auto stats = as->execute([as]() { return as->get_scheduler_stats(); }).get();
+  sock.close();
+  as->stop();
+  th.join();
+
+  auto s = summarize(socket_us);
+  auto e = summarize(execute_us);
+  std::printf("  %-13s | %9.1f%% | %8.1f %8.1f %8.1f | %8.1f %8.1f %8.1f\n",
+              name, 100.0 * idle_cpu_us / (idle_ms * 1000.0), s.p50_us,
+              s.p99_us, s.max_us, e.p50_us, e.p99_us, e.max_us);
+  if (stats.busy_polls)
+    std::printf("  %-13s   %llu polls, %.2f%% empty\n", "",
+                static_cast<unsigned long long>(stats.busy_polls),
+                100.0 * stats.busy_polls_empty / stats.busy_polls);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  int idle_ms = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+  int samples = argc > 2 ? std::max(1, std::atoi(argv[2])) : 50;
+  uint16_t port = argc > 3 ? static_cast<uint16_t>(std::atoi(argv[3])) : 8095;
+
+  std::printf("[bench_idle] idle gap %d ms, %d samples per mode\n", idle_ms,
+              samples);
+  std::printf("  %-13s | %10s | %-26s | %-26s\n", "mode", "idle CPU",
+              "socket wake p50/p99/max us", "execute wake p50/p99/max us");
+  std::printf(
+      "  --------------+------------+----------------------------+-------------"
+      "---------------\n");
+
+  run_mode("polling", asyik::service_run_mode::polling, idle_ms, samples,
+           port);
+  run_mode("event_driven", asyik::service_run_mode::event_driven, idle_ms,
+           samples, port + 1);
+  run_mode("busy_poll", asyik::service_run_mode::busy_poll, idle_ms, samples,
+           port + 2);
+  return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * libasyik LIFO wake slot benchmark
+ *
+ * Runs two handoff-heavy loads with service::set_lifo_slot() off and on:
+ *
+ *   ping-pong  two fibers bounce a 16 KB buffer through a pair of channels,
+ *              and each side reads all of it on every hop, while B other
+ *              fibers walk through buffers of their own and yield. FIFO
+ *              wakeups queue every hop behind all of them, by which time
+ *              the buffer has been evicted; the slot runs the woken side
+ *              next. Reports round trips per second and the p50/p99 round
+ *              trip.
+ *
+ *   ws echo    C websocket clients on the same service each send a small
+ *              message to an echo server and wait for the reply. Reports
+ *              echoes per second.
+ *
+ * Usage:
+ *   ./bench_lifo [bystanders] [clients] [seconds] [port]
+ *       bystanders  fibers competing with the ping-pong  (default 16)
+ *       clients     websocket clients                   (default 32)
+ *       seconds     duration of every run               (default 3)
+ *       port        websocket echo server port          (default 8099)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "aixlog.hpp"
+#include "libasyik/http.hpp"
+#include "libasyik/service.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr std::size_t payload_bytes = 16 * 1024;
+constexpr std::size_t bystander_bytes = 64 * 1024;
+
+// reads every cache line of @p v
+uint64_t touch(const std::vector<uint64_t>& v)
+{
+  uint64_t sum = 0;
+  for (std::size_t i = 0; i < v.size(); i += 8) sum += v[i];
+  return sum;
+}
+
+struct pingpong_result {
+  double trips_per_sec, p50_ns, p99_ns;
+  uint64_t handoffs, demotions;
+};
+
+pingpong_result run_pingpong(bool lifo, int bystanders, int seconds)
+{
+  pingpong_result r{};
+  auto as = asyik::make_service();
+  as->set_lifo_slot(lifo);
+
+  as->execute([&]() {
+    std::vector<uint64_t> payload(payload_bytes / sizeof(uint64_t), 1);
+    boost::fibers::buffered_channel<std::vector<uint64_t>*> ping(2), pong(2);
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> sink{0};
+
+    std::vector<boost::fibers::fiber> others;
+    for (int i = 0; i < bystanders; ++i)
+      others.emplace_back([&]() {
+        std::vector<uint64_t> own(bystander_bytes / sizeof(uint64_t), 1);
+        while (!done.load(std::memory_order_relaxed)) {
+          sink += touch(own);
+          boost::this_fiber::yield();
+        }
+      });
+    boost::fibers::fiber echo([&]() {
+      std::vector<uint64_t>* p;
+      while (ping.pop(p) == boost::fibers::channel_op_status::success) {
+        sink += touch(*p);
+        pong.push(p);
+      }
+    });
+
+    std::vector<double> samples;
+    auto end = clock_type::now() + std::chrono::seconds(seconds);
+    auto t0 = clock_type::now();
+    while (clock_type::now() < end) {
+      auto t = clock_type::now();
+      ping.push(&payload);
+      sink += touch(*pong.value_pop());
+      samples.push_back(
+          std::chrono::duration<double, std::nano>(clock_type::now() - t)
+              .count());
+    }
+    double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+
+    done = true;
+    ping.close();
+    echo.join();
+    for (auto& f : others) f.join();
+
+    std::sort(samples.begin(), samples.end());
+    r.trips_per_sec = samples.size() / secs;
+    r.p50_ns = samples[samples.size() / 2];
+    r.p99_ns = samples[samples.size() * 99 / 100];
+    auto stats = as->get_scheduler_stats();
+    r.handoffs = stats.lifo_handoffs;
+    r.demotions = stats.lifo_demotions;
+    as->stop();
+  });
+  as->run();
+  return r;
+}
+
+double run_ws_echo(bool lifo, int clients, int seconds, uint16_t port)
+{
+  auto as = asyik::make_service();
+  as->set_lifo_slot(lifo);
+  auto server = asyik::make_http_server(as, "127.0.0.1", port);
+  server->on_websocket("/echo", [](auto ws, auto /*args*/) {
+    try {
+      while (true) ws->send_string(ws->get_string());
+    } catch (...) {
+      // client went away
+    }
+  });
+
+  double rate = 0;
+  as->execute([&]() {
+    const std::string url = "ws://127.0.0.1:" + std::to_string(port) + "/echo";
+    const std::string msg(64, 'x');
+    std::atomic<bool> done{false};
+    std::vector<long> echoes(clients, 0);
+    std::vector<boost::fibers::future<void>> running;
+    for (int c = 0; c < clients; ++c)
+      running.push_back(as->execute([&, c]() {
+        auto ws = asyik::make_websocket_connection(as, url);
+        while (!done.load(std::memory_order_relaxed)) {
+          ws->send_string(msg);
+          ws->get_string();
+          ++echoes[c];
+        }
+        ws->close(asyik::websocket_close_code::normal, "done");
+      }));
+
+    asyik::sleep_for(std::chrono::milliseconds(200));  // warm-up
+    long n0 = std::accumulate(echoes.begin(), echoes.end(), 0L);
+    auto t0 = clock_type::now();
+    asyik::sleep_for(std::chrono::seconds(seconds));
+    long n = std::accumulate(echoes.begin(), echoes.end(), 0L) - n0;
+    rate = n / std::chrono::duration<double>(clock_type::now() - t0).count();
+
+    done = true;
+    for (auto& f : running) f.get();
+    server->close();
+    as->stop();
+  });
+  as->run();
+  return rate;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  int bystanders = argc > 1 ? std::max(0, std::atoi(argv[1])) : 16;
+  int clients = argc > 2 ? std::max(1, std::atoi(argv[2])) : 32;
+  int seconds = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+  uint16_t port = argc > 4 ? static_cast<uint16_t>(std::atoi(argv[4])) : 8099;
+
+  std::printf("[bench_lifo] ping-pong with %d bystanders, %d s\n", bystanders,
+              seconds);
+  std::printf("  %-10s | %10s | %9s | %9s | %10s | %9s\n", "lifo slot",
+              "trips/s", "p50 ns", "p99 ns", "handoffs", "demoted");
+  std::printf(
+      "  -----------+------------+-----------+-----------+------------+-------"
+      "----\n");
+  for (bool lifo : {false, true}) {
+    auto r = run_pingpong(lifo, bystanders, seconds);
+    std::printf("  %-10s | %10.0f | %9.0f | %9.0f | %10llu | %9llu\n",
+                lifo ? "on" : "off", r.trips_per_sec, r.p50_ns, r.p99_ns,
+                static_cast<unsigned long long>(r.handoffs),
+                static_cast<unsigned long long>(r.demotions));
+  }
+
+  std::printf("\n[bench_lifo] websocket echo, %d clients, %d s\n", clients,
+              seconds);
+  std::printf("  %-10s | %10s\n", "lifo slot", "echoes/s");
+  std::printf("  -----------+-----------\n");
+  for (bool lifo : {false, true})
+    std::printf("  %-10s | %10.0f\n", lifo ? "on" : "off",
+                run_ws_echo(lifo, clients, seconds, port + lifo));
+  return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * libasyik offload round-trip benchmark
+ *
+ * A fiber hands a no-op to the async() worker pool and waits for it, either
+ * through as->async(noop).get() (promise, shared state, future) or through
+ * asyik::offload(noop) (the fiber itself is resumed by the worker). Two
+ * loads, each in both run modes:
+ *
+ *   latency  one fiber doing round trips back to back; reports the p50 and
+ *            p99 round-trip time.
+ *
+ *   load     F fibers doing round trips concurrently; reports round trips
+ *            per second and the service thread's CPU time per round trip.
+ *
+ * Usage:
+ *   ./bench_offload [fibers] [seconds]
+ *       fibers   concurrent fibers of the load runs  (default 64)
+ *       seconds  duration of every run                (default 3)
+ */
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "aixlog.hpp"
+#include "libasyik/service.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+double thread_cpu_ns()
+{
+  rusage ru;
+  ::getrusage(RUSAGE_THREAD, &ru);
+  return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e9 +
+         (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e3;
+}
+
+struct result {
+  double p50_ns, p99_ns;
+  double trips_per_sec, cpu_ns_per_trip;
+};
+
+void round_trip(asyik::service& as, bool offload)
+{
+  if (offload)
+    asyik::offload([]() {});
+  else
+    as.async([]() {}).get();
+}
+
+result run(asyik::service_run_mode mode, bool offload, int fibers,
+           int seconds)
+{
+  result r{};
+  auto as = asyik::make_service();
+  as->set_run_mode(mode);
+
+  as->execute([&]() {
+    as->async([]() {}).get();  // start the worker pool
+
+    // latency: one fiber, round trips back to back
+    std::vector<double> samples;
+    auto end = clock_type::now() + std::chrono::seconds(seconds);
+    while (clock_type::now() < end) {
+      auto t0 = clock_type::now();
+      round_trip(*as, offload);
+      samples.push_back(
+          std::chrono::duration<double, std::nano>(clock_type::now() - t0)
+              .count());
+    }
+    std::sort(samples.begin(), samples.end());
+    r.p50_ns = samples[samples.size() / 2];
+    r.p99_ns = samples[samples.size() * 99 / 100];
+
+    // load: many fibers at once
+    std::atomic<bool> done{false};
+    long trips = 0;
+    int running = fibers;
+    for (int i = 0; i < fibers; ++i)
+      as->execute([&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+          round_trip(*as, offload);
+          ++trips;
+        }
+        --running;
+      });
+    asyik::sleep_for(std::chrono::milliseconds(200));  // warm-up
+    long t0_trips = trips;
+    double cpu0 = thread_cpu_ns();
+    auto t0 = clock_type::now();
+    asyik::sleep_for(std::chrono::seconds(seconds));
+    double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+    long n = trips - t0_trips;
+    r.trips_per_sec = n / secs;
+    r.cpu_ns_per_trip = (thread_cpu_ns() - cpu0) / std::max(n, 1L);
+    done = true;
+    while (running) asyik::sleep_for(std::chrono::milliseconds(1));
+    as->stop();
+  });
+  as->run();
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  int fibers = argc > 1 ? std::max(1, std::atoi(argv[1])) : 64;
+  int seconds = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+
+  std::printf("[bench_offload] %d fibers, %d s\n", fibers, seconds);
+  std::printf("  %-12s | %-12s | %9s | %9s | %10s | %9s\n", "wait", "run mode",
+              "p50 ns", "p99 ns", "trips/s", "cpu ns/rt");
+  std::printf(
+      "  -------------+--------------+-----------+-----------+------------+"
+      "----------\n");
+  for (bool offload : {false, true})
+    for (auto mode : {asyik::service_run_mode::polling,
+                      asyik::service_run_mode::event_driven}) {
+      auto r = run(mode, offload, fibers, seconds);
+      std::printf("  %-12s | %-12s | %9.0f | %9.0f | %10.0f | %9.0f\n",
+                  offload ? "offload()" : "async().get",
+                  mode == asyik::service_run_mode::polling ? "polling"
+                                                           : "event_driven",
+                  r.p50_ns, r.p99_ns, r.trips_per_sec, r.cpu_ns_per_trip);
+    }
+  return 0;
+}
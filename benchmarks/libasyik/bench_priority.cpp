@@ -0,0 +1,117 @@
+/**
+ * libasyik priority scheduling benchmark — latency isolation under load
+ *
+ * A service is saturated with bulk fibers that burn the CPU in short slices
+ * and yield in between (standing in for a large export). Meanwhile a probe
+ * thread calls execute() every couple of milliseconds with a task that only
+ * records how long it took from the call until it ran, once with the probes
+ * at normal priority (queued behind every bulk fiber) and once with
+ * fiber_priority::high.
+ *
+ * Reports the p50 / p99 / max probe latency and the bulk slices completed
+ * per second, to show what the probes cost the bulk work.
+ *
+ * Usage:
+ *   ./bench_priority [bulk_fibers] [slice_us] [seconds]
+ *       bulk_fibers  CPU-bound fibers saturating the service (default 1000)
+ *       slice_us     CPU time per slice between yields     (default 20)
+ *       seconds      duration of every run                 (default 3)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "aixlog.hpp"
+#include "libasyik/service.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct result {
+  double p50_us, p99_us, max_us;
+  double slices_per_sec;
+};
+
+result run(asyik::fiber_priority prio, int bulk, int slice_us, int seconds)
+{
+  asyik::service_ptr as;
+  std::atomic<bool> ready{false};
+  std::atomic<bool> done{false};
+  std::atomic<long> slices{0};
+
+  std::thread th([&]() {
+    as = asyik::make_service();
+    for (int i = 0; i < bulk; ++i)
+      as->execute_detached([&done, &slices, slice_us]() {
+        while (!done.load(std::memory_order_relaxed)) {
+          auto until = clock_type::now() + std::chrono::microseconds(slice_us);
+          while (clock_type::now() < until) {
+          }
+          slices.fetch_add(1, std::memory_order_relaxed);
+          boost::this_fiber::yield();
+        }
+      });
+    ready = true;
+    as->run();
+  });
+  while (!ready) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  // let every bulk fiber get going first
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  long slices0 = slices.load();
+  auto t0 = clock_type::now();
+  auto deadline = t0 + std::chrono::seconds(seconds);
+  std::vector<double> lat;
+  while (clock_type::now() < deadline) {
+    auto posted = clock_type::now();
+    auto ran = as->execute(prio, []() { return clock_type::now(); }).get();
+    lat.push_back(
+        std::chrono::duration<double, std::micro>(ran - posted).count());
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+  long slices1 = slices.load();
+
+  done = true;
+  as->stop();
+  th.join();
+
+  std::sort(lat.begin(), lat.end());
+  auto pct = [&lat](double p) {
+    return lat[std::min(lat.size() - 1, std::size_t(p * lat.size()))];
+  };
+  return {pct(0.50), pct(0.99), lat.back(), (slices1 - slices0) / secs};
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  int bulk = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000;
+  int slice_us = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+  int seconds = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+
+  std::printf("[bench_priority] %d bulk fibers, %d us slices, %d s\n", bulk,
+              slice_us, seconds);
+  std::printf("  %-8s | %10s | %10s | %10s | %12s\n", "probe", "p50 us",
+              "p99 us", "max us", "bulk slice/s");
+  std::printf(
+      "  ---------+------------+------------+------------+-------------\n");
+  for (bool high : {false, true}) {
+    auto r = run(high ? asyik::fiber_priority::high
+                      : asyik::fiber_priority::normal,
+                 bulk, slice_us, seconds);
+    std::printf("  %-8s | %10.1f | %10.1f | %10.1f | %12.0f\n",
+                high ? "high" : "normal", r.p50_us, r.p99_us, r.max_us,
+                r.slices_per_sec);
+  }
+  return 0;
+}
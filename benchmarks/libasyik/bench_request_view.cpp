@@ -0,0 +1,180 @@
+/**
+ * libasyik request view benchmark
+ *
+ * Serves GET /plaintext on keep-alive connections with both parser engines
+ * (http_server::set_parser_engine) and three kinds of handler:
+ *
+ *   regular   on_http_request(): the request is copied into a pooled
+ *             http_request (beast fields, target and body strings)
+ *   view      on_http_request_view(): the handler gets string_views into the
+ *             connection's read buffer
+ *   template  on_http_request_template(): no handler, the response is a
+ *             copy of prebuilt bytes with the Date header patched in
+ *
+ * A client thread sends the requests in pipelined batches over one
+ * connection. Global operator new is counted on the service thread only, so
+ * the client's own allocations stay out of it. Reports requests per second
+ * and allocations per request, for the whole request/response round trip.
+ *
+ * Usage:
+ *   ./bench_request_view [requests] [depth] [port]
+ *       requests  requests per run                  (default 200000)
+ *       depth     requests per pipelined batch       (default 16)
+ *       port      first server port, one per run     (default 8100)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "aixlog.hpp"
+#include "libasyik/http.hpp"
+#include "libasyik/service.hpp"
+
+namespace {
+
+thread_local uint64_t allocations = 0;
+
+}  // namespace
+
+void* operator new(std::size_t n)
+{
+  ++allocations;
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+namespace http = boost::beast::http;
+namespace net = boost::asio;
+using clock_type = std::chrono::steady_clock;
+
+const char request[] =
+    "GET /plaintext HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "User-Agent: bench_request_view\r\n"
+    "Accept: text/plain\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+// sends @p n requests, @p depth at a time, and reads every response
+void run_client(uint16_t port, int n, int depth)
+{
+  net::io_context ioc;
+  net::ip::tcp::socket sock(ioc);
+  sock.connect({net::ip::make_address("127.0.0.1"), port});
+
+  std::string batch;
+  for (int i = 0; i < depth; ++i) batch += request;
+  boost::beast::flat_buffer buf;
+  for (int sent = 0; sent < n; sent += depth) {
+    int k = std::min(depth, n - sent);
+    net::write(sock, net::buffer(batch.data(), k * (sizeof(request) - 1)));
+    for (int i = 0; i < k; ++i) {
+      http::response<http::string_body> res;
+      http::read(sock, buf, res);
+    }
+  }
+}
+
+struct result {
+  double reqs_per_sec, allocs_per_req;
+};
+
+enum class handler { regular, view, response_template };
+
+result run(asyik::http_parser_engine engine, handler kind, int requests,
+           int depth, uint16_t port)
+{
+  result r{};
+  auto as = asyik::make_service();
+  auto server = asyik::make_http_server(as, "127.0.0.1", port);
+  server->set_parser_engine(engine);
+  if (kind == handler::response_template)
+    server->on_http_request_template(
+        "/plaintext", "GET",
+        asyik::http_response_template(200, {{"Content-Type", "text/plain"}},
+                                      "Hello, World!"));
+  else if (kind == handler::view)
+    server->on_http_request_view(
+        "/plaintext", "GET",
+        [](asyik::http_request_view& req, const asyik::http_route_view_args&) {
+          req.response.body = "Hello, World!";
+          req.response.headers.set("Content-Type", "text/plain");
+          req.response.result(200);
+        });
+  else
+    server->on_http_request(
+        "/plaintext", "GET",
+        [](asyik::http_request_ptr req, const asyik::http_route_args&) {
+          req->response.body = "Hello, World!";
+          req->response.headers.set("Content-Type", "text/plain");
+          req->response.result(200);
+        });
+
+  as->execute([&]() {
+    auto client = [&](int n) {
+      std::atomic<bool> done{false};
+      std::thread t([&]() {
+        run_client(port, n, depth);
+        done = true;
+      });
+      while (!done) asyik::sleep_for(std::chrono::milliseconds(1));
+      t.join();
+    };
+
+    client(std::max(depth, requests / 10));  // warm-up: pools and buffers
+
+    uint64_t a0 = allocations;
+    auto t0 = clock_type::now();
+    client(requests);
+    double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+    r.reqs_per_sec = requests / secs;
+    r.allocs_per_req = double(allocations - a0) / requests;
+
+    server->close();
+    as->stop();
+  });
+  as->run();
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  int requests = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+  int depth = argc > 2 ? std::max(1, std::atoi(argv[2])) : 16;
+  uint16_t port = argc > 3 ? static_cast<uint16_t>(std::atoi(argv[3])) : 8100;
+
+  std::printf("[bench_request_view] %d requests, pipelined %d deep\n",
+              requests, depth);
+  std::printf("  %-6s | %-8s | %10s | %12s\n", "parser", "handler", "req/s",
+              "allocs/req");
+  std::printf("  -------+----------+------------+-------------\n");
+  for (auto engine :
+       {asyik::http_parser_engine::beast, asyik::http_parser_engine::simd})
+    for (auto kind :
+         {handler::regular, handler::view, handler::response_template}) {
+      auto r = run(engine, kind, requests, depth, port++);
+      std::printf("  %-6s | %-8s | %10.0f | %12.2f\n",
+                  engine == asyik::http_parser_engine::simd ? "simd" : "beast",
+                  kind == handler::regular ? "regular"
+                  : kind == handler::view  ? "view"
+                                           : "template",
+                  r.reqs_per_sec, r.allocs_per_req);
+    }
+  return 0;
+}
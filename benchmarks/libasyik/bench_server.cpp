@@ -20,6 +20,10 @@
  *   ASYIK_THREAD_MULTIPLIER=N      number of service threads (default: nCPU)
  *                                  Each thread runs its own asyik::service
  *                                  and a separate SO_REUSEPORT acceptor.
+ *   ASYIK_PIN=1                    pin every service thread to its own core
+ *                                  and keep async() threads off those cores.
+ *   ASYIK_PARSER=simd              parse requests with the SIMD scanner
+ *                                  instead of beast's request_parser.
  */
 
 #include <atomic>
@@ -35,6 +39,7 @@
 #include "libasyik/http.hpp"
 #include "libasyik/profiling.hpp"
 #include "libasyik/service.hpp"
+#include "libasyik/service_group.hpp"
 
 // Pre-built constant responses (no per-request allocation)
 static const std::string PLAINTEXT_BODY = "Hello, World!";
@@ -106,37 +111,43 @@ int main(int argc, char* argv[])
     if (v > 0) num_threads = v;
   }
 
-  std::cout << "[bench] libasyik bench server starting on 0.0.0.0:" << port
-            << " with " << num_threads << " service thread(s) (SO_REUSEPORT)\n";
-
-  // ── Shared ready counter ─────────────────────────────────────────────────
-  // Each thread increments it after its server is listening; the main thread
-  // prints "Ready" once all threads have checked in.
-  std::atomic<int> ready_count{0};
-
-  // ── Spawn service threads ────────────────────────────────────────────────
-  // Each thread is fully independent: own io_context, own fiber scheduler,
-  // own acceptor on the same port via SO_REUSEPORT.  No shared variables.
-  std::vector<std::thread> threads;
-  threads.reserve(num_threads);
-
-  for (int i = 0; i < num_threads; ++i) {
-    threads.emplace_back([port, &ready_count]() {
-      auto as = asyik::make_service();
-      // reuse_port=true → SO_REUSEPORT; kernel distributes connections
-      auto server = asyik::make_http_server(as, "0.0.0.0", port,
-                                            /*reuse_port=*/true);
-      register_routes(server);
-
-      ready_count.fetch_add(1, std::memory_order_release);
-      as->run();
-    });
-  }
+  // ── Request parser ─────────────────────────────────────────────────────
+  // ASYIK_PARSER=simd switches to the vectorized request scanner.
+  const char* env_parser = std::getenv("ASYIK_PARSER");
+  auto engine = env_parser && std::string(env_parser) == "simd"
+                    ? asyik::http_parser_engine::simd
+                    : asyik::http_parser_engine::beast;
 
-  // ── Wait until every thread is accepting ────────────────────────────────
-  while (ready_count.load(std::memory_order_acquire) < num_threads) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-  }
+  std::cout << "[bench] libasyik bench server starting on 0.0.0.0:" << port
+            << " with " << num_threads << " service thread(s) (SO_REUSEPORT, "
+            << asyik::io_backend() << ", "
+            << (engine == asyik::http_parser_engine::simd
+                    ? std::string("simd parser: ") +
+                          asyik::internal::http_scanner::scan_isa()
+                    : std::string("beast parser"))
+            << ")\n";
+
+  // ── Start the service group ──────────────────────────────────────────────
+  // One service per thread, each fully independent: own io_context, own
+  // fiber scheduler, own acceptor on the same port via SO_REUSEPORT.  No
+  // shared variables.  start() returns once every server is listening.
+  asyik::service_group_config group_cfg;
+  group_cfg.services = static_cast<std::size_t>(num_threads);
+  const char* env_pin = std::getenv("ASYIK_PIN");
+  group_cfg.pin = env_pin && std::atoi(env_pin) > 0;
+
+  // servers only hold weak references to themselves: keep them alive here
+  std::vector<asyik::http_server_ptr<asyik::http_stream_type>> servers(
+      num_threads);
+  auto group = asyik::make_service_group(group_cfg);
+  group->start([port, engine, &servers](asyik::service_ptr as,
+                                        std::size_t i) {
+    // reuse_port=true → SO_REUSEPORT; kernel distributes connections
+    servers[i] = asyik::make_http_server(as, "0.0.0.0", port,
+                                         /*reuse_port=*/true);
+    servers[i]->set_parser_engine(engine);
+    register_routes(servers[i]);
+  });
 
   std::cout << "[bench] Ready. Endpoints:\n"
             << "  GET  /plaintext\n"
@@ -173,7 +184,7 @@ int main(int argc, char* argv[])
   });
 #endif
 
-  for (auto& t : threads) t.join();
+  group->join();
 
 #ifdef LIBASYIK_HTTP_PROFILING
   prof_stop.store(true, std::memory_order_relaxed);
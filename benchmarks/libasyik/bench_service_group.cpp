@@ -0,0 +1,180 @@
+/**
+ * libasyik service_group benchmark — pinned vs. unpinned tail latency
+ *
+ * A service_group of N services, each accepting on the same port through
+ * SO_REUSEPORT and echoing 64-byte messages back. Client threads keep one
+ * connection each and measure the round trip of every message. The run is
+ * repeated with the services pinned (and the offload pool moved off their
+ * cores) and unpinned, optionally while async() tasks burn CPU next to them.
+ *
+ * Reports requests/s and the p50 / p99 / p99.9 round-trip latency.
+ *
+ * Usage:
+ *   ./bench_service_group [services] [clients] [seconds] [hogs] [port]
+ *       services  services in the group             (default nCPU)
+ *       clients   client threads, one connection each (default 4)
+ *       seconds   duration of every run              (default 5)
+ *       hogs      CPU-bound async() tasks meanwhile    (default 1)
+ *       port      tcp port                           (default 8098)
+ */
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/ssl/error.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "aixlog.hpp"
+#include "libasyik/error.hpp"
+#include "libasyik/internal/asio_internal.hpp"
+#include "libasyik/service.hpp"
+#include "libasyik/service_group.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct result {
+  double rps;
+  double p50_us, p99_us, p999_us;
+};
+
+// acceptor sharing the port with those of the other services
+std::shared_ptr<tcp::acceptor> listen_reuse_port(asyik::service_ptr as,
+                                                 uint16_t port)
+{
+  auto a = std::make_shared<tcp::acceptor>(as->get_io_service());
+  tcp::endpoint ep(boost::asio::ip::make_address("127.0.0.1"), port);
+  a->open(ep.protocol());
+  a->set_option(tcp::acceptor::reuse_address(true));
+  int one = 1;
+  ::setsockopt(a->native_handle(), SOL_SOCKET, SO_REUSEPORT, &one,
+               sizeof(one));
+  a->bind(ep);
+  a->listen(1024);
+  return a;
+}
+
+result run(bool pin, std::size_t services, int clients, int seconds, int hogs,
+           uint16_t port)
+{
+  asyik::service_group_config cfg;
+  cfg.services = services;
+  cfg.pin = pin;
+  auto group = asyik::make_service_group(cfg);
+
+  std::vector<std::shared_ptr<tcp::acceptor>> acceptors(services);
+  group->start([&](asyik::service_ptr as, std::size_t i) {
+    auto acceptor = acceptors[i] = listen_reuse_port(as, port);
+    as->execute([as, acceptor]() {
+      try {
+        for (;;) {
+          tcp::socket s(as->get_io_service());
+          acceptor->async_accept(s, asyik::use_fiber_future).get();
+          as->execute_detached([s = std::move(s)]() mutable {
+            try {
+              char buf[64];
+              for (;;) {
+                boost::asio::async_read(s, boost::asio::buffer(buf),
+                                        asyik::use_fiber_future)
+                    .get();
+                boost::asio::async_write(s, boost::asio::buffer(buf),
+                                         asyik::use_fiber_future)
+                    .get();
+              }
+            } catch (...) {
+            }
+          });
+        }
+      } catch (...) {
+        // acceptor closed
+      }
+    });
+  });
+
+  std::atomic<bool> hogs_stop{false};
+  std::vector<fibers::future<void>> hog_futures;
+  for (int h = 0; h < hogs; ++h)
+    hog_futures.push_back(group->get_service(0)->async([&hogs_stop]() {
+      while (!hogs_stop.load(std::memory_order_relaxed)) {
+      }
+    }));
+
+  auto deadline = clock_type::now() + std::chrono::seconds(seconds);
+  std::vector<std::vector<uint32_t>> lat(clients);
+  std::vector<std::thread> ths;
+  for (int c = 0; c < clients; ++c)
+    ths.emplace_back([&, c]() {
+      auto& l = lat[c];
+      l.reserve(1 << 20);
+      boost::asio::io_context io;
+      tcp::socket s(io);
+      s.connect(
+          tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), port));
+      s.set_option(tcp::no_delay(true));
+      char buf[64] = {};
+      while (clock_type::now() < deadline) {
+        auto t0 = clock_type::now();
+        boost::asio::write(s, boost::asio::buffer(buf));
+        boost::asio::read(s, boost::asio::buffer(buf));
+        l.push_back(static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock_type::now() - t0)
+                .count()));
+      }
+      s.set_option(boost::asio::socket_base::linger(true, 0));
+      s.close();
+    });
+  for (auto& t : ths) t.join();
+
+  hogs_stop = true;
+  for (auto& f : hog_futures) f.get();
+  for (std::size_t i = 0; i < services; ++i) {
+    auto acceptor = acceptors[i];
+    group->get_service(i)->execute([acceptor]() { acceptor->close(); }).get();
+  }
+  group->stop();
+  group->join();
+
+  std::vector<uint32_t> all;
+  for (auto& l : lat) all.insert(all.end(), l.begin(), l.end());
+  if (all.empty()) return {};
+  std::sort(all.begin(), all.end());
+  auto pct = [&all](double p) {
+    return all[std::min(all.size() - 1, std::size_t(p * all.size()))] / 1e3;
+  };
+  return {all.size() / double(seconds), pct(0.50), pct(0.99), pct(0.999)};
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  std::size_t services =
+      argc > 1 ? std::max(1, std::atoi(argv[1]))
+               : std::max(1u, std::thread::hardware_concurrency());
+  int clients = argc > 2 ? std::max(1, std::atoi(argv[2])) : 4;
+  int seconds = argc > 3 ? std::max(1, std::atoi(argv[3])) : 5;
+  int hogs = argc > 4 ? std::max(0, std::atoi(argv[4])) : 1;
+  uint16_t port = argc > 5 ? static_cast<uint16_t>(std::atoi(argv[5])) : 8098;
+
+  std::printf(
+      "[bench_service_group] %zu services, %d clients, %d s, %d cpu hog(s)\n",
+      services, clients, seconds, hogs);
+  std::printf("  %-8s | %10s | %9s | %9s | %9s\n", "pinned", "req/s",
+              "p50 us", "p99 us", "p99.9 us");
+  std::printf("  ---------+------------+-----------+-----------+----------\n");
+  for (bool pin : {false, true}) {
+    auto r = run(pin, services, clients, seconds, hogs, port);
+    std::printf("  %-8s | %10.0f | %9.1f | %9.1f | %9.1f\n",
+                pin ? "yes" : "no", r.rps, r.p50_us, r.p99_us, r.p999_us);
+  }
+  return 0;
+}
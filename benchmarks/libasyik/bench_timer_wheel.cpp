@@ -0,0 +1,279 @@
+/**
+ * libasyik timer wheel benchmark — a million sleepers and timeouts
+ *
+ * Two tables, each comparing the service timer wheel with what it replaces:
+ *
+ *   timeouts  N callback timers, as for per-connection idle timeouts:
+ *             arm all of them, re-arm all of them (a request came in on
+ *             every connection), then cancel all. asyik::wheel_timer against
+ *             one boost::asio::steady_timer per connection.
+ *
+ *   sleepers  N fibers on one service, each sleeping 0.5 - 1.5 s in a loop,
+ *             as in the /delay/<int> scenario or websocket keep-alives.
+ *             asyik::sleep_for (timer wheel) against
+ *             boost::this_fiber::sleep_for (Boost.Fiber sleep queue).
+ *             Reports wake-ups/s, service thread CPU per wake-up and how
+ *             late the wake-ups came.
+ *
+ * The sleeper fibers get small stacks carved out of one mapping, so a
+ * million of them need about 4 GB of memory; pass a lower count on smaller
+ * machines.
+ *
+ * Usage:
+ *   ./bench_timer_wheel [timeouts] [sleepers] [seconds] [stack_kb]
+ *       timeouts  callback timers                  (default 1000000)
+ *       sleepers  sleeping fibers                   (default 1000000)
+ *       seconds   duration of every sleeper run     (default 5)
+ *       stack_kb  stack size of a sleeper fiber     (default 8)
+ */
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/context/stack_context.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "aixlog.hpp"
+#include "libasyik/service.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+double ns_per(clock_type::time_point t0, std::size_t n)
+{
+  return std::chrono::duration<double, std::nano>(clock_type::now() - t0)
+             .count() /
+         double(n);
+}
+
+struct timeout_result {
+  double arm_ns, rearm_ns, cancel_ns;
+};
+
+timeout_result run_wheel_timeouts(std::size_t n)
+{
+  timeout_result r{};
+  auto as = asyik::make_service();
+  as->execute([&]() {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> ms(1000, 2000);
+    std::vector<asyik::wheel_timer> timers(n);
+    std::size_t fired = 0;
+
+    auto t0 = clock_type::now();
+    for (auto& t : timers)
+      t.arm(std::chrono::milliseconds(ms(rng)), [&fired]() { ++fired; });
+    r.arm_ns = ns_per(t0, n);
+
+    t0 = clock_type::now();
+    for (auto& t : timers)
+      t.arm(std::chrono::milliseconds(ms(rng)), [&fired]() { ++fired; });
+    r.rearm_ns = ns_per(t0, n);
+
+    t0 = clock_type::now();
+    for (auto& t : timers) t.cancel();
+    r.cancel_ns = ns_per(t0, n);
+    as->stop();
+  });
+  as->run();
+  return r;
+}
+
+timeout_result run_asio_timeouts(std::size_t n)
+{
+  timeout_result r{};
+  boost::asio::io_context io;
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> ms(1000, 2000);
+  std::vector<boost::asio::steady_timer> timers;
+  timers.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) timers.emplace_back(io);
+  std::size_t fired = 0;
+  auto handler = [&fired](const boost::system::error_code& ec) {
+    if (!ec) ++fired;
+  };
+
+  auto t0 = clock_type::now();
+  for (auto& t : timers) {
+    t.expires_after(std::chrono::milliseconds(ms(rng)));
+    t.async_wait(handler);
+  }
+  r.arm_ns = ns_per(t0, n);
+
+  // re-arming cancels the pending wait, whose handler still has to run
+  t0 = clock_type::now();
+  for (auto& t : timers) {
+    t.expires_after(std::chrono::milliseconds(ms(rng)));
+    t.async_wait(handler);
+  }
+  io.poll();
+  r.rearm_ns = ns_per(t0, n);
+
+  t0 = clock_type::now();
+  for (auto& t : timers) t.cancel();
+  io.poll();
+  r.cancel_ns = ns_per(t0, n);
+  return r;
+}
+
+// Sleeper stacks, carved out of one mapping without guard pages.
+class slab_stacks {
+ public:
+  slab_stacks(std::size_t count, std::size_t size) : size_(size)
+  {
+    len_ = count * size;
+    base_ = static_cast<char*>(::mmap(nullptr, len_, PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS |
+                                          MAP_NORESERVE,
+                                      -1, 0));
+    if (base_ == MAP_FAILED) throw std::bad_alloc();
+    // a huge page would commit 2MB for every few stacks touched
+    ::madvise(base_, len_, MADV_NOHUGEPAGE);
+  }
+  ~slab_stacks() { ::munmap(base_, len_); }
+
+  struct allocator {
+    slab_stacks* s;
+    boost::context::stack_context allocate()
+    {
+      if (s->next_ + s->size_ > s->len_) throw std::bad_alloc();
+      boost::context::stack_context sc;
+      sc.size = s->size_;
+      s->next_ += s->size_;
+      sc.sp = s->base_ + s->next_;  // stacks grow down
+      return sc;
+    }
+    void deallocate(boost::context::stack_context&) noexcept {}
+  };
+
+ private:
+  char* base_;
+  std::size_t len_, size_, next_ = 0;
+};
+
+struct sleeper_result {
+  double wakeups_per_sec, cpu_ns_per_wakeup, late_p50_us, late_p99_us;
+};
+
+double thread_cpu_ns()
+{
+  rusage ru;
+  ::getrusage(RUSAGE_THREAD, &ru);
+  return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e9 +
+         (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e3;
+}
+
+sleeper_result run_sleepers(bool wheel, std::size_t n, int seconds,
+                            std::size_t stack_size)
+{
+  slab_stacks stacks(n, stack_size);
+  std::atomic<bool> done{false};
+  uint64_t wakeups = 0;
+  // lateness histogram, 1us buckets up to 100ms
+  std::vector<uint64_t> late(100001);
+  sleeper_result r{};
+
+  auto as = asyik::make_service();
+  as->execute([&]() {
+    for (std::size_t i = 0; i < n; ++i) {
+      boost::fibers::fiber(
+          std::allocator_arg, slab_stacks::allocator{&stacks},
+          [&, i]() {
+            std::minstd_rand rng(uint32_t(i + 1));
+            std::uniform_int_distribution<int> ms(500, 1500);
+            while (!done.load(std::memory_order_relaxed)) {
+              auto d = std::chrono::milliseconds(ms(rng));
+              auto deadline = clock_type::now() + d;
+              if (wheel)
+                asyik::sleep_for(d);
+              else
+                boost::this_fiber::sleep_for(d);
+              auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                            clock_type::now() - deadline)
+                            .count();
+              late[std::min<std::size_t>(std::max<long>(us, 0),
+                                         late.size() - 1)]++;
+              ++wakeups;
+            }
+          })
+          .detach();
+    }
+
+    // let the start-up burst pass before measuring
+    asyik::sleep_for(std::chrono::milliseconds(1600));
+    std::fill(late.begin(), late.end(), 0);
+    uint64_t w0 = wakeups;
+    double cpu0 = thread_cpu_ns();
+    auto t0 = clock_type::now();
+    asyik::sleep_for(std::chrono::seconds(seconds));
+    double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+    uint64_t woken = wakeups - w0;
+    r.wakeups_per_sec = woken / secs;
+    r.cpu_ns_per_wakeup =
+        (thread_cpu_ns() - cpu0) / std::max<uint64_t>(woken, 1);
+
+    uint64_t total = 0, seen = 0;
+    for (auto c : late) total += c;
+    for (std::size_t us = 0; us < late.size(); ++us) {
+      if (seen < total / 2 && seen + late[us] >= total / 2)
+        r.late_p50_us = double(us);
+      if (seen < total * 99 / 100 && seen + late[us] >= total * 99 / 100)
+        r.late_p99_us = double(us);
+      seen += late[us];
+    }
+
+    done = true;
+    // every sleeper wakes up once more and leaves
+    asyik::sleep_for(std::chrono::milliseconds(1600));
+    as->stop();
+  });
+  as->run();
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  std::size_t timeouts = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000000;
+  std::size_t sleepers = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000000;
+  int seconds = argc > 3 ? std::max(1, std::atoi(argv[3])) : 5;
+  std::size_t stack_kb = argc > 4 ? std::max(4, std::atoi(argv[4])) : 8;
+
+  std::printf("[bench_timer_wheel] %zu timeouts\n", timeouts);
+  std::printf("  %-12s | %10s | %10s | %10s\n", "timer", "arm ns", "re-arm ns",
+              "cancel ns");
+  std::printf("  -------------+------------+------------+-----------\n");
+  for (bool wheel : {false, true}) {
+    auto r = wheel ? run_wheel_timeouts(timeouts) : run_asio_timeouts(timeouts);
+    std::printf("  %-12s | %10.1f | %10.1f | %10.1f\n",
+                wheel ? "wheel_timer" : "asio timer", r.arm_ns, r.rearm_ns,
+                r.cancel_ns);
+  }
+
+  std::printf(
+      "\n[bench_timer_wheel] %zu sleeping fibers, %d s, %zu KB stacks\n",
+      sleepers, seconds, stack_kb);
+  std::printf("  %-12s | %10s | %10s | %10s | %10s\n", "sleep_for",
+              "wakeups/s", "cpu ns/wk", "late p50us", "late p99us");
+  std::printf(
+      "  -------------+------------+------------+------------+-----------\n");
+  for (bool wheel : {false, true}) {
+    auto r = run_sleepers(wheel, sleepers, seconds, stack_kb * 1024);
+    std::printf("  %-12s | %10.0f | %10.0f | %10.0f | %10.0f\n",
+                wheel ? "timer wheel" : "boost fiber", r.wakeups_per_sec,
+                r.cpu_ns_per_wakeup, r.late_p50_us, r.late_p99_us);
+  }
+  return 0;
+}
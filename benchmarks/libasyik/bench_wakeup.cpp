@@ -0,0 +1,133 @@
+/**
+ * libasyik cross-thread wakeup benchmark
+ *
+ * Every fiber future completed from another thread wakes its fiber through
+ * the scheduler's notify(). Two loads, each in both run modes:
+ *
+ *   promises  F fibers on one service each wait on a fibers::promise that
+ *             P plain threads fulfil; as soon as a fiber is woken it hands
+ *             the next promise out. Only remote wakeups, no worker pool.
+ *
+ *   async     F fibers each loop over as->async(noop).get(): a round trip
+ *             through the async() worker pool and back.
+ *
+ * Reports wake-ups per second and the service thread's CPU time per
+ * wake-up.
+ *
+ * Usage:
+ *   ./bench_wakeup [fibers] [setter_threads] [seconds]
+ *       fibers          waiting fibers on the service   (default 64)
+ *       setter_threads  threads fulfilling the promises (default 2)
+ *       seconds         duration of every run           (default 3)
+ */
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "aixlog.hpp"
+#include "libasyik/service.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+using promise_channel =
+    boost::fibers::buffered_channel<boost::fibers::promise<void>*>;
+
+double thread_cpu_ns()
+{
+  rusage ru;
+  ::getrusage(RUSAGE_THREAD, &ru);
+  return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e9 +
+         (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e3;
+}
+
+struct result {
+  double wakeups_per_sec, cpu_ns_per_wakeup;
+};
+
+result run(asyik::service_run_mode mode, bool async, int fibers, int setters,
+           int seconds)
+{
+  result r{};
+  std::atomic<bool> done{false};
+  long wakeups = 0;
+  promise_channel ch(1024);
+  std::vector<std::thread> threads;
+  if (!async)
+    for (int i = 0; i < setters; ++i)
+      threads.emplace_back([&ch]() {
+        boost::fibers::promise<void>* p;
+        while (ch.pop(p) == boost::fibers::channel_op_status::success)
+          p->set_value();
+      });
+
+  auto as = asyik::make_service();
+  as->set_run_mode(mode);
+  for (int i = 0; i < fibers; ++i)
+    as->execute([&]() {
+      while (!done.load(std::memory_order_relaxed)) {
+        if (async) {
+          as->async([]() {}).get();
+        } else {
+          boost::fibers::promise<void> p;
+          auto f = p.get_future();
+          ch.push(&p);
+          f.get();
+        }
+        ++wakeups;
+      }
+    });
+  as->execute([&]() {
+    asyik::sleep_for(std::chrono::milliseconds(200));  // warm-up
+    long w0 = wakeups;
+    double cpu0 = thread_cpu_ns();
+    auto t0 = clock_type::now();
+    asyik::sleep_for(std::chrono::seconds(seconds));
+    double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+    long woken = wakeups - w0;
+    r.wakeups_per_sec = woken / secs;
+    r.cpu_ns_per_wakeup = (thread_cpu_ns() - cpu0) / std::max(woken, 1L);
+    done = true;
+    asyik::sleep_for(std::chrono::milliseconds(100));
+    as->stop();
+  });
+  as->run();
+  ch.close();
+  for (auto& t : threads) t.join();
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::warning);
+
+  int fibers = argc > 1 ? std::max(1, std::atoi(argv[1])) : 64;
+  int setters = argc > 2 ? std::max(1, std::atoi(argv[2])) : 2;
+  int seconds = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+
+  std::printf("[bench_wakeup] %d fibers, %d setter threads, %d s\n", fibers,
+              setters, seconds);
+  std::printf("  %-8s | %-12s | %12s | %10s\n", "load", "run mode",
+              "wakeups/s", "cpu ns/wk");
+  std::printf("  ---------+--------------+--------------+-----------\n");
+  for (bool async : {false, true})
+    for (auto mode : {asyik::service_run_mode::polling,
+                      asyik::service_run_mode::event_driven}) {
+      auto r = run(mode, async, fibers, setters, seconds);
+      std::printf("  %-8s | %-12s | %12.0f | %10.0f\n",
+                  async ? "async" : "promises",
+                  mode == asyik::service_run_mode::polling ? "polling"
+                                                           : "event_driven",
+                  r.wakeups_per_sec, r.cpu_ns_per_wakeup);
+    }
+  return 0;
+}
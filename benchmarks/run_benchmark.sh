@@ -8,7 +8,9 @@
 #   bash benchmarks/run_benchmark.sh [OPTIONS]
 #
 # Options:
-#   --target=<libasyik|gin|beast|asio|io_uring|asio_iouring|beast_iouring|libasyik_iouring|libasyik_raw|drogon|actix|all>  Which server(s) to benchmark  (default: all)
+#   --target=<libasyik|gin|beast|asio|io_uring|asio_iouring|beast_iouring|libasyik_iouring|libasyik_raw|libasyik_simd|drogon|actix|backends|parsers|all>  Which server(s) to benchmark  (default: all)
+#                                 backends: libasyik on epoll, then on io_uring, and compare
+#                                 parsers:  libasyik with the beast, then the SIMD request parser, and compare
 #   --port=<N>                    Port for libasyik server      (default: 8080)
 #   --gin-port=<N>                Port for GIN server           (default: 8082)
 #   --beast-port=<N>              Port for Beast server         (default: 8086)
@@ -18,6 +20,7 @@
 #   --beast-iouring-port=<N>      Port for Beast+io_uring       (default: 8089)
 #   --libasyik-iouring-port=<N>   Port for libasyik+io_uring    (default: 8090)
 #   --libasyik-raw-port=<N>      Port for libasyik-raw server  (default: 8091)
+#   --libasyik-simd-port=<N>      Port for libasyik, SIMD parser (default: 8092)
 #   --drogon-port=<N>             Port for Drogon server        (default: 8089)#   --actix-port=<N>              Port for Actix server         (default: 8094)#   --duration=<N>                Seconds per wrk run           (default: 20)
 #   --threads=<N>                 wrk worker threads            (default: 4)
 #   --concurrency=<a,b,c,...>     Comma-separated concurrencies (default: 50,100,200,500)
@@ -53,6 +56,7 @@ ASIO_IOURING_PORT=8088
 BEAST_IOURING_PORT=8089
 LIBASYIK_IOURING_PORT=8090
 LIBASYIK_RAW_PORT=4004
+LIBASYIK_SIMD_PORT=8092
 DROGON_PORT=8093
 ACTIX_PORT=8094
 DURATION=20
@@ -76,6 +80,7 @@ for arg in "$@"; do
         --beast-iouring-port=*) BEAST_IOURING_PORT="${arg#*=}" ;;
         --libasyik-iouring-port=*) LIBASYIK_IOURING_PORT="${arg#*=}" ;;
         --libasyik-raw-port=*) LIBASYIK_RAW_PORT="${arg#*=}" ;;
+        --libasyik-simd-port=*) LIBASYIK_SIMD_PORT="${arg#*=}" ;;
         --drogon-port=*)      DROGON_PORT="${arg#*=}" ;;
         --actix-port=*)       ACTIX_PORT="${arg#*=}" ;;
         --duration=*)         DURATION="${arg#*=}" ;;
@@ -113,7 +118,7 @@ export PATH="${GO_BIN}:${PATH}"
 # ── Pre-flight checks ──────────────────────────────────────────────────────────
 command -v wrk &>/dev/null || die "wrk not found. Run: bash benchmarks/setup.sh"
 
-if [[ "${TARGET}" == "libasyik" || "${TARGET}" == "all" ]]; then
+if [[ "${TARGET}" == "libasyik" || "${TARGET}" == "libasyik_simd" || "${TARGET}" == "backends" || "${TARGET}" == "parsers" || "${TARGET}" == "all" ]]; then
     [[ -x "${LIBASYIK_BIN}" ]] || \
         die "bench_server not found at ${LIBASYIK_BIN}. Run: bash benchmarks/setup.sh"
 fi
@@ -141,7 +146,7 @@ if [[ "${TARGET}" == "beast_iouring" || "${TARGET}" == "all" ]]; then
     [[ -x "${BEAST_IOURING_BIN}" ]] || \
         die "bench_beast_iouring not found at ${BEAST_IOURING_BIN}. Run: bash benchmarks/setup.sh"
 fi
-if [[ "${TARGET}" == "libasyik_iouring" || "${TARGET}" == "all" ]]; then
+if [[ "${TARGET}" == "libasyik_iouring" || "${TARGET}" == "backends" || "${TARGET}" == "all" ]]; then
     [[ -x "${LIBASYIK_IOURING_BIN}" ]] || \
         die "bench_server_iouring not found at ${LIBASYIK_IOURING_BIN}. Run: bash benchmarks/setup.sh"
 fi
@@ -219,6 +224,33 @@ parse_wrk() {
     echo "${rps:-N/A} | ${p50:-N/A} | ${p99:-N/A}"
 }
 
+# ── Utility: compare two summaries row by row ─────────────────────────────────
+# Both runs must have used the same scenarios and concurrency levels; prints
+# the RPS of each, the change from the first to the second, and both p99s.
+compare_summaries() {
+    local first="$1" second="$2" name1="$3" name2="$4"
+    if [[ ! -f "${first}" || ! -f "${second}" ]]; then
+        echo "(no data)"
+        return 0
+    fi
+    printf "%-22s | %-6s | %-12s | %-12s | %-8s | %-12s | %-12s\n" \
+        "Scenario" "Conc" "${name1} RPS" "${name2} RPS" "change" \
+        "${name1} p99" "${name2} p99"
+    printf -- "%-22s-+-%-6s-+-%-12s-+-%-12s-+-%-8s-+-%-12s-+-%-12s\n" \
+        "----------------------" "------" "------------" "------------" \
+        "--------" "------------" "------------"
+    paste -d'|' <(tail -n +3 "${first}") <(tail -n +3 "${second}") | \
+        awk -F'|' '
+        function trim(s) { gsub(/^[ \t]+|[ \t]+$/, "", s); return s }
+        {
+            a = trim($3); b = trim($8)
+            change = (a + 0 > 0 && b + 0 > 0) \
+                ? sprintf("%+.1f%%", (b - a) * 100.0 / a) : "N/A"
+            printf "%-22s | %-6s | %-12s | %-12s | %-8s | %-12s | %-12s\n", \
+                trim($1), trim($2), a, b, change, trim($5), trim($10)
+        }'
+}
+
 # ── Utility: run wrk for one (scenario, concurrency) pair ─────────────────────
 run_wrk() {
     local label="$1"     # human label, also used as filename prefix
@@ -268,6 +300,16 @@ run_all_scenarios() {
         sleep 1
     done
 
+    # ── A2: Plaintext, pipelined ─────────────────────────────────────────────
+    header "── [${framework}] Scenario A2: GET /plaintext (16 requests pipelined) ──"
+    for c in "${CONCS[@]}"; do
+        run_wrk "${label_prefix}_A2_pipelined" "${base_url}/plaintext" "${c}" \
+            "-s ${SCRIPTS_DIR}/pipeline.lua"
+        append_summary "A2: plaintext-pipelined" "${c}" \
+            "${OUTPUT_DIR}/${label_prefix}_A2_pipelined_c${c}.txt"
+        sleep 1
+    done
+
     # ── B: JSON ───────────────────────────────────────────────────────────────
     header "── [${framework}] Scenario B: GET /json (JSON response) ──"
     for c in "${CONCS[@]}"; do
@@ -334,6 +376,27 @@ bench_libasyik() {
     trap - EXIT
 }
 
+# ── Benchmark runner for libasyik with the SIMD request parser ────────────────
+bench_libasyik_simd() {
+    header "══════════════════════════════════════════════════════════"
+    header "  TARGET: libasyik + SIMD parser  (port ${LIBASYIK_SIMD_PORT})"
+    header "  (same server, http_parser_engine::simd instead of beast)"
+    header "══════════════════════════════════════════════════════════"
+
+    pkill -9 bench_server 2>/dev/null || true; sleep 1
+
+    ASYIK_PARSER=simd ASYIK_THREAD_MULTIPLIER="${THREAD_MULTIPLIER}" "${LIBASYIK_BIN}" "${LIBASYIK_SIMD_PORT}" \
+        >"${OUTPUT_DIR}/libasyik_simd_server.log" 2>&1 &
+    SERVER_PID=$!
+    trap "stop_server ${SERVER_PID}" EXIT
+
+    wait_for_server "${LIBASYIK_SIMD_PORT}"
+    run_all_scenarios "libasyik+simd" "${LIBASYIK_SIMD_PORT}" "libasyik_simd"
+
+    stop_server "${SERVER_PID}"
+    trap - EXIT
+}
+
 # ── Benchmark runner for Boost.Beast (direct, no libasyik) ───────────────────
 bench_beast() {
     header "══════════════════════════════════════════════════════════"
@@ -553,6 +616,7 @@ echo "  Port (Asio+iou):    ${ASIO_IOURING_PORT}"
 echo "  Port (Beast+iou):   ${BEAST_IOURING_PORT}"
 echo "  Port (libasyik+iou):${LIBASYIK_IOURING_PORT}"
 echo "  Port (libasyik-raw):${LIBASYIK_RAW_PORT}"
+echo "  Port (libasyik-simd):${LIBASYIK_SIMD_PORT}"
 echo "  Port (Drogon):      ${DROGON_PORT}"
 echo "  Port (Actix):       ${ACTIX_PORT}"
 echo "  Duration per run:   ${DURATION}s"
@@ -591,6 +655,33 @@ case "${TARGET}" in
     libasyik_raw)
         bench_libasyik_raw
         ;;
+    libasyik_simd)
+        bench_libasyik_simd
+        ;;
+    parsers)
+        # Same server binary, request heads parsed by beast, then by the
+        # SIMD scanner
+        bench_libasyik
+        echo ""
+        bench_libasyik_simd
+        header "══ PARSER COMPARISON: beast vs SIMD ══"
+        echo ""
+        compare_summaries "${OUTPUT_DIR}/libasyik_summary.txt" \
+            "${OUTPUT_DIR}/libasyik_simd_summary.txt" "beast" "simd" \
+            | tee "${OUTPUT_DIR}/parsers_comparison.txt"
+        ;;
+    backends)
+        # Same server code and endpoints, built once per reactor
+        bench_libasyik
+        wait_for_port_free "${PORT}"
+        echo ""
+        bench_libasyik_iouring
+        header "══ BACKEND COMPARISON: epoll vs io_uring ══"
+        echo ""
+        compare_summaries "${OUTPUT_DIR}/libasyik_summary.txt" \
+            "${OUTPUT_DIR}/libasyik_iouring_summary.txt" "epoll" "io_uring" \
+            | tee "${OUTPUT_DIR}/backends_comparison.txt"
+        ;;
     drogon)
         bench_drogon
         ;;
@@ -616,6 +707,8 @@ case "${TARGET}" in
         echo ""
         bench_libasyik_raw
         echo ""
+        bench_libasyik_simd
+        echo ""
         bench_drogon        echo ""
         bench_actix        # ── Side-by-side comparison ───────────────────────────────────────
         header "══ COMPARISON SUMMARY ══"
@@ -644,9 +737,17 @@ case "${TARGET}" in
         echo -e "${BOLD}libasyik + io_uring backend${NC}"
         cat "${OUTPUT_DIR}/libasyik_iouring_summary.txt" 2>/dev/null || echo "(no data)"
         echo ""
+        echo -e "${BOLD}libasyik: epoll vs io_uring${NC}"
+        compare_summaries "${OUTPUT_DIR}/libasyik_summary.txt" \
+            "${OUTPUT_DIR}/libasyik_iouring_summary.txt" "epoll" "io_uring"
+        echo ""
         echo -e "${BOLD}libasyik-raw (fibers + raw Asio TCP, no Beast)${NC}"
         cat "${OUTPUT_DIR}/libasyik_raw_summary.txt" 2>/dev/null || echo "(no data)"
         echo ""
+        echo -e "${BOLD}libasyik: beast vs SIMD request parser${NC}"
+        compare_summaries "${OUTPUT_DIR}/libasyik_summary.txt" \
+            "${OUTPUT_DIR}/libasyik_simd_summary.txt" "beast" "simd"
+        echo ""
         echo -e "${BOLD}Drogon${NC}"
         cat "${OUTPUT_DIR}/drogon_summary.txt" 2>/dev/null || echo "(no data)"
         echo ""
@@ -654,7 +755,7 @@ case "${TARGET}" in
         cat "${OUTPUT_DIR}/actix_summary.txt" 2>/dev/null || echo "(no data)"
         ;;
     *)
-        die "Unknown target '${TARGET}'. Use: libasyik | gin | beast | asio | io_uring | asio_iouring | beast_iouring | libasyik_iouring | libasyik_raw | drogon | actix | all"
+        die "Unknown target '${TARGET}'. Use: libasyik | gin | beast | asio | io_uring | asio_iouring | beast_iouring | libasyik_iouring | libasyik_raw | libasyik_simd | drogon | actix | backends | parsers | all"
         ;;
 esac
 
@@ -0,0 +1,19 @@
+-- pipeline.lua
+-- wrk script for Scenario A2: pipelined GET /plaintext
+-- Writes `depth` requests back to back on every connection before reading
+-- the responses (default 16, the TechEmpower plaintext setting).
+--
+-- Usage: wrk -t4 -c100 -d20s --latency -s pipeline.lua http://HOST/plaintext -- 16
+
+init = function(args)
+    local depth = tonumber(args[1]) or 16
+    local r = {}
+    for i = 1, depth do
+        r[i] = wrk.format()
+    end
+    req = table.concat(r)
+end
+
+request = function()
+    return req
+end
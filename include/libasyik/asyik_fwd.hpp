@@ -30,6 +30,8 @@ template <typename StreamType>
 using http_server_wptr = std::weak_ptr<http_server<StreamType>>;
 
 class http_request;
+class http_request_view;
+class http_response_template;
 using http_request_ptr = std::shared_ptr<http_request>;
 using http_request_wptr = std::weak_ptr<http_request>;
 using http_result = uint16_t;
@@ -1,22 +1,107 @@
 #ifndef LIBASYIK_ASYIK_ROUND_ROBIN_HPP
 #define LIBASYIK_ASYIK_ROUND_ROBIN_HPP
 
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <atomic>
+#include <boost/asio/buffer.hpp>
 #include <boost/asio/error.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
 #include <boost/assert.hpp>
 #include <boost/fiber/algo/algorithm.hpp>
 #include <boost/fiber/context.hpp>
+#include <boost/fiber/properties.hpp>
 #include <boost/fiber/scheduler.hpp>
 #include <boost/fiber/type.hpp>
 #include <boost/system/system_error.hpp>
+#include <cerrno>
 #include <chrono>
-#include <condition_variable>
-#include <mutex>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
 
+#include "common.hpp"
 #include "error.hpp"
+#include "internal/timer_wheel.hpp"
 
 namespace asyik {
 
+/// Scheduling class of a fiber, see service::execute(fiber_priority, ...).
+/// A runnable fiber of a higher class always runs before one of a lower
+/// class; within a class fibers run round-robin.
+enum class fiber_priority { high = 0, normal = 1, low = 2 };
+
+// Attached to the context of a fiber that is not in the normal class or
+// carries a label.
+class fiber_props : public boost::fibers::fiber_properties {
+ public:
+  explicit fiber_props(boost::fibers::context* ctx) noexcept
+      : fiber_properties(ctx)
+  {
+  }
+
+  fiber_priority priority = fiber_priority::normal;
+  // names the fiber in watchdog reports, see fiber_label
+  string_view label;
+};
+
+// A fiber that ran longer than the watchdog budget without yielding.
+struct slow_slice {
+  boost::fibers::context::id fiber;
+  // fiber_label in effect, empty if none; only valid during the callback
+  string_view label;
+  std::chrono::nanoseconds duration;
+};
+
+// Scheduler counters of one thread. Only that thread writes them (relaxed
+// load + store, no locked instructions), any thread may read them.
+struct scheduler_counters {
+  // ready_depth buckets: 0, 1, 2-3, 4-7, ... , 512-1023, 1024 and more
+  static constexpr std::size_t depth_buckets = 12;
+
+  std::atomic<uint64_t> context_switches{0};
+  std::atomic<uint64_t> ready_depth[depth_buckets]{};
+  std::atomic<uint64_t> suspend_ns{0};
+  // only while timing is on: one clock read per context switch
+  std::atomic<bool> timing{false};
+  std::atomic<uint64_t> fiber_run_ns{0};
+  // written by service::run() on the same thread
+  std::atomic<uint64_t> io_poll_ns{0};       // timing only
+  std::atomic<uint64_t> reactor_wait_ns{0};  // event_driven run mode
+  std::atomic<uint64_t> busy_polls{0};       // busy_poll run mode
+  std::atomic<uint64_t> busy_polls_empty{0};
+  // watchdog: fiber slices longer than the budget (0 = off), which also
+  // costs one clock read per context switch
+  std::atomic<uint64_t> watchdog_budget_ns{0};
+  std::atomic<uint64_t> slow_slices{0};
+  std::atomic<uint64_t> slow_slice_ns{0};
+  std::atomic<uint64_t> slow_slice_max_ns{0};
+  // LIFO wake slot: fibers run straight from the slot, and fibers moved
+  // from it to the back of their queue
+  std::atomic<uint64_t> lifo_handoffs{0};
+  std::atomic<uint64_t> lifo_demotions{0};
+
+  static void add(std::atomic<uint64_t>& c, uint64_t n) noexcept
+  {
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  static std::size_t depth_bucket(std::size_t depth) noexcept
+  {
+    std::size_t b = 0;
+    while (depth && b < depth_buckets - 1) {
+      depth >>= 1;
+      ++b;
+    }
+    return b;
+  }
+};
+
 // Custom round-robin fiber scheduler with cooperative stop/interrupt support.
 //
 // When request_stop() is called, a thread-local "stopped" flag is set.
@@ -31,16 +116,91 @@ namespace asyik {
 //
 // Only worker fibers are interrupted; main_context and dispatcher_context are
 // left alone so the service run-loop can drain gracefully.
+//
+// Reactor integration (service_run_mode::event_driven):
+//  The service run-loop parks itself with park_until_idle(). The scheduler
+//  hands it back either once per scheduling round (so I/O is still polled
+//  while other fibers are busy), or from suspend_until() when nothing else is
+//  runnable, together with the earliest sleeping-fiber deadline. The run-loop
+//  then blocks inside the io_context until that deadline, a socket/timer
+//  event, or a cross-thread notify().
+//
+// Cross-thread wakeups: notify() writes to a per-scheduler eventfd, without
+// taking a lock. Notifications coalesce: only the first one after the
+// scheduler last woke up writes, later ones only find the flag set. Outside
+// the reactor, suspend_until() waits on the eventfd with ppoll(); with a
+// reactor attached, the eventfd is read through it, so a wakeup ends
+// io_context::run_one_until() like any socket event.
+//
+// Priority classes: one ready queue per fiber_priority, and pick_next()
+// takes the front of the highest non-empty one. A fiber's class lives in
+// its fiber_props; fibers without are normal, so a thread that
+// never sets a priority schedules exactly FIFO.
+//
+// Instrumentation: every pick_next() counts a context switch and samples the
+// ready-queue depth into a histogram; time blocked in suspend_until() is
+// summed up. With timing enabled it also sums the time worker fibers run.
+// The counters are shared, so they stay readable after the thread exits.
+//
+// Watchdog: with a budget set, pick_next() also times the slice of the
+// worker fiber switching away, and counts and reports the slices over the
+// budget: a handler that blocked the thread or looped without yielding.
+//
+// LIFO wake slot (off by default): a fiber woken or launched on this thread
+// by a worker fiber or by an I/O handler of the run-loop goes into a single
+// slot instead of the tail of its queue, and runs next, while the data it
+// was woken for is still in cache. A second wakeup moves the previous
+// occupant to the tail. Starvation is bounded: after lifo_max_streak picks
+// in a row from the slot, the occupant is moved to the tail too and the
+// queue gets a turn. Yields, cross-thread and timer wakeups keep the FIFO
+// order, and the slot never runs ahead of a higher class.
+//
+// Timer wheel: sleep_until() parks the fiber on a per-thread timer_wheel
+// instead of the Boost.Fiber sleep queue, and add_timer() arms callbacks on
+// it. Due timers fire once per scheduling round and whenever nothing is
+// runnable; suspend_until() wakes up for the next one.
 class asyik_round_robin : public boost::fibers::algo::algorithm {
  private:
   using rqueue_type = boost::fibers::scheduler::ready_queue_type;
 
-  rqueue_type rqueue_{};
-  std::mutex mtx_{};
-  std::condition_variable cnd_{};
-  bool flag_{false};
+  static constexpr std::size_t priority_classes = 3;
+  rqueue_type rqueues_[priority_classes]{};
+  fiber_priority launch_priority_{fiber_priority::normal};
   std::atomic<bool> stopped_{false};
 
+  // cross-thread wakeups, see notify()
+  int wakeup_fd_{-1};
+  std::atomic<bool> wakeup_pending_{false};
+
+  // reactor integration, see park_until_idle()
+  std::unique_ptr<boost::asio::posix::stream_descriptor> reactor_wakeup_{};
+  uint64_t reactor_wakeup_buf_{0};
+  unsigned reactor_generation_{0};
+  boost::fibers::context* parked_{nullptr};
+  std::chrono::steady_clock::time_point park_deadline_{};
+
+  std::shared_ptr<scheduler_counters> counters_{
+      std::make_shared<scheduler_counters>()};
+  std::size_t ready_count_{0};
+  std::chrono::steady_clock::time_point switched_at_{};
+
+  // see urgent_wakeup()
+  std::shared_ptr<std::atomic<bool>> urgent_{
+      std::make_shared<std::atomic<bool>>(false)};
+  boost::fibers::context* dispatcher_{nullptr};
+
+  std::function<void(const slow_slice&)> on_slow_slice_{};
+
+  internal::timer_wheel timers_{};
+  bool expiring_timers_{false};
+
+  // see set_lifo_slot()
+  static constexpr unsigned lifo_max_streak = 3;
+  bool lifo_enabled_{false};
+  boost::fibers::context* lifo_{nullptr};
+  unsigned lifo_streak_{0};
+  boost::fibers::context* yielding_{nullptr};
+
   // Thread-local pointer to the scheduler instance for this thread.
   // Uses static-local trick to avoid requiring a .cpp definition file.
   static asyik_round_robin*& instance_ref_() noexcept
@@ -50,7 +210,20 @@ class asyik_round_robin : public boost::fibers::algo::algorithm {
   }
 
  public:
-  asyik_round_robin() { instance_ref_() = this; }
+  asyik_round_robin() : wakeup_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+  {
+    if (wakeup_fd_ < 0)
+      throw boost::system::system_error(
+          errno, boost::system::system_category(), "eventfd");
+    instance_ref_() = this;
+  }
+
+  ~asyik_round_robin() override
+  {
+    // the run-loop detaches the reactor before it goes away
+    if (reactor_wakeup_) reactor_wakeup_->release();
+    ::close(wakeup_fd_);
+  }
 
   asyik_round_robin(const asyik_round_robin&) = delete;
   asyik_round_robin& operator=(const asyik_round_robin&) = delete;
@@ -60,44 +233,283 @@ class asyik_round_robin : public boost::fibers::algo::algorithm {
     BOOST_ASSERT(nullptr != ctx);
     BOOST_ASSERT(!ctx->ready_is_linked());
     BOOST_ASSERT(ctx->is_resumable());
-    ctx->ready_link(rqueue_);
+    if (launch_priority_ != fiber_priority::normal) {
+      // a fiber being launched, see set_launch_priority()
+      set_priority(ctx, launch_priority_);
+      launch_priority_ = fiber_priority::normal;
+    }
+    if (ctx->is_context(boost::fibers::type::dispatcher_context)) {
+      // requeued right after it moved the remote wakeups into the queues,
+      // once per round
+      dispatcher_ = ctx;
+      urgent_->store(false, std::memory_order_relaxed);
+      expire_timers_();
+    }
+    ++ready_count_;
+    if (lifo_enabled_ && lifo_wakeup_(ctx)) {
+      if (lifo_) demote_lifo_();
+      lifo_ = ctx;
+      return;
+    }
+    ctx->ready_link(rqueues_[class_of_(ctx)]);
   }
 
   boost::fibers::context* pick_next() noexcept override
   {
+    auto& c = *counters_;
+    scheduler_counters::add(
+        c.ready_depth[scheduler_counters::depth_bucket(ready_count_)], 1);
+    // called on the context that is about to be switched away from
+    if (!end_slice_()) {
+      // a slice is only measured from a switch that read the clock
+      switched_at_ = {};
+    }
+
     boost::fibers::context* victim = nullptr;
-    if (!rqueue_.empty()) {
-      victim = &rqueue_.front();
-      rqueue_.pop_front();
+    if (lifo_enabled_) {
+      // A yielding fiber is requeued only after the switch, from the context
+      // that replaced it. Fibers that block sit in a wait queue by now.
+      auto* self = boost::fibers::context::active();
+      bool yields = self &&
+                    self->is_context(boost::fibers::type::worker_context) &&
+                    !self->wait_is_linked();
+      yielding_ = yields ? self : nullptr;
+    }
+    if (!ready_count_) expire_timers_();
+    if (lifo_ && lifo_streak_ == lifo_max_streak) demote_lifo_();
+    rqueue_type* q = rqueues_;
+    while (q != rqueues_ + priority_classes && q->empty()) ++q;
+    if (dispatcher_ && dispatcher_->ready_is_linked() &&
+        urgent_->load(std::memory_order_relaxed)) {
+      // an urgent wakeup from another thread waits in the remote queue,
+      // which only the dispatcher drains
+      victim = dispatcher_;
+      victim->ready_unlink();
+    } else if (lifo_ && rqueues_ + class_of_(lifo_) <= q) {
+      victim = lifo_;
+      lifo_ = nullptr;
+      ++lifo_streak_;
+      scheduler_counters::add(c.lifo_handoffs, 1);
+    } else if (q != rqueues_ + priority_classes) {
+      victim = &q->front();
+      q->pop_front();
+      lifo_streak_ = 0;
+    }
+    if (victim) {
+      --ready_count_;
+      scheduler_counters::add(c.context_switches, 1);
       BOOST_ASSERT(nullptr != victim);
       BOOST_ASSERT(!victim->ready_is_linked());
       BOOST_ASSERT(victim->is_resumable());
+
+      // The dispatcher comes around once per scheduling round; if other
+      // fibers are still runnable, give the parked run-loop a turn so it can
+      // poll the reactor without blocking.
+      if (parked_ && ready_count_ &&
+          victim->is_context(boost::fibers::type::dispatcher_context))
+        unpark_((std::chrono::steady_clock::time_point::min)());
     }
     return victim;
   }
 
-  bool has_ready_fibers() const noexcept override { return !rqueue_.empty(); }
+  bool has_ready_fibers() const noexcept override { return ready_count_ > 0; }
+
+  // Ready fibers other than the dispatcher, which requeues itself every
+  // round even when it has nothing to hand over.
+  bool has_ready_workers() const noexcept
+  {
+    return ready_count_ > (dispatcher_ && dispatcher_->ready_is_linked());
+  }
 
   void suspend_until(
-      std::chrono::steady_clock::time_point const& time_point) noexcept override
+      std::chrono::steady_clock::time_point const& earliest) noexcept override
   {
+    auto time_point = (std::min)(earliest, timers_.next_expiry());
+    if (parked_) {
+      // nothing else is runnable: let the run-loop block in the reactor
+      unpark_(time_point);
+      return;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    pollfd p{wakeup_fd_, POLLIN, 0};
     if ((std::chrono::steady_clock::time_point::max)() == time_point) {
-      std::unique_lock<std::mutex> lk{mtx_};
-      cnd_.wait(lk, [&]() { return flag_; });
-      flag_ = false;
-    } else {
-      std::unique_lock<std::mutex> lk{mtx_};
-      cnd_.wait_until(lk, time_point, [&]() { return flag_; });
-      flag_ = false;
+      ::ppoll(&p, 1, nullptr, nullptr);
+    } else if (time_point > t0) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    time_point - t0)
+                    .count();
+      timespec ts{time_t(ns / 1000000000), long(ns % 1000000000)};
+      ::ppoll(&p, 1, &ts, nullptr);
+    }
+    if (p.revents & POLLIN) {
+      uint64_t n;
+      ssize_t r = ::read(wakeup_fd_, &n, sizeof(n));
+      (void)r;
+      wakeup_pending_.store(false, std::memory_order_release);
     }
+    auto t1 = std::chrono::steady_clock::now();
+    scheduler_counters::add(
+        counters_->suspend_ns,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    switched_at_ = t1;
   }
 
   void notify() noexcept override
   {
-    std::unique_lock<std::mutex> lk{mtx_};
-    flag_ = true;
-    lk.unlock();
-    cnd_.notify_all();
+    // Whoever clears the flag drains the remote queue afterwards, under the
+    // same lock the caller pushed to it with: a set flag means a wakeup is
+    // still on its way and this one can be dropped.
+    if (wakeup_pending_.load(std::memory_order_relaxed) ||
+        wakeup_pending_.exchange(true, std::memory_order_acq_rel))
+      return;
+    uint64_t one = 1;
+    ssize_t r = ::write(wakeup_fd_, &one, sizeof(one));
+    (void)r;
+  }
+
+  // ---- Reactor integration ----
+
+  // Route cross-thread wakeups into @p io (nullptr to detach). Must be called
+  // from the thread owning this scheduler, and @p io must stay alive until
+  // detached.
+  void attach_reactor(boost::asio::io_context* io)
+  {
+    ++reactor_generation_;
+    if (reactor_wakeup_) {
+      // cancels the pending read; the eventfd stays open
+      reactor_wakeup_->release();
+      reactor_wakeup_.reset();
+    }
+    if (!io) return;
+    reactor_wakeup_.reset(
+        new boost::asio::posix::stream_descriptor(*io, wakeup_fd_));
+    read_reactor_wakeup_();
+  }
+
+  // Suspend the calling fiber until the scheduler has run every other ready
+  // fiber once. Returns the deadline the caller may block the thread until
+  // (earliest sleeping fiber, max() if none), or min() if other fibers are
+  // still runnable and the caller should only poll.
+  std::chrono::steady_clock::time_point park_until_idle() noexcept
+  {
+    auto* ctx = boost::fibers::context::active();
+    BOOST_ASSERT(nullptr == parked_);
+    parked_ = ctx;
+    ctx->suspend();
+    return park_deadline_;
+  }
+
+  // ---- Timer wheel ----
+
+  // Wheel resolution (default 1ms); only while no timer is pending.
+  void set_timer_resolution(std::chrono::steady_clock::duration d) noexcept
+  {
+    timers_.set_resolution(d);
+  }
+  std::chrono::steady_clock::duration timer_resolution() const noexcept
+  {
+    return timers_.resolution();
+  }
+
+  // Suspends the running fiber until @p deadline, rounded up to the wheel
+  // resolution, or until request_stop().
+  void sleep_until(std::chrono::steady_clock::time_point deadline) noexcept
+  {
+    struct sleeper : internal::timer_wheel_node {
+      asyik_round_robin* sched;
+      boost::fibers::context* ctx;
+    } s;
+    s.sched = this;
+    s.ctx = boost::fibers::context::active();
+    s.on_expiry = [](internal::timer_wheel_node* n) noexcept {
+      auto* self = static_cast<sleeper*>(n);
+      self->sched->awakened(self->ctx);
+    };
+    timers_.add(&s, deadline);
+    s.ctx->suspend();
+  }
+
+  // Arms @p n, whose on_expiry then runs inside the scheduler on this
+  // thread: it must neither block nor suspend. Both only from this thread.
+  void add_timer(internal::timer_wheel_node* n,
+                 std::chrono::steady_clock::time_point deadline) noexcept
+  {
+    timers_.add(n, deadline);
+  }
+  void cancel_timer(internal::timer_wheel_node* n) noexcept
+  {
+    timers_.remove(n);
+  }
+
+  // ---- Priority classes ----
+
+  // Moves @p ctx into class @p p. The fiber must not be in the ready queue:
+  // call this for the running fiber, or for a suspended one before waking
+  // it up.
+  static void set_priority(boost::fibers::context* ctx,
+                           fiber_priority p) noexcept
+  {
+    if (auto* props = props_of_(ctx, p != fiber_priority::normal))
+      props->priority = p;
+  }
+
+  // The next fiber to become ready is one being launched on this thread and
+  // gets class @p p:
+  //   sched->set_launch_priority(p);
+  //   boost::fibers::fiber f(...);
+  void set_launch_priority(fiber_priority p) noexcept { launch_priority_ = p; }
+
+  // Turns the LIFO wake slot on or off (default off). Only from this thread.
+  void set_lifo_slot(bool on) noexcept
+  {
+    if (!on && lifo_) demote_lifo_();
+    lifo_enabled_ = on;
+  }
+  bool lifo_slot() const noexcept { return lifo_enabled_; }
+
+  // Flag another thread sets after it woke up a high priority fiber of this
+  // one, so that the wakeup is picked up before the ready fibers run rather
+  // than after a full round. Shared, so setting it stays safe while this
+  // thread exits.
+  std::shared_ptr<std::atomic<bool>> urgent_wakeup() const noexcept
+  {
+    return urgent_;
+  }
+
+  // ---- Instrumentation ----
+
+  std::shared_ptr<scheduler_counters> counters() const noexcept
+  {
+    return counters_;
+  }
+
+  // Called with every slice over the watchdog budget, on this thread and
+  // from inside the scheduler: @p f must neither block nor suspend.
+  void on_slow_slice(std::function<void(const slow_slice&)> f)
+  {
+    on_slow_slice_ = std::move(f);
+  }
+
+  // Ends the slice of the running fiber here, as if it switched away and
+  // back, e.g. before a fiber_label goes out of scope.
+  void checkpoint() noexcept { end_slice_(); }
+
+  bool watchdog_enabled() const noexcept
+  {
+    return counters_->watchdog_budget_ns.load(std::memory_order_relaxed) != 0;
+  }
+
+  static string_view label(boost::fibers::context* ctx) noexcept
+  {
+    auto* props = static_cast<fiber_props*>(ctx->get_properties());
+    return props ? props->label : string_view{};
+  }
+
+  // Names @p ctx in watchdog reports; @p label must outlive the name.
+  static void set_label(boost::fibers::context* ctx, string_view label) noexcept
+  {
+    if (auto* props = props_of_(ctx, !label.empty())) props->label = label;
   }
 
   // ---- Stop / interrupt mechanism ----
@@ -132,6 +544,118 @@ class asyik_round_robin : public boost::fibers::algo::algorithm {
       }
     }
   }
+
+ private:
+  // Properties of @p ctx, attached first if @p create; nullptr without.
+  static fiber_props* props_of_(boost::fibers::context* ctx,
+                                bool create) noexcept
+  {
+    auto* props = static_cast<fiber_props*>(ctx->get_properties());
+    if (!props && create) {
+      // owned and deleted by the context; without memory the fiber keeps
+      // the defaults
+      props = new (std::nothrow) fiber_props(ctx);
+      if (props) ctx->set_properties(props);
+    }
+    return props;
+  }
+
+  // Times the slice of the active fiber if timing or the watchdog is on
+  // and starts the next one; false if both are off.
+  bool end_slice_() noexcept
+  {
+    auto& c = *counters_;
+    bool timing = c.timing.load(std::memory_order_relaxed);
+    uint64_t budget = c.watchdog_budget_ns.load(std::memory_order_relaxed);
+    if (!timing && !budget) return false;
+    auto now = std::chrono::steady_clock::now();
+    auto* self = boost::fibers::context::active();
+    if (self && self->is_context(boost::fibers::type::worker_context) &&
+        switched_at_.time_since_epoch().count()) {
+      uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        now - switched_at_)
+                        .count();
+      if (timing) scheduler_counters::add(c.fiber_run_ns, ns);
+      if (budget && ns > budget) report_slow_slice_(self, ns);
+    }
+    switched_at_ = now;
+    return true;
+  }
+
+  void expire_timers_() noexcept
+  {
+    if (timers_.empty()) return;
+    expiring_timers_ = true;
+    if (stopped_.load(std::memory_order_relaxed))
+      timers_.expire_all();  // sleepers unwind through check_interrupt()
+    else
+      timers_.advance(std::chrono::steady_clock::now());
+    expiring_timers_ = false;
+  }
+
+  // Whether waking @p ctx may use the LIFO slot: a worker fiber woken by
+  // another worker fiber or the run-loop, not a yield, a cross-thread
+  // wakeup (handed over by the dispatcher) or a timer.
+  bool lifo_wakeup_(boost::fibers::context* ctx) const noexcept
+  {
+    auto* active = boost::fibers::context::active();
+    return !expiring_timers_ && ctx != yielding_ && ctx != active &&
+           ctx->is_context(boost::fibers::type::worker_context) &&
+           !active->is_context(boost::fibers::type::dispatcher_context);
+  }
+
+  // Moves the occupant of the LIFO slot to the tail of its queue.
+  void demote_lifo_() noexcept
+  {
+    lifo_->ready_link(rqueues_[class_of_(lifo_)]);
+    lifo_ = nullptr;
+    scheduler_counters::add(counters_->lifo_demotions, 1);
+  }
+
+  void report_slow_slice_(boost::fibers::context* ctx, uint64_t ns) noexcept
+  {
+    auto& c = *counters_;
+    scheduler_counters::add(c.slow_slices, 1);
+    scheduler_counters::add(c.slow_slice_ns, ns);
+    if (ns > c.slow_slice_max_ns.load(std::memory_order_relaxed))
+      c.slow_slice_max_ns.store(ns, std::memory_order_relaxed);
+    if (!on_slow_slice_) return;
+    try {
+      on_slow_slice_(
+          slow_slice{ctx->get_id(), label(ctx), std::chrono::nanoseconds(ns)});
+    } catch (...) {
+      // a reporting failure must not take the scheduler down
+    }
+  }
+
+  static std::size_t class_of_(boost::fibers::context* ctx) noexcept
+  {
+    auto* props = static_cast<fiber_props*>(ctx->get_properties());
+    return static_cast<std::size_t>(props ? props->priority
+                                          : fiber_priority::normal);
+  }
+
+  void read_reactor_wakeup_()
+  {
+    unsigned generation = reactor_generation_;
+    reactor_wakeup_->async_read_some(
+        boost::asio::buffer(&reactor_wakeup_buf_, sizeof(reactor_wakeup_buf_)),
+        [this, generation](const boost::system::error_code& ec, std::size_t) {
+          // a read completed or cancelled before the reactor was detached
+          if (ec || generation != reactor_generation_) return;
+          wakeup_pending_.store(false, std::memory_order_release);
+          read_reactor_wakeup_();
+        });
+  }
+
+  void unpark_(std::chrono::steady_clock::time_point deadline) noexcept
+  {
+    park_deadline_ = deadline;
+    auto* ctx = parked_;
+    parked_ = nullptr;
+    ctx->ready_link(rqueues_[class_of_(ctx)]);
+    ++ready_count_;
+  }
 };
 
 }  // namespace asyik
@@ -0,0 +1,346 @@
+#ifndef LIBASYIK_ASYIK_WORK_STEALING_HPP
+#define LIBASYIK_ASYIK_WORK_STEALING_HPP
+
+#include <atomic>
+#include <boost/assert.hpp>
+#include <boost/fiber/algo/algorithm.hpp>
+#include <boost/fiber/condition_variable.hpp>
+#include <boost/fiber/context.hpp>
+#include <boost/fiber/mutex.hpp>
+#include <boost/fiber/operations.hpp>
+#include <boost/fiber/type.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "internal/small_task.hpp"
+
+namespace asyik {
+
+class asyik_work_stealing;
+
+// Shared state of a group of worker threads that balance load between each
+// other at two levels:
+//  - tasks:  every worker owns a deque. submit() distributes round-robin and
+//            a worker whose own deque is empty steals from the back of a
+//            peer's deque before going to sleep.
+//  - fibers: every worker thread runs the asyik_work_stealing algorithm, whose
+//            ready queue can be stolen from. A fiber that blocked on one
+//            worker (e.g. on a future) may resume on whichever worker is idle.
+//            Sleep timers stay with the worker that armed them, so a fiber
+//            sleeping on a worker whose thread is blocked only becomes ready
+//            once that thread runs its scheduler again.
+class work_stealing_group {
+ public:
+  using task_type = internal::small_task;
+
+  explicit work_stealing_group(std::size_t workers)
+  {
+    BOOST_ASSERT(workers > 0);
+    workers_.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i)
+      workers_.emplace_back(std::make_unique<worker>());
+  }
+
+  work_stealing_group(const work_stealing_group&) = delete;
+  work_stealing_group& operator=(const work_stealing_group&) = delete;
+
+  std::size_t size() const noexcept { return workers_.size(); }
+
+  // Queue a task on the next worker (round-robin). If that worker already has
+  // a backlog, or is busy running something else, nudge an idle peer so it
+  // comes to steal.
+  void submit(task_type&& t)
+  {
+    std::size_t id =
+        next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    auto& w = *workers_[id];
+    uint32_t depth;
+    bool owner_waiting;
+    {
+      std::unique_lock<boost::fibers::mutex> lk(w.mtx);
+      w.tasks.push_back(std::move(t));
+      // sequentially consistent, pairs with the idle check in pop()
+      depth = w.depth.fetch_add(1) + 1;
+      owner_waiting = w.waiting.load(std::memory_order_relaxed);
+    }
+    w.cnd.notify_one();
+    if (depth > 1 || !owner_waiting) wake_idle_peer_(id);
+  }
+
+  // Called by worker @p id's main fiber. Blocks (fiber-aware) until a task is
+  // available, either from its own deque or stolen from a peer. Returns false
+  // once the group is closed and the worker's deque is drained.
+  bool pop(std::size_t id, task_type& t)
+  {
+    auto& w = *workers_[id];
+    for (;;) {
+      {
+        std::unique_lock<boost::fibers::mutex> lk(w.mtx);
+        if (!w.tasks.empty()) {
+          t = std::move(w.tasks.front());
+          w.tasks.pop_front();
+          w.depth.fetch_sub(1, std::memory_order_relaxed);
+          return true;
+        }
+        if (closed_.load(std::memory_order_acquire)) return false;
+      }
+
+      // only go stealing when this worker has nothing else to run, so a
+      // worker does not hoard tasks it would then run serially
+      if (w.stealable.load(std::memory_order_relaxed)) {
+        boost::this_fiber::yield();
+        continue;
+      }
+      if (steal_task_(id, t)) return true;
+
+      std::unique_lock<boost::fibers::mutex> lk(w.mtx);
+      if (w.tasks.empty() && !closed_.load(std::memory_order_acquire)) {
+        // submit() nudges a waiting worker when a peer builds a backlog.
+        // Announce the wait before looking at the peers one last time: a
+        // submit() either sees `waiting` and notifies under this mutex, or
+        // its task shows up in peer_has_tasks_()
+        w.waiting.store(true);
+        if (!peer_has_tasks_(id)) w.cnd.wait(lk);
+        w.waiting.store(false, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void close()
+  {
+    closed_.store(true, std::memory_order_release);
+    for (auto& w : workers_) {
+      { std::unique_lock<boost::fibers::mutex> lk(w->mtx); }
+      w->cnd.notify_all();
+    }
+  }
+
+  // ---- stats ----
+
+  uint64_t task_steals() const noexcept
+  {
+    return task_steals_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t fiber_steals() const noexcept
+  {
+    return fiber_steals_.load(std::memory_order_relaxed);
+  }
+
+  // Pending (not yet started) tasks per worker.
+  std::vector<uint32_t> queue_depths() const
+  {
+    std::vector<uint32_t> v;
+    v.reserve(workers_.size());
+    for (auto& w : workers_)
+      v.push_back(w->depth.load(std::memory_order_relaxed));
+    return v;
+  }
+
+ private:
+  friend class asyik_work_stealing;
+
+  struct worker {
+    // task deque
+    boost::fibers::mutex mtx;
+    boost::fibers::condition_variable cnd;
+    std::deque<task_type> tasks;  // guarded by mtx
+    std::atomic<uint32_t> depth{0};
+    std::atomic<bool> waiting{false};
+
+    // fiber scheduler state of this worker's thread; owned here rather than
+    // by asyik_work_stealing so peers can keep stealing while a worker thread
+    // (and its scheduler) shuts down
+    std::mutex rq_mtx;
+    std::deque<boost::fibers::context*> ready;  // guarded by rq_mtx
+    std::atomic<uint32_t> ready_count{0};
+    std::atomic<uint32_t> stealable{0};  // unpinned part of ready_count
+    std::mutex sleep_mtx;
+    std::condition_variable sleep_cnd;
+    bool wake_flag{false};  // guarded by sleep_mtx
+    std::atomic<bool> idle{false};
+  };
+
+  bool steal_task_(std::size_t thief, task_type& t)
+  {
+    const std::size_t n = workers_.size();
+    for (std::size_t i = 1; i < n; ++i) {
+      auto& w = *workers_[(thief + i) % n];
+      if (!w.depth.load(std::memory_order_relaxed)) continue;
+      std::unique_lock<boost::fibers::mutex> lk(w.mtx, std::try_to_lock);
+      if (!lk.owns_lock() || w.tasks.empty()) continue;
+      t = std::move(w.tasks.back());
+      w.tasks.pop_back();
+      w.depth.fetch_sub(1, std::memory_order_relaxed);
+      task_steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  void wake_idle_peer_(std::size_t from)
+  {
+    const std::size_t n = workers_.size();
+    for (std::size_t i = 1; i < n; ++i) {
+      auto& w = *workers_[(from + i) % n];
+      if (w.waiting.load()) {
+        // under the mutex, so the nudge cannot fall between the waiter's
+        // last look at the peers and its wait
+        std::unique_lock<boost::fibers::mutex> lk(w.mtx);
+        w.cnd.notify_one();
+        return;
+      }
+    }
+  }
+
+  bool peer_has_tasks_(std::size_t id) const noexcept
+  {
+    const std::size_t n = workers_.size();
+    for (std::size_t i = 1; i < n; ++i)
+      if (workers_[(id + i) % n]->depth.load()) return true;
+    return false;
+  }
+
+  // Take the newest unpinned ready fiber of some peer of @p thief.
+  boost::fibers::context* steal_fiber_(std::size_t thief) noexcept
+  {
+    const std::size_t n = workers_.size();
+    for (std::size_t i = 1; i < n; ++i) {
+      auto& w = *workers_[(thief + i) % n];
+      if (!w.stealable.load(std::memory_order_relaxed)) continue;
+      std::unique_lock<std::mutex> lk{w.rq_mtx, std::try_to_lock};
+      if (!lk.owns_lock()) continue;
+      for (auto it = w.ready.rbegin(); it != w.ready.rend(); ++it) {
+        auto* ctx = *it;
+        if (ctx->is_context(boost::fibers::type::pinned_context)) continue;
+        w.ready.erase(std::next(it).base());
+        w.ready_count.fetch_sub(1, std::memory_order_relaxed);
+        w.stealable.fetch_sub(1, std::memory_order_relaxed);
+        fiber_steals_.fetch_add(1, std::memory_order_relaxed);
+        return ctx;
+      }
+    }
+    return nullptr;
+  }
+
+  static void wake_scheduler_(worker& w) noexcept
+  {
+    std::unique_lock<std::mutex> lk{w.sleep_mtx};
+    w.wake_flag = true;
+    lk.unlock();
+    w.sleep_cnd.notify_all();
+  }
+
+  void wake_idle_scheduler_(std::size_t from) noexcept
+  {
+    const std::size_t n = workers_.size();
+    for (std::size_t i = 1; i < n; ++i) {
+      auto& w = *workers_[(from + i) % n];
+      if (w.idle.load(std::memory_order_relaxed)) {
+        wake_scheduler_(w);
+        return;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<worker>> workers_;
+  std::atomic<std::size_t> next_{0};
+  std::atomic<bool> closed_{false};
+  std::atomic<uint64_t> task_steals_{0};
+  std::atomic<uint64_t> fiber_steals_{0};
+};
+
+// Fiber scheduling algorithm for work_stealing_group workers.
+//
+// Like asyik_round_robin, but the ready queue is shared with the other
+// workers of the group: when a thread runs out of ready fibers it takes one
+// from the back of a peer's queue before going to sleep, and a thread that
+// builds up a backlog wakes a sleeping peer. Main and dispatcher contexts are
+// pinned and never migrate.
+class asyik_work_stealing : public boost::fibers::algo::algorithm {
+ private:
+  using worker = work_stealing_group::worker;
+
+  std::shared_ptr<work_stealing_group> group_;
+  std::size_t id_;
+  worker& w_;
+
+ public:
+  asyik_work_stealing(std::shared_ptr<work_stealing_group> group,
+                      std::size_t id)
+      : group_(std::move(group)), id_(id), w_(*group_->workers_.at(id))
+  {
+  }
+
+  asyik_work_stealing(const asyik_work_stealing&) = delete;
+  asyik_work_stealing& operator=(const asyik_work_stealing&) = delete;
+
+  void awakened(boost::fibers::context* ctx) noexcept override
+  {
+    BOOST_ASSERT(nullptr != ctx);
+    BOOST_ASSERT(ctx->is_resumable());
+    // unpinned fibers leave this thread's scheduler so any peer may resume
+    // them; pick_next() attaches them to whoever runs them
+    const bool pinned = ctx->is_context(boost::fibers::type::pinned_context);
+    if (!pinned) ctx->detach();
+    uint32_t backlog = 0;
+    {
+      std::lock_guard<std::mutex> lk{w_.rq_mtx};
+      w_.ready.push_back(ctx);
+      w_.ready_count.fetch_add(1, std::memory_order_relaxed);
+      if (!pinned)
+        backlog = w_.stealable.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    if (backlog > 1) group_->wake_idle_scheduler_(id_);
+  }
+
+  boost::fibers::context* pick_next() noexcept override
+  {
+    boost::fibers::context* victim = nullptr;
+    {
+      std::lock_guard<std::mutex> lk{w_.rq_mtx};
+      if (!w_.ready.empty()) {
+        victim = w_.ready.front();
+        w_.ready.pop_front();
+        w_.ready_count.fetch_sub(1, std::memory_order_relaxed);
+        if (!victim->is_context(boost::fibers::type::pinned_context))
+          w_.stealable.fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+    if (!victim) victim = group_->steal_fiber_(id_);
+    if (victim && !victim->is_context(boost::fibers::type::pinned_context))
+      boost::fibers::context::active()->attach(victim);
+    return victim;
+  }
+
+  bool has_ready_fibers() const noexcept override
+  {
+    return w_.ready_count.load(std::memory_order_relaxed) > 0;
+  }
+
+  void suspend_until(
+      std::chrono::steady_clock::time_point const& time_point) noexcept override
+  {
+    w_.idle.store(true, std::memory_order_relaxed);
+    {
+      std::unique_lock<std::mutex> lk{w_.sleep_mtx};
+      if ((std::chrono::steady_clock::time_point::max)() == time_point)
+        w_.sleep_cnd.wait(lk, [&]() { return w_.wake_flag; });
+      else
+        w_.sleep_cnd.wait_until(lk, time_point, [&]() { return w_.wake_flag; });
+      w_.wake_flag = false;
+    }
+    w_.idle.store(false, std::memory_order_relaxed);
+  }
+
+  void notify() noexcept override { work_stealing_group::wake_scheduler_(w_); }
+};
+
+}  // namespace asyik
+
+#endif  // LIBASYIK_ASYIK_WORK_STEALING_HPP
@@ -0,0 +1,339 @@
+#ifndef LIBASYIK_ASYIK_FUTURES_HPP
+#define LIBASYIK_ASYIK_FUTURES_HPP
+
+#include <boost/asio/version.hpp>
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "internal/asio_internal.hpp"
+
+#if BOOST_ASIO_VERSION >= 101900
+#include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#endif
+
+// Waiting on several fiber futures at once, for handlers that fan out to a
+// few upstream calls and then gather the results:
+//
+//   auto user = as->async(load_user, id).share();
+//   auto feed = as->execute(fetch_feed, id).share();
+//   if (!asyik::when_all_for(std::chrono::milliseconds(200), user, feed))
+//     ...  // at least one is still pending
+//
+// The combinators only wait: a future that holds an exception counts as
+// ready, get() then rethrows it. Call them from a fiber; on a thread that is
+// not running fibers they block the thread.
+
+namespace asyik {
+
+namespace internal {
+
+constexpr std::size_t when_any_none = std::size_t(-1);
+
+template <typename Future>
+bool future_ready(const Future& f)
+{
+  return f.wait_for(std::chrono::seconds(0)) ==
+         boost::fibers::future_status::ready;
+}
+
+template <typename Clock, typename Duration, typename Future>
+bool wait_future_until(const std::chrono::time_point<Clock, Duration>& deadline,
+                       const Future& f)
+{
+  if (deadline == (std::chrono::time_point<Clock, Duration>::max)()) {
+    f.wait();
+    return true;
+  }
+  return f.wait_until(deadline) == boost::fibers::future_status::ready;
+}
+
+// Shared by when_any() and its waiter fibers, which may outlive the call.
+struct when_any_state {
+  boost::fibers::mutex mtx;
+  boost::fibers::condition_variable cnd;
+  std::size_t winner = when_any_none;
+};
+
+// One fiber per pending future; it holds a copy of the shared_future, so
+// the caller may drop theirs, and ends once that future is ready.
+template <typename T>
+void when_any_watch(const std::shared_ptr<when_any_state>& st,
+                    const boost::fibers::shared_future<T>& f, std::size_t i)
+{
+  boost::fibers::fiber fb([st, f, i]() {
+    f.wait();
+    std::lock_guard<boost::fibers::mutex> lk(st->mtx);
+    if (st->winner == when_any_none) {
+      st->winner = i;
+      st->cnd.notify_all();
+    }
+  });
+  fb.detach();
+}
+
+template <typename Clock, typename Duration>
+std::size_t when_any_wait(
+    const std::shared_ptr<when_any_state>& st,
+    const std::chrono::time_point<Clock, Duration>& deadline, std::size_t n)
+{
+  std::unique_lock<boost::fibers::mutex> lk(st->mtx);
+  auto decided = [&st]() { return st->winner != when_any_none; };
+  if (deadline == (std::chrono::time_point<Clock, Duration>::max)())
+    st->cnd.wait(lk, decided);
+  else if (!st->cnd.wait_until(lk, deadline, decided))
+    st->winner = n;  // late waiters find the race over
+  return st->winner;
+}
+
+template <typename Rep, typename Period>
+std::chrono::steady_clock::time_point deadline_after(
+    const std::chrono::duration<Rep, Period>& timeout)
+{
+  return std::chrono::steady_clock::now() +
+         std::chrono::ceil<std::chrono::steady_clock::duration>(timeout);
+}
+
+}  // namespace internal
+
+/// Waits until every future is ready, or @p deadline has passed; false on
+/// timeout. Takes fibers::future and fibers::shared_future alike.
+template <typename Clock, typename Duration, typename... Futures>
+bool when_all_until(const std::chrono::time_point<Clock, Duration>& deadline,
+                    const Futures&... fs)
+{
+  // the slowest one decides, so waiting on them in turn loses nothing
+  return (internal::wait_future_until(deadline, fs) && ...);
+}
+
+template <typename Clock, typename Duration, typename Future>
+bool when_all_until(const std::chrono::time_point<Clock, Duration>& deadline,
+                    const std::vector<Future>& fs)
+{
+  for (auto& f : fs)
+    if (!internal::wait_future_until(deadline, f)) return false;
+  return true;
+}
+
+template <typename Rep, typename Period, typename... Futures>
+bool when_all_for(const std::chrono::duration<Rep, Period>& timeout,
+                  const Futures&... fs)
+{
+  return when_all_until(internal::deadline_after(timeout), fs...);
+}
+
+/// Waits until every future is ready.
+template <typename... Futures>
+void when_all(const Futures&... fs)
+{
+  when_all_until((std::chrono::steady_clock::time_point::max)(), fs...);
+}
+
+/// Waits until one of the futures is ready, or @p deadline has passed.
+/// Returns the index of the first ready future, or the number of futures
+/// on timeout.
+///
+/// Takes shared futures (fibers::future::share()): a future still pending
+/// on return is watched by a small fiber until it is ready, which needs a
+/// copy of it. Bind the operations behind them to a cancellation_scope
+/// to have the losers cancelled instead of left running.
+template <typename Clock, typename Duration, typename... T>
+std::size_t when_any_until(
+    const std::chrono::time_point<Clock, Duration>& deadline,
+    const boost::fibers::shared_future<T>&... fs)
+{
+  constexpr std::size_t n = sizeof...(T);
+  std::size_t i = 0, ready = internal::when_any_none;
+  ((ready == internal::when_any_none && internal::future_ready(fs)
+        ? void(ready = i)
+        : void(),
+    ++i),
+   ...);
+  if (ready != internal::when_any_none) return ready;
+  if (n == 0 || Clock::now() >= deadline) return n;
+
+  auto st = std::make_shared<internal::when_any_state>();
+  i = 0;
+  (internal::when_any_watch(st, fs, i++), ...);
+  return internal::when_any_wait(st, deadline, n);
+}
+
+template <typename Clock, typename Duration, typename T>
+std::size_t when_any_until(
+    const std::chrono::time_point<Clock, Duration>& deadline,
+    const std::vector<boost::fibers::shared_future<T>>& fs)
+{
+  for (std::size_t i = 0; i < fs.size(); ++i)
+    if (internal::future_ready(fs[i])) return i;
+  if (fs.empty() || Clock::now() >= deadline) return fs.size();
+
+  auto st = std::make_shared<internal::when_any_state>();
+  for (std::size_t i = 0; i < fs.size(); ++i)
+    internal::when_any_watch(st, fs[i], i);
+  return internal::when_any_wait(st, deadline, fs.size());
+}
+
+template <typename Rep, typename Period, typename... Futures>
+std::size_t when_any_for(const std::chrono::duration<Rep, Period>& timeout,
+                         const Futures&... fs)
+{
+  return when_any_until(internal::deadline_after(timeout), fs...);
+}
+
+/// Waits until one of the futures is ready and returns its index.
+template <typename... Futures>
+std::size_t when_any(const Futures&... fs)
+{
+  return when_any_until((std::chrono::steady_clock::time_point::max)(),
+                        fs...);
+}
+
+#if BOOST_ASIO_VERSION >= 101900
+
+namespace internal {
+
+struct cancellation_state {
+  using signals = std::list<boost::asio::cancellation_signal>;
+  signals pending;
+  signals idle;  // reused by the next token()
+};
+
+// Completion of an operation bound to a cancellation_scope: clears its slot,
+// so a later cancel() does not reach the finished operation, and hands the
+// result on like use_fiber_future.
+struct scoped_completion {
+  std::shared_ptr<cancellation_state> state;
+  cancellation_state::signals::iterator signal;
+
+  void release() const
+  {
+    signal->slot().clear();
+    state->idle.splice(state->idle.end(), state->pending, signal);
+  }
+
+  void operator()(const boost::system::error_code& ec) const
+  {
+    release();
+    if (ec) throw boost::system::system_error(ec);
+  }
+
+  template <typename T>
+  T operator()(const boost::system::error_code& ec, T t) const
+  {
+    release();
+    if (ec) throw boost::system::system_error(ec);
+    return t;
+  }
+};
+
+}  // namespace internal
+
+/// Asio operations that can be called off together, e.g. the losers of a
+/// when_any(). token() is a completion token like use_fiber_future, whose
+/// operation is cancelled (per-operation cancellation, terminal by
+/// default) by cancel(); operations that already completed are left alone.
+///
+///   asyik::cancellation_scope scope;
+///   auto a = socket_a.async_read_some(buf_a, scope.token()).share();
+///   auto b = timer.async_wait(scope.token()).share();
+///   std::size_t first = asyik::when_any(scope, a, b);  // cancels the other
+///
+/// Use a scope from the thread running the operations' io_context. It may
+/// go out of scope before they complete: pending operations keep its state
+/// alive.
+class cancellation_scope {
+ public:
+  cancellation_scope() = default;
+  cancellation_scope(const cancellation_scope&) = delete;
+  cancellation_scope& operator=(const cancellation_scope&) = delete;
+
+  /// Cancels whatever is still pending.
+  ~cancellation_scope() { cancel(); }
+
+  /// A new completion token; use each for one operation.
+  auto token()
+  {
+    auto& st = *state_;
+    if (st.idle.empty())
+      st.pending.emplace_back();
+    else
+      st.pending.splice(st.pending.end(), st.idle, st.idle.begin());
+    auto signal = std::prev(st.pending.end());
+    return boost::asio::bind_cancellation_slot(
+        signal->slot(),
+        boost::asio::use_fiber_future(
+            internal::scoped_completion{state_, signal}));
+  }
+
+  void cancel(boost::asio::cancellation_type_t type =
+                  boost::asio::cancellation_type::terminal)
+  {
+    // cancelled operations complete later, from the io_context, so the
+    // list does not change underneath
+    for (auto& signal : state_->pending) signal.emit(type);
+  }
+
+  /// Operations started with token() that have not completed yet.
+  std::size_t pending() const { return state_->pending.size(); }
+
+ private:
+  std::shared_ptr<internal::cancellation_state> state_{
+      std::make_shared<internal::cancellation_state>()};
+};
+
+/// when_all_until() etc. that cancel @p scope when they return false or,
+/// for when_any, whenever they return: the losers and everything else
+/// still pending in the scope.
+template <typename Clock, typename Duration, typename... Futures>
+bool when_all_until(cancellation_scope& scope,
+                    const std::chrono::time_point<Clock, Duration>& deadline,
+                    const Futures&... fs)
+{
+  bool done = when_all_until(deadline, fs...);
+  if (!done) scope.cancel();
+  return done;
+}
+
+template <typename Rep, typename Period, typename... Futures>
+bool when_all_for(cancellation_scope& scope,
+                  const std::chrono::duration<Rep, Period>& timeout,
+                  const Futures&... fs)
+{
+  return when_all_until(scope, internal::deadline_after(timeout), fs...);
+}
+
+template <typename Clock, typename Duration, typename... Futures>
+std::size_t when_any_until(
+    cancellation_scope& scope,
+    const std::chrono::time_point<Clock, Duration>& deadline,
+    const Futures&... fs)
+{
+  std::size_t first = when_any_until(deadline, fs...);
+  scope.cancel();
+  return first;
+}
+
+template <typename Rep, typename Period, typename... Futures>
+std::size_t when_any_for(cancellation_scope& scope,
+                         const std::chrono::duration<Rep, Period>& timeout,
+                         const Futures&... fs)
+{
+  return when_any_until(scope, internal::deadline_after(timeout), fs...);
+}
+
+template <typename... Futures>
+std::size_t when_any(cancellation_scope& scope, const Futures&... fs)
+{
+  return when_any_until(scope, (std::chrono::steady_clock::time_point::max)(),
+                        fs...);
+}
+
+#endif  // BOOST_ASIO_VERSION >= 101900
+
+}  // namespace asyik
+
+#endif  // LIBASYIK_ASYIK_FUTURES_HPP
@@ -24,6 +24,7 @@
 #include "error.hpp"
 #include "internal/asio_internal.hpp"
 #include "internal/digestauth.hpp"
+#include "internal/http_scanner.hpp"
 #include "service.hpp"
 
 // Include modular headers
@@ -123,8 +124,8 @@ template <typename S, typename Buf, typename BR, typename P>
 void handle_client_auth(S& stream, http_url_scheme& scheme, Buf& buffer,
                         BR& beast_request, P& empty_parser)
 {
-  http::response_parser<http::string_body> resp_parser_unauth{
-      std::move(empty_parser)};
+  http::response_parser<http::string_body, http_fields::allocator_type>
+      resp_parser_unauth{std::move(empty_parser)};
 
   asyik::internal::http::async_read(stream, buffer, resp_parser_unauth).get();
 
@@ -143,7 +144,8 @@ boost::fibers::future<size_t> handle_client_request_response(
 {
   auto w = internal::http::async_write(stream, req->beast_request);
 
-  http::response_parser<http::empty_body> empty_parser;
+  http::response_parser<http::empty_body, http_fields::allocator_type>
+      empty_parser;
   empty_parser.eager(false);
   empty_parser.header_limit(default_response_header_limit);
   empty_parser.body_limit(default_response_body_limit);
@@ -170,8 +172,8 @@ boost::fibers::future<size_t> handle_client_request_response(
       throw asyik::unexpected_error(
           "HTTP response error, cannot get boundary token");
 
-    http::response_parser<http::string_body> resp_parser{
-        std::move(empty_parser)};
+    http::response_parser<http::string_body, http_fields::allocator_type>
+        resp_parser{std::move(empty_parser)};
     req->response.beast_response = resp_parser.release();
 
     while (find_multipart_boundary(stream, req->buffer,
@@ -179,7 +181,8 @@ boost::fibers::future<size_t> handle_client_request_response(
       beast::get_lowest_layer(stream).expires_after(
           std::chrono::milliseconds(timeout_ms));
 
-      http::response_parser<http::empty_body> empty_mpart_parser;
+      http::response_parser<http::empty_body, http_fields::allocator_type>
+          empty_mpart_parser;
       empty_mpart_parser.eager(false);
       empty_mpart_parser.header_limit(default_response_header_limit);
       empty_mpart_parser.body_limit(default_response_body_limit);
@@ -200,8 +203,8 @@ boost::fibers::future<size_t> handle_client_request_response(
             "HTTP multipart without part content-length is not "
             "supported!");
 
-      http::response_parser<http::string_body> resp_mpart_parser{
-          std::move(empty_mpart_parser)};
+      http::response_parser<http::string_body, http_fields::allocator_type>
+          resp_mpart_parser{std::move(empty_mpart_parser)};
       asyik::internal::http::async_read(stream, req->buffer, resp_mpart_parser)
           .get();
 
@@ -212,8 +215,8 @@ boost::fibers::future<size_t> handle_client_request_response(
     }
   } else {
     // non-multipart handling
-    http::response_parser<http::string_body> resp_parser{
-        std::move(empty_parser)};
+    http::response_parser<http::string_body, http_fields::allocator_type>
+        resp_parser{std::move(empty_parser)};
 
     asyik::internal::http::async_read(stream, req->buffer, resp_parser).get();
 
@@ -426,11 +429,14 @@ void http_connection<StreamType>::start()
 {
   if (auto server = http_server.lock()) {
     if (auto service = server->service.lock()) {
-      service->execute([p = this->shared_from_this(),
-                        req_pool = server->req_pool_,
-                        body_limit = server->get_request_body_limit(),
-                        header_limit =
-                            server->get_request_header_limit()](void) {
+      service->execute_detached([p = this->shared_from_this(),
+                                 req_pool = server->req_pool_,
+                                 body_limit = server->get_request_body_limit(),
+                                 header_limit =
+                                     server->get_request_header_limit(),
+                                 idle_timeout = server->get_idle_timeout(),
+                                 engine = server->get_parser_engine(),
+                                 as = service.get()](void) {
         // flag to ignore eos error since work has been
         // done anyway
         bool safe_to_close = false;
@@ -444,31 +450,110 @@ void http_connection<StreamType>::start()
           auto asyik_req = req_pool->acquire();
           auto& req = asyik_req->beast_request;
           asyik_req->connection_wptr = http_connection_wptr<StreamType>(p);
+          internal::http_scanner::request_head head;
+          // route arguments keep their capacity from request to request
+          http_route_args route_args;
+          http_route_view_args view_args;
+          wheel_timer idle;
+          bool idle_expired = false;
+          // runs @p read under the idle timeout, false once it expired
+          auto read_input = [&p, &idle, &idle_expired,
+                             idle_timeout](auto&& read) {
+            p->flush_responses();
+            // a timer that fired as the previous read completed does not
+            // make this read idle
+            idle_expired = false;
+            if (idle_timeout.count())
+              idle.arm(idle_timeout, [&p, &idle_expired]() {
+                idle_expired = true;
+                boost::system::error_code ec;
+                beast::get_lowest_layer(p->get_stream()).socket().cancel(ec);
+              });
+            try {
+              read();
+            } catch (...) {
+              // an idle client is not worth a graceful shutdown
+              if (idle_expired) return false;
+              throw;
+            }
+            idle.cancel();
+            return true;
+          };
           while (1) {
-            // Single-pass read: parse header + body in one async_read call
-            // (eliminates the extra fiber suspend/resume of the old two-phase
-            // async_read_header + async_read approach).
-            http::request_parser<http::string_body> req_parser;
-            req_parser.header_limit(header_limit);
-            req_parser.body_limit(body_limit);
-
-            asyik_req->buffer.clear();
 #ifdef LIBASYIK_HTTP_PROFILING
             auto _p_t0 = std::chrono::steady_clock::now();
 #endif
-            asyik::internal::http::async_read(p->get_stream(),
-                                              asyik_req->buffer, req_parser)
-                .get();
+            // the previous request is done with: its headers and those of
+            // its response are rewound in one go
+            asyik_req->recycle();
+            // A pipelining client may have sent the next requests along with
+            // the last one: serve those from the buffer without reading, and
+            // only flush the queued responses once the input runs dry.
+            auto& buffer = asyik_req->buffer;
+            auto scanned = scan_result::fallback;
+            if (engine == http_parser_engine::simd) {
+              while ((scanned = p->scan_buffered(buffer, head, header_limit,
+                                                 body_limit)) ==
+                     scan_result::need_more) {
+                if (!read_input([&p, &buffer]() {
+                      // scan_buffered() reserved room for a pending body
+                      auto room = std::max<std::size_t>(
+                          buffer.capacity() - buffer.size(), 4096);
+                      buffer.commit(asyik::internal::socket::async_read_some(
+                                        p->get_stream(), buffer.prepare(room))
+                                        .get());
+                    }))
+                  return;
+              }
+            }
+            if (scanned == scan_result::fallback) {
+              // Single-pass read: parse header + body in one async_read call
+              // (eliminates the extra fiber suspend/resume of the old
+              // two-phase async_read_header + async_read approach).
+              http::request_parser<http::string_body,
+                                   http_fields::allocator_type>
+                  req_parser(std::piecewise_construct, std::make_tuple(),
+                             std::make_tuple(http_fields::allocator_type(
+                                 &asyik_req->arena)));
+              req_parser.header_limit(header_limit);
+              req_parser.body_limit(body_limit);
+
+              if (!p->parse_buffered(buffer, req_parser) &&
+                  !read_input([&p, &buffer, &req_parser]() {
+                    asyik::internal::http::async_read(p->get_stream(), buffer,
+                                                      req_parser)
+                        .get();
+                  }))
+                return;
+              req = req_parser.release();
+            }
 #ifdef LIBASYIK_HTTP_PROFILING
             asyik::profiling::g_http_prof.read_request.record(
                 ASYIK_PROF_NS(_p_t0));
 #endif
             safe_to_close = false;
-            req = req_parser.release();
 
-            asyik_req->set_url_view();
+            // on_http_request_view() handlers take the request where it lies,
+            // the others get a copy in req
+            const view_route_table::route* view_route = nullptr;
+            auto view_server = p->http_server.lock();
+            if (view_server) {
+              if (scanned == scan_result::complete) {
+                if (head.field("upgrade").empty())
+                  view_route = view_server->find_http_view_route(
+                      head.method, head.target, view_args);
+              } else if (!beast::websocket::is_upgrade(req)) {
+                view_route = view_server->find_http_view_route(
+                    req.method_string(), req.target(), view_args);
+              }
+            }
+            if (!view_route) {
+              if (scanned == scan_result::complete)
+                p->fill_request(buffer, head, req);
+              asyik_req->set_url_view();
+            }
             // See if its a WebSocket upgrade request
-            if (beast::websocket::is_upgrade(req)) {
+            if (!view_route && beast::websocket::is_upgrade(req)) {
               // Clients SHOULD NOT begin sending WebSocket
               // frames until the server has provided a response.
               if (asyik_req->buffer.size() != 0)
@@ -482,8 +567,9 @@ void http_connection<StreamType>::start()
                 auto server = p->http_server.lock();
 
                 http_route_args args;
+                string_view spec;
                 const websocket_route_tuple& route =
-                    server->find_websocket_route(req, args);
+                    server->find_websocket_route(req, args, &spec);
 
                 // Construct the str ;o,\eam, transferring ownership of the
                 // socket
@@ -492,6 +578,7 @@ void http_connection<StreamType>::start()
 
                 auto service = server->service.lock();
 
+                p->flush_responses();
                 auto new_ws = std::make_shared<
                     websocket_impl<beast::websocket::stream<StreamType>>>(
                     typename websocket_impl<
@@ -505,6 +592,7 @@ void http_connection<StreamType>::start()
                 p->is_websocket = true;
 
                 try {
+                  fiber_label label(spec);
                   std::get<2>(route)(new_ws, args);
                 } catch (...) {
                   LOG(ERROR)
@@ -518,13 +606,21 @@ void http_connection<StreamType>::start()
               // Its not a WebSocket upgrade, so
               // handle it like a normal HTTP request.
               auto& res = asyik_req->response.beast_response;
-
-              asyik_req->response.headers.set(http::field::server,
-                                              LIBASYIK_VERSION_STRING);
-              asyik_req->response.headers.set(http::field::content_type,
-                                              "text/html");
-              asyik_req->response.beast_response.keep_alive(
-                  asyik_req->beast_request.keep_alive());
+              // template routes answer with their prebuilt bytes, unless the
+              // client speaks HTTP/1.0 or closes the connection
+              const http_response_template* tmpl =
+                  view_route ? view_route->response_template.get() : nullptr;
+              bool raw_template = false;
+
+              if (!tmpl) {
+                asyik_req->response.headers.set(http::field::server,
+                                                LIBASYIK_VERSION_STRING);
+                asyik_req->response.headers.set(http::field::content_type,
+                                                "text/html");
+              }
+              if (!view_route)
+                asyik_req->response.beast_response.keep_alive(
+                    asyik_req->beast_request.keep_alive());
 
               // pretty much should be improved
               try {
@@ -532,44 +628,82 @@ void http_connection<StreamType>::start()
                   throw network_expired_error("server expired");
                 auto server = p->http_server.lock();
 
-                try {
-                  http_route_args args;
+                if (view_route) {
+                  http_request_view view =
+                      scanned == scan_result::complete
+                          ? http_request_view(head, buffer, *asyik_req)
+                          : http_request_view(*asyik_req);
+                  res.keep_alive(view.keep_alive());
+                  raw_template =
+                      tmpl && view.version() == 11 && res.keep_alive();
+                  if (tmpl && !raw_template) tmpl->fill(res);
+                  if (view_route->cb) {
+                    fiber_label label(view_route->spec);
+                    view_route->cb(view, view_args);
+                  }
+                } else {
+                  try {
 #ifdef LIBASYIK_HTTP_PROFILING
-                  auto _p_t2 = std::chrono::steady_clock::now();
+                    auto _p_t2 = std::chrono::steady_clock::now();
 #endif
-                  const http_route_tuple& route =
-                      server->find_http_route(req, args);
+                    string_view spec;
+                    const http_route_tuple& route =
+                        server->find_http_route(req, route_args, &spec);
 #ifdef LIBASYIK_HTTP_PROFILING
-                  asyik::profiling::g_http_prof.route_match.record(
-                      ASYIK_PROF_NS(_p_t2));
-                  auto _p_t3 = std::chrono::steady_clock::now();
+                    asyik::profiling::g_http_prof.route_match.record(
+                        ASYIK_PROF_NS(_p_t2));
+                    auto _p_t3 = std::chrono::steady_clock::now();
 #endif
-                  std::get<2>(route)(asyik_req, args);
+                    fiber_label label(spec);
+                    std::get<2>(route)(asyik_req, route_args);
 #ifdef LIBASYIK_HTTP_PROFILING
-                  asyik::profiling::g_http_prof.handler.record(
-                      ASYIK_PROF_NS(_p_t3));
+                    asyik::profiling::g_http_prof.handler.record(
+                        ASYIK_PROF_NS(_p_t3));
 #endif
-                } catch (not_found_error& e) {
-                  asyik_req->response.body = "";
-                  asyik_req->response.result(404);
-                  asyik_req->response.beast_response.keep_alive(false);
+                  } catch (not_found_error& e) {
+                    asyik_req->response.body = "";
+                    asyik_req->response.result(404);
+                    asyik_req->response.beast_response.keep_alive(false);
+                  }
                 }
               } catch (...) {
+                raw_template = false;
                 asyik_req->response.body = "";
                 asyik_req->response.result(500);
                 asyik_req->response.beast_response.keep_alive(false);
               };
+              // the views are gone: let go of the request they pointed into
+              if (view_route && scanned == scan_result::complete)
+                buffer.consume(head.size + head.content_length);
+
+              if (raw_template) {
+                p->queue_response(*tmpl, as->http_date(),
+                                  view_route->cb ? &res.body() : nullptr);
+                if (!buffer.size()) p->flush_responses();
+                safe_to_close = true;
+                continue;
+              }
 
               if (asyik_req->manual_response) {
                 safe_to_close = true;
                 break;
               }
 
+              if (!res.count(http::field::date))
+                res.set(http::field::date, as->http_date());
               asyik_req->response.beast_response.prepare_payload();
 #ifdef LIBASYIK_HTTP_PROFILING
               auto _p_t4 = std::chrono::steady_clock::now();
 #endif
-              asyik::internal::http::async_write(p->get_stream(), res).get();
+              if (asyik_req->buffer.size() && !res.need_eof()) {
+                // more pipelined input is waiting: batch this response
+                p->queue_response(res);
+              } else if (p->pending_responses.size()) {
+                p->queue_response(res);
+                p->flush_responses();
+              } else {
+                asyik::internal::http::async_write(p->get_stream(), res).get();
+              }
 #ifdef LIBASYIK_HTTP_PROFILING
               asyik::profiling::g_http_prof.write_response.record(
                   ASYIK_PROF_NS(_p_t4));
@@ -587,8 +721,8 @@ void http_connection<StreamType>::start()
                 break;
               }
 
-              // Keep-alive: reset response state before the next request.
-              asyik_req->response.beast_response = http_beast_response{};
+              // Keep-alive: the response state is reset by recycle() before
+              // the next request.
               asyik_req->manual_response = false;
               // Mark safe so that an EOF on the next async_read (client
               // closing after receiving the response) is silently ignored
@@ -600,13 +734,15 @@ void http_connection<StreamType>::start()
         }
         // TODO: all HTTP 5xx and 4xx handling should be put here instead
         catch (overflow_error& e) {
+          p->flush_responses();
           http_beast_response beast_response;
           beast_response.body() = e.what();
           beast_response.keep_alive(false);
           beast_response.result(413);
 
           beast_response.prepare_payload();
-          http::serializer<false, http::string_body> sr{beast_response};
+          http::serializer<false, http::string_body, http_fields> sr{
+              beast_response};
           asyik::internal::http::async_write(p->get_stream(), beast_response)
               .get();
 
@@ -627,13 +763,132 @@ void http_connection<StreamType>::start()
   };
 }
 
+template <typename StreamType>
+template <typename Parser>
+bool http_connection<StreamType>::parse_buffered(beast::flat_buffer& buffer,
+                                                 Parser& parser)
+{
+  if (!buffer.size()) return false;
+  parser.eager(true);
+  boost::system::error_code ec;
+  while (buffer.size() && !parser.is_done()) {
+    auto n = parser.put(buffer.data(), ec);
+    buffer.consume(n);
+    if (ec == http::error::need_more) return false;
+    if (ec == http::error::header_limit)
+      throw overflow_error(
+          ec,
+          "[asyik::overflow_error]incoming request header size is too large");
+    if (ec == http::error::body_limit)
+      throw overflow_error(
+          ec, "[asyik::overflow_error]incoming request body size is too large");
+    if (ec) throw boost::system::system_error(ec, ec.message());
+  }
+  return parser.is_done();
+}
+
+template <typename StreamType>
+typename http_connection<StreamType>::scan_result
+http_connection<StreamType>::scan_buffered(
+    beast::flat_buffer& buffer, internal::http_scanner::request_head& head,
+    size_t header_limit, size_t body_limit)
+{
+  namespace scanner = asyik::internal::http_scanner;
+  const char* data = static_cast<const char*>(buffer.data().data());
+  switch (scanner::scan_request(data, buffer.size(), head)) {
+    case scanner::scan_status::fallback:
+      return scan_result::fallback;
+    case scanner::scan_status::partial:
+      if (buffer.size() > header_limit)
+        throw overflow_error(
+            http::error::header_limit,
+            "[asyik::overflow_error]incoming request header size is too large");
+      return scan_result::need_more;
+    case scanner::scan_status::complete:
+      break;
+  }
+  if (head.size > header_limit)
+    throw overflow_error(
+        http::error::header_limit,
+        "[asyik::overflow_error]incoming request header size is too large");
+  if (head.content_length > body_limit)
+    throw overflow_error(
+        http::error::body_limit,
+        "[asyik::overflow_error]incoming request body size is too large");
+  if (buffer.size() - head.size < head.content_length) {
+    // make room for the whole body, so that the next reads fill it in
+    buffer.reserve(head.size + head.content_length);
+    return scan_result::need_more;
+  }
+  return scan_result::complete;
+}
+
+template <typename StreamType>
+void http_connection<StreamType>::fill_request(
+    beast::flat_buffer& buffer,
+    const internal::http_scanner::request_head& head, http_beast_request& req)
+{
+  // the views point into the buffer: copy before consuming it
+  const char* data = static_cast<const char*>(buffer.data().data());
+  req.clear();
+  req.method_string(head.method);
+  req.target(head.target);
+  req.version(head.version);
+  for (std::size_t i = 0; i < head.num_headers; ++i)
+    req.insert(head.headers[i].name, head.headers[i].value);
+  req.body().assign(data + head.size, head.content_length);
+  buffer.consume(head.size + head.content_length);
+}
+
+template <typename StreamType>
+void http_connection<StreamType>::queue_response(http_beast_response& res)
+{
+  http::serializer<false, http_beast_response::body_type, http_fields> sr{
+      res};
+  boost::system::error_code ec;
+  do {
+    sr.next(ec, [this, &sr](boost::system::error_code& e,
+                            const auto& buffers) {
+      e = {};
+      auto n = asio::buffer_size(buffers);
+      asio::buffer_copy(pending_responses.prepare(n), buffers);
+      pending_responses.commit(n);
+      sr.consume(n);
+    });
+  } while (!ec && !sr.is_done());
+  if (ec) throw boost::system::system_error(ec, ec.message());
+  if (pending_responses.size() >= max_pending_response_bytes)
+    flush_responses();
+}
+
+template <typename StreamType>
+void http_connection<StreamType>::queue_response(
+    const http_response_template& tmpl, string_view date,
+    const http_response_body* body)
+{
+  if (body)
+    tmpl.write(pending_responses, date, *body);
+  else
+    tmpl.write(pending_responses, date);
+  if (pending_responses.size() >= max_pending_response_bytes)
+    flush_responses();
+}
+
+template <typename StreamType>
+void http_connection<StreamType>::flush_responses()
+{
+  if (!pending_responses.size()) return;
+  asyik::internal::socket::async_write(stream, pending_responses.data()).get();
+  pending_responses.clear();
+}
+
 template <typename StreamType>
 http_server<StreamType>::http_server(struct private_&&, service_ptr as,
                                      string_view addr, uint16_t port)
     : service(as),
       conn_pool_(
           std::make_shared<shared_object_pool<http_connection<StreamType>>>()),
-      req_pool_(std::make_shared<shared_object_pool<http_request>>()),
+      req_pool_(std::make_shared<shared_object_pool<http_server_request>>()),
       request_body_limit(default_request_body_limit),
       request_header_limit(default_request_header_limit)
 {
@@ -652,6 +907,7 @@ void http_server<StreamType>::start_accept(asio::io_context& io_service)
           const boost::system::error_code& error, tcp::socket socket) {
         if (!p.expired() && !error) {
           auto ps = p.lock();
+          if (ps->busy_poll.count() > 0) ps->apply_busy_poll(socket);
           auto new_connection = ps->conn_pool_->acquire(
               typename http_connection<StreamType>::private_{},
               std::move(socket), ps);
@@ -667,6 +923,36 @@ void http_server<StreamType>::start_accept(asio::io_context& io_service)
         }
       });
 }
+
+template <typename StreamType>
+void http_server<StreamType>::apply_busy_poll(tcp::socket& socket)
+{
+#ifdef SO_BUSY_POLL
+  boost::system::error_code ec;
+  socket.set_option(asio::detail::socket_option::integer<SOL_SOCKET,
+                                                         SO_BUSY_POLL>(
+                        static_cast<int>(busy_poll.count())),
+                    ec);
+#ifdef SO_PREFER_BUSY_POLL
+  if (!ec)
+    socket.set_option(
+        asio::detail::socket_option::boolean<SOL_SOCKET, SO_PREFER_BUSY_POLL>(
+            true),
+        ec);
+#endif
+  if (ec && !busy_poll_warned) {
+    busy_poll_warned = true;
+    LOG(WARNING) << "could not enable SO_BUSY_POLL on accepted sockets "
+                    "(needs CAP_NET_ADMIN) m="
+                 << ec.message() << "\n";
+  }
+#else
+  if (!busy_poll_warned) {
+    busy_poll_warned = true;
+    LOG(WARNING) << "SO_BUSY_POLL is not supported on this platform\n";
+  }
+#endif
+}
 }  // namespace asyik
 
 #endif
@@ -153,6 +153,11 @@ class http_request : public std::enable_shared_from_this<http_request> {
         : beast_response(),
           headers(beast_response.base()),
           body(beast_response.body()){};
+    explicit response(const http_fields::allocator_type& alloc)
+        : beast_response(std::piecewise_construct, std::make_tuple(),
+                         std::make_tuple(alloc)),
+          headers(beast_response.base()),
+          body(beast_response.body()){};
     http_beast_response beast_response;
     http_response_headers& headers;
     http_response_body& body;
@@ -162,7 +167,45 @@ class http_request : public std::enable_shared_from_this<http_request> {
 
   void activate_direct_response_handling() { manual_response = true; }
 
+ protected:
+  // A request whose header fields, and those of its response, allocate with
+  // @p alloc for as long as it lives; multipart_response stays on the heap
+  explicit http_request(const http_fields::allocator_type& alloc)
+      : beast_request(std::piecewise_construct, std::make_tuple(),
+                      std::make_tuple(alloc)),
+        headers(beast_request.base()),
+        body(beast_request.body()),
+        response(alloc),
+        multipart_response(),
+        manual_response(false){};
+
+  // Empties the request and its response for the next request on the
+  // connection and rewinds @p arena, which their header fields allocate from.
+  void recycle(request_arena& arena)
+  {
+    auto alloc = beast_request.get_allocator();
+    beast_request.base() = http_request_headers(alloc);
+    response.beast_response.base() = http_response_headers(alloc);
+    arena.reset();
+    // keep the capacity of the bodies, unless one of them got large
+    for (auto* body : {&beast_request.body(), &response.beast_response.body()})
+      if (body->capacity() > max_recycled_body)
+        std::string().swap(*body);
+      else
+        body->clear();
+  }
+
+  // Drops the header fields before the arena they allocated from goes away.
+  void release_fields() noexcept
+  {
+    auto alloc = beast_request.get_allocator();
+    beast_request.base() = http_request_headers(alloc);
+    response.beast_response.base() = http_response_headers(alloc);
+  }
+
  private:
+  static constexpr std::size_t max_recycled_body = 64 * 1024;
+
   boost::beast::flat_buffer buffer;
   bool manual_response;
   boost::any connection_wptr;
@@ -9,9 +9,13 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/ssl.hpp>
 #include <boost/fiber/mutex.hpp>
+#include <chrono>
+#include <cstring>
+#include <initializer_list>
 #include <regex>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "asyik_fwd.hpp"
@@ -21,6 +25,7 @@
 #include "error.hpp"
 #include "http_static.hpp"
 #include "http_types.hpp"
+#include "internal/http_scanner.hpp"
 #include "object_pool.hpp"
 #include "route_table.hpp"
 #include "service.hpp"
@@ -51,6 +56,177 @@ namespace internal {
 std::string route_spec_to_regex(string_view route_spc);
 }
 
+/// The http_request of a server connection. Its header fields, and those of
+/// its response, allocate from the arena it carries, so that a keep-alive
+/// connection does not go to the heap for them. Client requests have no use
+/// for the arena and do without it.
+class http_server_request : public http_request {
+ public:
+  // the arena is only handed out, not used, before it is constructed
+  http_server_request() : http_request(http_fields::allocator_type(&arena)) {}
+  ~http_server_request() { release_fields(); }
+
+ private:
+  void recycle() { http_request::recycle(arena); }
+
+  request_arena arena;
+
+  template <typename StreamType>
+  friend class http_connection;
+};
+
+/// A request served by an on_http_request_view() handler. Target, headers,
+/// body and route arguments are views into the connection's read buffer (or
+/// into the request beast parsed, for what the SIMD scanner leaves to it),
+/// valid until the handler returns: copy whatever has to outlive it. The
+/// response is filled in as with http_request.
+class http_request_view {
+ public:
+  http_request_view(const http_request_view&) = delete;
+  http_request_view& operator=(const http_request_view&) = delete;
+
+  string_view method() const { return method_; }
+  string_view target() const { return target_; }
+  unsigned version() const { return version_; }
+  string_view body() const { return body_; }
+
+  /// Value of the first header named @p name, compared case-insensitively,
+  /// or an empty view.
+  string_view header(string_view name) const
+  {
+    if (beast_) {
+      auto it = beast_->find(name);
+      return it == beast_->end() ? string_view{} : it->value();
+    }
+    return head_->field(name);
+  }
+
+  string_view operator[](string_view name) const { return header(name); }
+
+  /// Calls @p f(name, value) for every header, in the order received.
+  template <typename F>
+  void for_each_header(F&& f) const
+  {
+    if (beast_) {
+      for (const auto& h : beast_->base()) f(h.name_string(), h.value());
+      return;
+    }
+    for (std::size_t i = 0; i < head_->num_headers; ++i)
+      f(head_->headers[i].name, head_->headers[i].value);
+  }
+
+  /// Whether the connection persists after this request, as
+  /// beast::http::message::keep_alive() has it.
+  bool keep_alive() const
+  {
+    if (beast_) return beast_->keep_alive();
+    bool close = false, keep = false;
+    for (auto token : beast::http::token_list{header("connection")}) {
+      close = close || boost::iequals(token, "close");
+      keep = keep || boost::iequals(token, "keep-alive");
+    }
+    return version_ >= 11 ? !close : keep;
+  }
+
+  decltype(http_request::response)& response;
+
+ private:
+  // scanned by the SIMD parser engine, still at the front of @p buffer
+  http_request_view(const internal::http_scanner::request_head& head,
+                    const beast::flat_buffer& buffer, http_request& owner)
+      : response(owner.response),
+        method_(head.method),
+        target_(head.target),
+        body_(static_cast<const char*>(buffer.data().data()) + head.size,
+              head.content_length),
+        version_(head.version),
+        head_(&head)
+  {}
+
+  // parsed by beast
+  explicit http_request_view(http_request& owner)
+      : response(owner.response),
+        method_(owner.beast_request.method_string()),
+        target_(owner.beast_request.target()),
+        body_(owner.body),
+        version_(owner.beast_request.version()),
+        beast_(&owner.beast_request)
+  {}
+
+  string_view method_;
+  string_view target_;
+  string_view body_;
+  unsigned version_;
+  const internal::http_scanner::request_head* head_ = nullptr;
+  const http_beast_request* beast_ = nullptr;
+
+  template <typename StreamType>
+  friend class http_connection;
+};
+
+/// A response serialized once, up front: status line, headers and body.
+/// Routes registered with on_http_request_template() answer with a copy of
+/// its bytes, with the Date and Content-Length headers patched in, instead of
+/// building and serializing a beast response for every request.
+class http_response_template {
+ public:
+  using header_list =
+      std::initializer_list<std::pair<string_view, string_view>>;
+
+  /// @p headers go out in the order given, after a Server header unless they
+  /// set one. Date and Content-Length are added to them, and they may not set
+  /// those, Connection or Transfer-Encoding (invalid_input_error).
+  explicit http_response_template(http_result status, header_list headers = {},
+                                  string_view body = "");
+
+  http_result status() const { return status_; }
+  string_view body() const { return body_; }
+
+ private:
+  static constexpr std::size_t length_digits = 20;
+
+  // Appends the response to @p out, with body_ or, when a handler filled it
+  // in, with @p body.
+  void write(beast::flat_buffer& out, string_view date) const
+  {
+    auto* p = static_cast<char*>(out.prepare(full_.size()).data());
+    std::memcpy(p, full_.data(), full_.size());
+    std::memcpy(p + date_at_, date.data(), date.size());
+    out.commit(full_.size());
+  }
+
+  void write(beast::flat_buffer& out, string_view date, string_view body) const
+  {
+    auto size = head_.size() + body.size();
+    auto* p = static_cast<char*>(out.prepare(size).data());
+    std::memcpy(p, head_.data(), head_.size());
+    std::memcpy(p + date_at_, date.data(), date.size());
+    // right-aligned in the field, after as much whitespace as it takes
+    char* digit = p + head_.size() - 4;
+    auto n = body.size();
+    do {
+      *--digit = static_cast<char>('0' + n % 10);
+      n /= 10;
+    } while (n);
+    if (body.size()) std::memcpy(p + head_.size(), body.data(), body.size());
+    out.commit(size);
+  }
+
+  // The same response as a beast message, for the requests write() does not
+  // suit: HTTP/1.0 clients and connections about to close.
+  void fill(http_beast_response& res) const;
+
+  http_result status_;
+  std::vector<std::pair<std::string, std::string>> headers_;
+  std::string body_;
+  std::string head_;  // ends in a Content-Length of blanks and the empty line
+  std::string full_;  // the whole response with body_
+  std::size_t date_at_ = 0;
+
+  template <typename StreamType>
+  friend class http_connection;
+};
+
 template <typename StreamType>
 class http_server
     : public std::enable_shared_from_this<http_server<StreamType>> {
@@ -94,9 +270,56 @@ class http_server
   template <typename R, typename M, typename T>
   void on_http_request_regex(R&& r, M&& m, T&& cb, bool insert_front = false)
   {
+    std::string label = regex_label(r);
     auto route = http_route_tuple{std::string{std::forward<M>(m)},
                                   std::forward<R>(r), std::forward<T>(cb)};
-    http_route_table_.add_regex_route(std::move(route), insert_front);
+    http_route_table_.add_regex_route(std::move(route), insert_front, label);
+  }
+
+  /// Serve @p route_spec with a handler taking an http_request_view and its
+  /// route arguments as views, instead of an http_request: with
+  /// http_parser_engine::simd, a keep-alive request then costs no allocation
+  /// until the handler runs. These routes are tried before the ones above;
+  /// raw regex routes are not supported.
+  template <typename T,
+            std::enable_if_t<
+                !std::is_convertible_v<std::decay_t<T>, string_view>, int> = 0>
+  void on_http_request_view(string_view route_spec, T&& cb,
+                            bool insert_front = false)
+  {
+    http_view_route_table_.add_route(route_spec, "", std::forward<T>(cb),
+                                     insert_front);
+  }
+
+  template <typename T>
+  void on_http_request_view(string_view route_spec, string_view method,
+                            T&& cb, bool insert_front = false)
+  {
+    http_view_route_table_.add_route(route_spec, method, std::forward<T>(cb),
+                                     insert_front);
+  }
+
+  /// Answer @p route_spec with @p tmpl as it is, without running a handler.
+  /// Like view routes, these are tried before the regular ones.
+  void on_http_request_template(string_view route_spec, string_view method,
+                                http_response_template tmpl,
+                                bool insert_front = false)
+  {
+    http_view_route_table_.add_route(
+        route_spec, method, {}, insert_front,
+        std::make_shared<const http_response_template>(std::move(tmpl)));
+  }
+
+  /// Same, with an http_request_view handler that sets the body in
+  /// req.response.body; status and headers are the template's.
+  template <typename T>
+  void on_http_request_template(string_view route_spec, string_view method,
+                                http_response_template tmpl, T&& cb,
+                                bool insert_front = false)
+  {
+    http_view_route_table_.add_route(
+        route_spec, method, std::forward<T>(cb), insert_front,
+        std::make_shared<const http_response_template>(std::move(tmpl)));
   }
 
   template <typename T,
@@ -113,9 +336,10 @@ class http_server
   template <typename R, typename T>
   void on_websocket_regex(R&& r, T&& cb, bool insert_front = false)
   {
+    std::string label = regex_label(r);
     auto route =
         websocket_route_tuple{"", std::forward<R>(r), std::forward<T>(cb)};
-    ws_route_table_.add_regex_route(std::move(route), insert_front);
+    ws_route_table_.add_regex_route(std::move(route), insert_front, label);
   }
   /// Serve static files from @p root_dir under the URL prefix @p url_prefix.
   ///
@@ -156,6 +380,9 @@ class http_server
     auto p =
         boost::any_cast<http_connection_wptr<stream_type>>(req.connection_wptr);
     if (auto connection = p.lock()) {
+      // the handler takes the stream over: answer the pipelined requests
+      // before it
+      connection->flush_responses();
       return connection;
     }
     return nullptr;
@@ -169,6 +396,40 @@ class http_server
 
   void set_request_body_limit(size_t l) { request_body_limit = l; }
 
+  /// Close connections that take longer than @p t to deliver a request,
+  /// including keep-alive connections waiting for their next one. The
+  /// timeouts run on the service timer wheel, so they cost next to nothing
+  /// per request. 0 (the default) waits forever.
+  void set_idle_timeout(std::chrono::steady_clock::duration t)
+  {
+    idle_timeout = t;
+  }
+
+  std::chrono::steady_clock::duration get_idle_timeout() const
+  {
+    return idle_timeout;
+  }
+
+  /// Ask the kernel to busy-poll the device queue for up to @p t when a read
+  /// on an accepted connection finds no data, instead of waiting for the
+  /// interrupt (SO_BUSY_POLL, plus SO_PREFER_BUSY_POLL where available).
+  /// Pairs with service_run_mode::busy_poll. Raising SO_BUSY_POLL needs
+  /// CAP_NET_ADMIN; without it the option is skipped with a single warning.
+  /// Linux only, 0 (the default) leaves the sockets alone.
+  void set_busy_poll(std::chrono::microseconds t) { busy_poll = t; }
+
+  std::chrono::microseconds get_busy_poll() const { return busy_poll; }
+
+  /// Pick the parser for the head of incoming requests. With
+  /// http_parser_engine::simd, the request line and headers are scanned in
+  /// place in the connection buffer (AVX2 or SSE4.2 where the CPU has it)
+  /// and copied into the request once; chunked bodies and malformed input
+  /// still go through beast. Handlers see the same http_request either way.
+  /// Applies to connections accepted afterwards.
+  void set_parser_engine(http_parser_engine e) { parser_engine = e; }
+
+  http_parser_engine get_parser_engine() const { return parser_engine; }
+
   /// Stop accepting new connections AND forcefully close all currently active
   /// connections.  Closing the underlying sockets cancels any pending
   /// async_read / async_write operations with operation_aborted, which lets
@@ -204,6 +465,20 @@ class http_server
 
  private:
   void start_accept(asio::io_context& io_service);
+  void apply_busy_poll(tcp::socket& socket);
+
+  // names a raw regex route in watchdog reports: its pattern, if it was
+  // given as a string
+  template <typename R>
+  static std::string regex_label(const R& r)
+  {
+    if constexpr (std::is_convertible_v<const R&, string_view>) {
+      string_view v = r;
+      return std::string(v.data(), v.size());
+    } else {
+      return "<regex>";
+    }
+  }
 
   /// Register a freshly-accepted connection so that close() can reach it.
   /// Opportunistically prunes expired weak_ptrs to keep the vector bounded.
@@ -222,29 +497,39 @@ class http_server
   }
 
   template <typename ReqType>
-  const websocket_route_tuple& find_websocket_route(const ReqType& req,
-                                                    http_route_args& a) const
+  const websocket_route_tuple& find_websocket_route(
+      const ReqType& req, http_route_args& a,
+      string_view* spec = nullptr) const
   {
-    return ws_route_table_.find(req, a);
+    return ws_route_table_.find(req, a, spec);
   }
 
   template <typename ReqType>
   const http_route_tuple& find_http_route(const ReqType& req,
-                                          http_route_args& a) const
+                                          http_route_args& a,
+                                          string_view* spec = nullptr) const
   {
-    return http_route_table_.find(req, a);
+    return http_route_table_.find(req, a, spec);
+  }
+
+  const view_route_table::route* find_http_view_route(
+      string_view method, string_view target, http_route_view_args& a) const
+  {
+    if (http_view_route_table_.empty()) return nullptr;
+    return http_view_route_table_.find(method, target, a);
   }
 
   std::shared_ptr<ip::tcp::acceptor> acceptor;
   service_wptr service;
 
   route_table<http_route_tuple> http_route_table_;
+  view_route_table http_view_route_table_;
   route_table<websocket_route_tuple> ws_route_table_;
 
   std::shared_ptr<ssl::context> ssl_context;
 
   std::shared_ptr<shared_object_pool<http_connection<StreamType>>> conn_pool_;
-  std::shared_ptr<shared_object_pool<http_request>> req_pool_;
+  std::shared_ptr<shared_object_pool<http_server_request>> req_pool_;
 
   // Tracking of live server-side connections so that close() can cancel
   // their pending async I/O.  Stored as weak_ptrs to avoid keeping
@@ -254,6 +539,10 @@ class http_server
 
   size_t request_body_limit;
   size_t request_header_limit;
+  std::chrono::steady_clock::duration idle_timeout{0};
+  std::chrono::microseconds busy_poll{0};
+  bool busy_poll_warned = false;
+  http_parser_engine parser_engine = http_parser_engine::beast;
 
   template <typename S>
   friend class http_connection;
@@ -308,6 +597,29 @@ class http_connection
   inline void handshake_if_ssl();
   inline void shutdown_ssl();
 
+  // HTTP/1.1 pipelining: parses a request already in @p buffer without
+  // reading, false if it is not complete yet
+  template <typename Parser>
+  bool parse_buffered(beast::flat_buffer& buffer, Parser& parser);
+  // serializes @p res behind the responses waiting to be flushed
+  void queue_response(http_beast_response& res);
+  // the same with the bytes of @p tmpl, and @p body unless it is null
+  void queue_response(const http_response_template& tmpl, string_view date,
+                      const http_response_body* body);
+  // writes the queued responses, if any, in one go
+  void flush_responses();
+
+  enum class scan_result { complete, need_more, fallback };
+  // http_parser_engine::simd: scans a request in @p buffer into @p head, body
+  // included; fallback leaves the buffer for beast to parse
+  scan_result scan_buffered(beast::flat_buffer& buffer,
+                            internal::http_scanner::request_head& head,
+                            size_t header_limit, size_t body_limit);
+  // copies the scanned request into @p req and consumes it
+  void fill_request(beast::flat_buffer& buffer,
+                    const internal::http_scanner::request_head& head,
+                    http_beast_request& req);
+
   http_server_wptr<StreamType> http_server;
   std::shared_ptr<ssl::context> ssl_context;
   StreamType stream;
@@ -315,6 +627,9 @@ class http_connection
   bool is_server_connection;
   tcp::endpoint remote_endpoint;
 
+  static constexpr std::size_t max_pending_response_bytes = 64 * 1024;
+  beast::flat_buffer pending_responses;
+
   template <typename S>
   friend class http_server;
 };
@@ -10,6 +10,8 @@
 #include <vector>
 
 #include "asyik_fwd.hpp"
+#include "common.hpp"
+#include "request_arena.hpp"
 
 namespace asyik {
 
@@ -22,10 +24,13 @@ static const size_t default_response_header_limit = 1 * 1024 * 1024;
 // Type aliases
 using http_route_args = std::vector<std::string>;
 
+// Header fields of a request the server is serving, and of its response,
+// allocate from the arena of their http_request; anywhere else from the heap
+using http_fields = boost::beast::http::basic_fields<arena_allocator<char>>;
 using http_beast_request =
-    boost::beast::http::request<boost::beast::http::string_body>;
+    boost::beast::http::request<boost::beast::http::string_body, http_fields>;
 using http_beast_response =
-    boost::beast::http::response<boost::beast::http::string_body>;
+    boost::beast::http::response<boost::beast::http::string_body, http_fields>;
 using http_request_headers = http_beast_request::header_type;
 using http_request_body = http_beast_request::body_type::value_type;
 using http_response_headers = http_beast_response::header_type;
@@ -36,6 +41,11 @@ using http_route_callback =
 using http_route_tuple =
     std::tuple<std::string, std::regex, http_route_callback>;
 
+// Route arguments of an http_request_view, pointing into the request target
+using http_route_view_args = std::vector<string_view>;
+using http_route_view_callback =
+    std::function<void(http_request_view&, const http_route_view_args&)>;
+
 using websocket_route_callback =
     std::function<void(websocket_ptr, const http_route_args&)>;
 using websocket_route_tuple =
@@ -43,6 +53,13 @@ using websocket_route_tuple =
 
 using websocket_close_code = boost::beast::websocket::close_code;
 
+// How an http_server reads the head of a request, see
+// http_server::set_parser_engine()
+enum class http_parser_engine {
+  beast,  // boost::beast::http::request_parser
+  simd,   // in-place vectorized scanner, beast for what it does not handle
+};
+
 }  // namespace asyik
 
 #endif
@@ -40,6 +40,12 @@ auto async_read_until(Args&&... args) -> boost::fibers::future<size_t>
                                        use_fiber_future);
 };
 
+template <typename Conn, typename... Args>
+auto async_read_some(Conn& con, Args&&... args) -> boost::fibers::future<size_t>
+{
+  return con.async_read_some(std::forward<Args>(args)..., use_fiber_future);
+}
+
 template <typename T>
 auto async_timer_wait(T&& p) -> boost::fibers::future<void>
 {
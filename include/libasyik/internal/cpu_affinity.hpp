@@ -0,0 +1,33 @@
+#ifndef LIBASYIK_ASYIK_CPU_AFFINITY_HPP
+#define LIBASYIK_ASYIK_CPU_AFFINITY_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace asyik {
+namespace internal {
+
+// CPUs the process may run on (the affinity of its main thread).
+std::vector<int> usable_cpus();
+
+// CPUs of a NUMA node as listed in sysfs; empty if the node is unknown.
+std::vector<int> numa_node_cpus(int node);
+
+// Restricts the calling thread to @p cpus; false if the kernel refused.
+bool pin_thread(const std::vector<int>& cpus);
+
+// CPUs that service_group pinned services to, counted per claim. Offload
+// threads keep off them; the generation changes with every claim and release
+// so that running threads notice.
+void reserve_cpus(const std::vector<int>& cpus);
+void release_cpus(const std::vector<int>& cpus);
+uint64_t reserved_cpus_generation();
+
+// Moves the calling offload thread onto @p cpus, or with none given onto
+// every usable CPU that is not reserved (all of them if that leaves none).
+void place_offload_thread(const std::vector<int>& cpus);
+
+}  // namespace internal
+}  // namespace asyik
+
+#endif  // LIBASYIK_ASYIK_CPU_AFFINITY_HPP
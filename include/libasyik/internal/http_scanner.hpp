@@ -0,0 +1,58 @@
+#ifndef LIBASYIK_ASYIK_HTTP_SCANNER_HPP
+#define LIBASYIK_ASYIK_HTTP_SCANNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "boost/utility/string_view.hpp"
+
+namespace asyik {
+namespace internal {
+namespace http_scanner {
+
+using string_view = boost::string_view;
+
+constexpr std::size_t max_headers = 64;
+
+struct header {
+  string_view name;
+  string_view value;
+};
+
+// Request line and headers of one HTTP/1.x request. Every view points into
+// the scanned input, so it is only valid until that input moves.
+struct request_head {
+  string_view method;
+  string_view target;
+  unsigned version = 11;  // 10 or 11, like beast::http::message::version()
+  header headers[max_headers];
+  std::size_t num_headers = 0;
+  std::size_t size = 0;  // bytes up to and including the empty line
+  uint64_t content_length = 0;
+
+  // value of the first field named @p name (ASCII case-insensitive), or ""
+  string_view field(string_view name) const;
+};
+
+enum class scan_status {
+  complete,  // head is filled in
+  partial,   // the head does not end within the input yet
+  fallback,  // malformed, or more than the scanner handles (chunked bodies,
+             // more than max_headers headers): let beast parse it instead
+};
+
+// picohttpparser-style scanner for the head of an HTTP/1.x request: finds
+// the request line and header fields in place, without copying. Runs of
+// target and field-value bytes are skipped 32 (AVX2) or 16 (SSE4.2) at a
+// time where the CPU has it, picked once at startup.
+scan_status scan_request(const char* data, std::size_t size,
+                         request_head& head);
+
+// "avx2", "sse4.2" or "scalar": the code path scan_request() uses
+const char* scan_isa();
+
+}  // namespace http_scanner
+}  // namespace internal
+}  // namespace asyik
+
+#endif
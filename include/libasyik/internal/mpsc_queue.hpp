@@ -0,0 +1,79 @@
+#ifndef LIBASYIK_ASYIK_MPSC_QUEUE_HPP
+#define LIBASYIK_ASYIK_MPSC_QUEUE_HPP
+
+#include <atomic>
+
+namespace asyik {
+namespace internal {
+
+// Hook for intrusive_mpsc_queue; derive queued node types from it.
+struct mpsc_node {
+  std::atomic<mpsc_node*> mpsc_next{nullptr};
+};
+
+// Intrusive, unbounded multi-producer/single-consumer queue (D. Vyukov's
+// algorithm). push() is wait-free: one exchange plus one store, no lock and
+// no allocation. pop() must only be called from a single consumer at a time.
+//
+// A producer interrupted between its exchange and its store leaves the queue
+// briefly "in flight": pop() returns nullptr while empty() is still false.
+// Consumers that want to park must therefore check empty(), not pop().
+template <typename Node>
+class intrusive_mpsc_queue {
+ public:
+  intrusive_mpsc_queue() : head_(&stub_), tail_(&stub_) {}
+  intrusive_mpsc_queue(const intrusive_mpsc_queue&) = delete;
+  intrusive_mpsc_queue& operator=(const intrusive_mpsc_queue&) = delete;
+
+  void push(Node* n) noexcept { push_(n); }
+
+  Node* pop() noexcept
+  {
+    mpsc_node* tail = tail_;
+    mpsc_node* next = tail->mpsc_next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (!next) return nullptr;
+      tail_ = tail = next;
+      next = next->mpsc_next.load(std::memory_order_acquire);
+    }
+    if (next) {
+      tail_ = next;
+      return static_cast<Node*>(tail);
+    }
+    if (tail != head_.load(std::memory_order_acquire))
+      return nullptr;  // a producer is half-way through push()
+
+    // tail is the last node: put the stub behind it so it can be unlinked
+    push_(&stub_);
+    next = tail->mpsc_next.load(std::memory_order_acquire);
+    if (next) {
+      tail_ = next;
+      return static_cast<Node*>(tail);
+    }
+    return nullptr;
+  }
+
+  // Consumer side: true once every pushed node has been popped.
+  bool empty() const noexcept
+  {
+    return tail_ == &stub_ && head_.load(std::memory_order_seq_cst) == &stub_;
+  }
+
+ private:
+  void push_(mpsc_node* n) noexcept
+  {
+    n->mpsc_next.store(nullptr, std::memory_order_relaxed);
+    mpsc_node* prev = head_.exchange(n, std::memory_order_seq_cst);
+    prev->mpsc_next.store(n, std::memory_order_release);
+  }
+
+  // producers and consumer work on opposite ends; keep them apart
+  alignas(64) std::atomic<mpsc_node*> head_;
+  alignas(64) mpsc_node* tail_;
+  mpsc_node stub_;
+};
+
+}  // namespace internal
+}  // namespace asyik
+
+#endif  // LIBASYIK_ASYIK_MPSC_QUEUE_HPP
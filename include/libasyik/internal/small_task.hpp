@@ -0,0 +1,129 @@
+#ifndef LIBASYIK_ASYIK_SMALL_TASK_HPP
+#define LIBASYIK_ASYIK_SMALL_TASK_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace asyik {
+namespace internal {
+
+// Move-only, type-erased void() callable.
+//
+// Unlike std::function it does not need a copyable target (so a task can own
+// a fibers::promise directly) and keeps targets of up to inline_size bytes in
+// place instead of on the heap; only larger ones are heap-allocated.
+class small_task {
+ public:
+  static constexpr std::size_t inline_size = 96;
+
+  small_task() noexcept = default;
+
+  template <typename F,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<F>::type, small_task>::value>::type>
+  small_task(F&& f)
+  {
+    using T = typename std::decay<F>::type;
+    if (fits<T>()) {
+      ::new (static_cast<void*>(&buf_)) T(std::forward<F>(f));
+      ops_ = &inline_ops<T>::value;
+    } else {
+      heap() = new T(std::forward<F>(f));
+      ops_ = &heap_ops<T>::value;
+    }
+  }
+
+  small_task(small_task&& o) noexcept { take(o); }
+
+  small_task& operator=(small_task&& o) noexcept
+  {
+    if (this != &o) {
+      reset();
+      take(o);
+    }
+    return *this;
+  }
+
+  small_task(const small_task&) = delete;
+  small_task& operator=(const small_task&) = delete;
+
+  ~small_task() { reset(); }
+
+  explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+  void operator()() { ops_->invoke(&buf_); }
+
+ private:
+  struct ops_type {
+    void (*invoke)(void*);
+    void (*move)(void* dst, void* src) noexcept;
+    void (*destroy)(void*) noexcept;
+  };
+
+  template <typename T>
+  static constexpr bool fits()
+  {
+    return sizeof(T) <= inline_size &&
+           alignof(T) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible<T>::value;
+  }
+
+  template <typename T>
+  struct inline_ops {
+    static void invoke(void* p) { (*static_cast<T*>(p))(); }
+    static void move(void* dst, void* src) noexcept
+    {
+      ::new (dst) T(std::move(*static_cast<T*>(src)));
+      static_cast<T*>(src)->~T();
+    }
+    static void destroy(void* p) noexcept { static_cast<T*>(p)->~T(); }
+    static constexpr ops_type value{&invoke, &move, &destroy};
+  };
+
+  template <typename T>
+  struct heap_ops {
+    static void invoke(void* p) { (**static_cast<T**>(p))(); }
+    static void move(void* dst, void* src) noexcept
+    {
+      *static_cast<T**>(dst) = *static_cast<T**>(src);
+    }
+    static void destroy(void* p) noexcept { delete *static_cast<T**>(p); }
+    static constexpr ops_type value{&invoke, &move, &destroy};
+  };
+
+  void*& heap() noexcept { return *reinterpret_cast<void**>(&buf_); }
+
+  void take(small_task& o) noexcept
+  {
+    if ((ops_ = o.ops_)) {
+      ops_->move(&buf_, &o.buf_);
+      o.ops_ = nullptr;
+    }
+  }
+
+  void reset() noexcept
+  {
+    if (ops_) {
+      auto* ops = ops_;
+      ops_ = nullptr;
+      ops->destroy(&buf_);
+    }
+  }
+
+  const ops_type* ops_ = nullptr;
+  typename std::aligned_storage<inline_size, alignof(std::max_align_t)>::type
+      buf_;
+};
+
+template <typename T>
+constexpr small_task::ops_type small_task::inline_ops<T>::value;
+
+template <typename T>
+constexpr small_task::ops_type small_task::heap_ops<T>::value;
+
+}  // namespace internal
+}  // namespace asyik
+
+#endif  // LIBASYIK_ASYIK_SMALL_TASK_HPP
@@ -0,0 +1,139 @@
+#ifndef LIBASYIK_ASYIK_TASK_STATS_HPP
+#define LIBASYIK_ASYIK_TASK_STATS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "../offload_pool.hpp"
+
+namespace asyik {
+namespace internal {
+
+// Task counters of a worker pool, split into cache-line aligned shards that
+// each thread picks by a thread-local slot, so that workers and submitters
+// do not keep bouncing one counter line between their cores. Threads only
+// share a shard when there are more of them than shards, which the relaxed
+// read-modify-writes tolerate. Reads add the shards up; the totals are not
+// a consistent snapshot of each other.
+class task_stats {
+ public:
+  struct totals {
+    uint64_t started = 0;
+    uint64_t terminated = 0;
+    uint64_t errors = 0;
+    int64_t queued = 0;  // pushed and not popped yet
+    uint64_t queue_wait_total_us = 0;
+    uint64_t queue_wait_max_us = 0;
+    uint64_t run_time_total_us = 0;
+    latency_histogram queue_wait;
+    latency_histogram run_time;
+  };
+
+  task_stats()
+  {
+    std::size_t n = 1;
+    while (n < std::thread::hardware_concurrency() && n < max_shards) n <<= 1;
+    shards_.reset(new shard[n]);
+    mask_ = n - 1;
+  }
+  task_stats(const task_stats&) = delete;
+  task_stats& operator=(const task_stats&) = delete;
+
+  // +1 on push, -1 on pop; the shards only add up to the queue length
+  void queued(int64_t n) noexcept { add(local().queued, n); }
+
+  // a task waited @p wait_us from push to pop
+  void waited(uint64_t wait_us) noexcept
+  {
+    auto& s = local();
+    add(s.queue_wait_total_us, wait_us);
+    add(s.queue_wait[latency_histogram::bucket(wait_us)], 1);
+    auto max = s.queue_wait_max_us.load(std::memory_order_relaxed);
+    while (max < wait_us &&
+           !s.queue_wait_max_us.compare_exchange_weak(
+               max, wait_us, std::memory_order_relaxed))
+      ;
+  }
+
+  void started() noexcept { add(local().started, 1); }
+
+  // a task ran @p run_us from start to end
+  void terminated(uint64_t run_us) noexcept
+  {
+    auto& s = local();
+    add(s.terminated, 1);
+    add(s.run_time_total_us, run_us);
+    add(s.run_time[latency_histogram::bucket(run_us)], 1);
+  }
+
+  void failed() noexcept { add(local().errors, 1); }
+
+  totals sum() const noexcept
+  {
+    totals t;
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      auto& s = shards_[i];
+      t.started += s.started.load(std::memory_order_relaxed);
+      t.terminated += s.terminated.load(std::memory_order_relaxed);
+      t.errors += s.errors.load(std::memory_order_relaxed);
+      t.queued += s.queued.load(std::memory_order_relaxed);
+      t.queue_wait_total_us +=
+          s.queue_wait_total_us.load(std::memory_order_relaxed);
+      t.queue_wait_max_us = std::max<uint64_t>(
+          t.queue_wait_max_us,
+          s.queue_wait_max_us.load(std::memory_order_relaxed));
+      t.run_time_total_us +=
+          s.run_time_total_us.load(std::memory_order_relaxed);
+      for (std::size_t b = 0; b < latency_histogram::buckets; ++b) {
+        t.queue_wait.counts[b] +=
+            s.queue_wait[b].load(std::memory_order_relaxed);
+        t.run_time.counts[b] += s.run_time[b].load(std::memory_order_relaxed);
+      }
+    }
+    return t;
+  }
+
+ private:
+  static constexpr std::size_t max_shards = 64;
+
+  struct alignas(64) shard {
+    std::atomic<uint64_t> started{0};
+    std::atomic<uint64_t> terminated{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<int64_t> queued{0};
+    std::atomic<uint64_t> queue_wait_total_us{0};
+    std::atomic<uint64_t> queue_wait_max_us{0};
+    std::atomic<uint64_t> run_time_total_us{0};
+    std::atomic<uint64_t> queue_wait[latency_histogram::buckets]{};
+    std::atomic<uint64_t> run_time[latency_histogram::buckets]{};
+  };
+
+  template <typename T, typename N>
+  static void add(std::atomic<T>& c, N n) noexcept
+  {
+    c.fetch_add(static_cast<T>(n), std::memory_order_relaxed);
+  }
+
+  // threads take consecutive slots, so the threads of a pool started
+  // around the same time land on different shards
+  static std::size_t slot() noexcept
+  {
+    static std::atomic<std::size_t> next{0};
+    static thread_local std::size_t s =
+        next.fetch_add(1, std::memory_order_relaxed);
+    return s;
+  }
+
+  shard& local() noexcept { return shards_[slot() & mask_]; }
+
+  std::unique_ptr<shard[]> shards_;
+  std::size_t mask_;
+};
+
+}  // namespace internal
+}  // namespace asyik
+
+#endif  // LIBASYIK_ASYIK_TASK_STATS_HPP
@@ -0,0 +1,259 @@
+#ifndef LIBASYIK_ASYIK_TIMER_WHEEL_HPP
+#define LIBASYIK_ASYIK_TIMER_WHEEL_HPP
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace asyik {
+namespace internal {
+
+struct timer_wheel_hook {
+  timer_wheel_hook* prev = nullptr;
+  timer_wheel_hook* next = nullptr;
+};
+
+// Timer on a timer_wheel; lives wherever its owner keeps it (typically the
+// stack of a sleeping fiber), the wheel only links it.
+struct timer_wheel_node : timer_wheel_hook {
+  // called once the node is due, already unlinked; may add or remove nodes
+  void (*on_expiry)(timer_wheel_node*) noexcept = nullptr;
+  uint64_t expiry = 0;  // tick
+  uint32_t slot = 0;    // level * slots + index, while linked
+
+  bool linked() const noexcept { return prev != nullptr; }
+};
+
+// Hierarchical hashed timer wheel with a fixed tick (the resolution).
+//
+// Four levels of 256 slots; level 0 holds the timers due within the next 256
+// ticks, one slot per tick, and every level above covers 256 times the range
+// of the one below in slots as wide. Adding and removing a timer is O(1).
+// When level 0 wraps around, the next slot of level 1 is cascaded into it,
+// and so on up. With a 1ms tick the levels reach about 49 days; timers
+// further out park in the top level and are cascaded again until due.
+//
+// Deadlines are rounded up to the next tick: a timer never fires early, and
+// up to one tick late. Not thread-safe; one wheel per scheduler thread.
+class timer_wheel {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  static constexpr unsigned slot_bits = 8;
+  static constexpr std::size_t slots = std::size_t(1) << slot_bits;
+  static constexpr std::size_t levels = 4;
+
+  explicit timer_wheel(
+      clock::duration resolution = std::chrono::milliseconds(1)) noexcept
+  {
+    for (auto& h : heads_) h.prev = h.next = &h;
+    set_resolution(resolution);
+  }
+
+  timer_wheel(const timer_wheel&) = delete;
+  timer_wheel& operator=(const timer_wheel&) = delete;
+
+  // Only while no timer is pending.
+  void set_resolution(clock::duration resolution) noexcept
+  {
+    BOOST_ASSERT(empty());
+    res_ = resolution.count() > 0 ? resolution : clock::duration(1);
+    origin_ = clock::now();
+    tick_ = 0;
+  }
+  clock::duration resolution() const noexcept { return res_; }
+
+  bool empty() const noexcept { return size_ == 0; }
+  std::size_t size() const noexcept { return size_; }
+
+  void add(timer_wheel_node* n, clock::time_point deadline) noexcept
+  {
+    BOOST_ASSERT(!n->linked());
+    auto since = deadline - origin_;
+    uint64_t t = since.count() <= 0
+                     ? 0
+                     : uint64_t((since.count() + res_.count() - 1) /
+                                res_.count());
+    n->expiry = t < tick_ ? tick_ : t;
+    link_(n);
+    ++size_;
+  }
+
+  void remove(timer_wheel_node* n) noexcept
+  {
+    if (!n->linked()) return;
+    unlink_(n);
+    --size_;
+  }
+
+  // Fires every timer due by @p now.
+  void advance(clock::time_point now) noexcept
+  {
+    auto since = now - origin_;
+    if (since.count() < 0) return;
+    uint64_t last = uint64_t(since.count() / res_.count());
+    while (tick_ <= last) {
+      if (empty()) {
+        tick_ = last + 1;
+        break;
+      }
+      std::size_t idx = tick_ & (slots - 1);
+      if (idx == 0) cascade_();
+      if (test_(idx)) fire_(idx);
+      ++tick_;
+      // skip the ticks with nothing to do, up to the next cascade
+      if (tick_ & (slots - 1)) {
+        std::size_t next = find_(0, tick_ & (slots - 1));
+        uint64_t to = next < slots ? (tick_ & ~uint64_t(slots - 1)) + next
+                                   : (tick_ | (slots - 1)) + 1;
+        tick_ = to < last + 1 ? to : last + 1;
+      }
+    }
+  }
+
+  // Fires the pending timers now, e.g. to wake all sleepers at shutdown.
+  // Timers their callbacks add may be left pending.
+  void expire_all() noexcept
+  {
+    for (std::size_t s = 0; s < slots * levels && !empty(); ++s)
+      if (test_(s)) fire_(s);
+  }
+
+  // Time by which advance() has something to do, max() if nothing is
+  // pending. Timers in the upper levels only count with their cascade, so
+  // this may be earlier than the next timer.
+  clock::time_point next_expiry() const noexcept
+  {
+    if (empty()) return (clock::time_point::max)();
+    uint64_t base = tick_ & ~uint64_t(slots - 1);
+    uint64_t boundary = base + slots;
+    bool upper = false;
+    for (std::size_t w = slots / 64; w < words; ++w) upper |= bits_[w] != 0;
+    // the upper levels cascade when level 0 starts over, which may be the
+    // very next tick
+    uint64_t t = upper ? (tick_ == base ? tick_ : boundary)
+                       : (std::numeric_limits<uint64_t>::max)();
+    std::size_t s = find_(0, tick_ & (slots - 1));
+    if (s < slots)
+      t = std::min(t, base + s);
+    else if ((s = find_(0, 0)) < slots)
+      t = std::min(t, boundary + s);  // wrapped around, due in the next round
+    return origin_ + res_ * int64_t(t);
+  }
+
+ private:
+  static constexpr std::size_t words = slots * levels / 64;
+
+  timer_wheel_hook heads_[slots * levels];
+  uint64_t bits_[words] = {};  // non-empty slots
+  clock::duration res_{};
+  clock::time_point origin_{};
+  uint64_t tick_ = 0;  // next tick to process
+  std::size_t size_ = 0;
+
+  void link_(timer_wheel_node* n) noexcept
+  {
+    uint64_t e = n->expiry;
+    uint64_t delta = e - tick_;
+    std::size_t level = 0;
+    while (level + 1 < levels && (delta >> (slot_bits * (level + 1))) != 0)
+      ++level;
+    if (level == levels - 1) {
+      // beyond the top level: park in its farthest slot
+      uint64_t span = uint64_t(1) << (slot_bits * levels);
+      if (delta >= span) e = tick_ + span - 1;
+    }
+    std::size_t s =
+        level * slots + ((e >> (slot_bits * level)) & (slots - 1));
+    n->slot = uint32_t(s);
+    timer_wheel_hook* h = &heads_[s];
+    n->prev = h->prev;
+    n->next = h;
+    h->prev->next = n;
+    h->prev = n;
+    bits_[s / 64] |= uint64_t(1) << (s % 64);
+  }
+
+  void unlink_(timer_wheel_node* n) noexcept
+  {
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->prev = n->next = nullptr;
+    timer_wheel_hook* h = &heads_[n->slot];
+    if (h->next == h) bits_[n->slot / 64] &= ~(uint64_t(1) << (n->slot % 64));
+  }
+
+  bool test_(std::size_t s) const noexcept
+  {
+    return bits_[s / 64] & (uint64_t(1) << (s % 64));
+  }
+
+  // first non-empty slot >= from in @p level, slots if none
+  std::size_t find_(std::size_t level, std::size_t from) const noexcept
+  {
+    const uint64_t* w = bits_ + level * (slots / 64);
+    for (std::size_t i = from / 64; i < slots / 64; ++i) {
+      uint64_t b = w[i];
+      if (i == from / 64) b &= ~uint64_t(0) << (from % 64);
+      if (b) return i * 64 + std::size_t(__builtin_ctzll(b));
+    }
+    return slots;
+  }
+
+  // Moves the slots of the upper levels that come due in the next 256
+  // ticks down, starting at the lowest.
+  void cascade_() noexcept
+  {
+    for (std::size_t level = 1; level < levels; ++level) {
+      std::size_t idx = (tick_ >> (slot_bits * level)) & (slots - 1);
+      std::size_t s = level * slots + idx;
+      if (test_(s)) {
+        timer_wheel_hook list;
+        take_(s, list);
+        while (list.next != &list) {
+          auto* n = static_cast<timer_wheel_node*>(list.next);
+          list.next = n->next;
+          n->next->prev = &list;
+          link_(n);
+        }
+      }
+      if (idx != 0) break;
+    }
+  }
+
+  // Fires the timers of slot @p s. Callbacks may add to the slot meanwhile,
+  // those only fire on the next pass.
+  void fire_(std::size_t s) noexcept
+  {
+    timer_wheel_hook list;
+    take_(s, list);
+    while (list.next != &list) {
+      auto* n = static_cast<timer_wheel_node*>(list.next);
+      // unlinks from the local list; so does remove() on a node still in it
+      // (a callback cancelling a timer due in the same tick)
+      unlink_(n);
+      --size_;
+      n->on_expiry(n);
+    }
+  }
+
+  // Moves the timers of slot @p s to @p list and leaves the slot empty.
+  void take_(std::size_t s, timer_wheel_hook& list) noexcept
+  {
+    timer_wheel_hook* h = &heads_[s];
+    list.next = h->next;
+    list.prev = h->prev;
+    list.next->prev = &list;
+    list.prev->next = &list;
+    h->prev = h->next = h;
+    bits_[s / 64] &= ~(uint64_t(1) << (s % 64));
+  }
+};
+
+}  // namespace internal
+}  // namespace asyik
+
+#endif  // LIBASYIK_ASYIK_TIMER_WHEEL_HPP
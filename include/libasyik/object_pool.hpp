@@ -7,12 +7,18 @@
 #include <new>
 #include <vector>
 
+#include "boost/lockfree/stack.hpp"
+
 namespace asyik {
 
 /// A block-level free-list that pools fixed-size memory blocks.
 /// Thread-safe (mutex-protected).  Held via shared_ptr so that
 /// pool_allocator instances (captured inside shared_ptr control blocks)
 /// keep it alive.
+///
+/// Every request of up to block_size bytes gets a whole block, so a block
+/// freed by a small object can be handed to a bigger one later.  Bigger
+/// requests go straight to the heap.
 class block_pool {
  public:
   explicit block_pool(std::size_t block_size) : block_size_(block_size) {}
@@ -34,6 +40,7 @@ class block_pool {
         free_list_.pop_back();
         return p;
       }
+      return ::operator new(block_size_);
     }
     return ::operator new(bytes);
   }
@@ -54,20 +61,59 @@ class block_pool {
   std::vector<void*> free_list_;
 };
 
-/// STL-compatible allocator backed by a shared block_pool.
-/// Used with std::allocate_shared so that the shared_ptr control block
-/// AND the object are placed in a single pooled allocation.
-template <typename T>
+/// block_pool without the mutex, for blocks taken and returned from many
+/// threads at once.  The free blocks sit in a bounded lock-free stack; up to
+/// max_free of them are kept, the rest go back to the heap.
+class lockfree_block_pool {
+ public:
+  lockfree_block_pool(std::size_t block_size, std::size_t max_free)
+      : block_size_(block_size), free_list_(max_free)
+  {}
+
+  ~lockfree_block_pool()
+  {
+    free_list_.consume_all([](void* p) { ::operator delete(p); });
+  }
+
+  lockfree_block_pool(const lockfree_block_pool&) = delete;
+  lockfree_block_pool& operator=(const lockfree_block_pool&) = delete;
+
+  void* allocate(std::size_t bytes)
+  {
+    if (bytes > block_size_) return ::operator new(bytes);
+    void* p;
+    if (free_list_.pop(p)) return p;
+    return ::operator new(block_size_);
+  }
+
+  void deallocate(void* p, std::size_t bytes) noexcept
+  {
+    if (bytes > block_size_ || !free_list_.bounded_push(p))
+      ::operator delete(p);
+  }
+
+ private:
+  std::size_t block_size_;
+  boost::lockfree::stack<void*, boost::lockfree::fixed_sized<true>>
+      free_list_;
+};
+
+/// STL-compatible allocator backed by a shared block_pool (or
+/// lockfree_block_pool).  Used with std::allocate_shared so that the
+/// shared_ptr control block AND the object are placed in a single pooled
+/// allocation.
+template <typename T, typename Pool = block_pool>
 class pool_allocator {
  public:
   using value_type = T;
 
-  explicit pool_allocator(std::shared_ptr<block_pool> pool) noexcept
+  explicit pool_allocator(std::shared_ptr<Pool> pool) noexcept
       : pool_(std::move(pool))
   {}
 
   template <typename U>
-  pool_allocator(const pool_allocator<U>& other) noexcept : pool_(other.pool_)
+  pool_allocator(const pool_allocator<U, Pool>& other) noexcept
+      : pool_(other.pool_)
   {}
 
   T* allocate(std::size_t n)
@@ -81,21 +127,21 @@ class pool_allocator {
   }
 
   template <typename U>
-  bool operator==(const pool_allocator<U>& other) const noexcept
+  bool operator==(const pool_allocator<U, Pool>& other) const noexcept
   {
     return pool_ == other.pool_;
   }
 
   template <typename U>
-  bool operator!=(const pool_allocator<U>& other) const noexcept
+  bool operator!=(const pool_allocator<U, Pool>& other) const noexcept
   {
     return !(*this == other);
   }
 
  private:
-  std::shared_ptr<block_pool> pool_;
+  std::shared_ptr<Pool> pool_;
 
-  template <typename U>
+  template <typename U, typename P>
   friend class pool_allocator;
 };
 
@@ -0,0 +1,145 @@
+#ifndef LIBASYIK_ASYIK_OFFLOAD_POOL_HPP
+#define LIBASYIK_ASYIK_OFFLOAD_POOL_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "internal/small_task.hpp"
+
+namespace asyik {
+
+class offload_pool;
+using offload_pool_ptr = std::shared_ptr<offload_pool>;
+
+struct offload_pool_config {
+  // threads kept alive while idle; started together with the pool
+  std::size_t min_threads = 0;
+  // upper bound the pool grows to under load, 0 = hardware_concurrency()
+  std::size_t max_threads = 0;
+  // queue capacity, rounded up to a power of two; submit() waits
+  // (fiber-aware) while the queue is full
+  std::size_t max_queue = 1024;
+  // threads above min_threads exit after being idle this long
+  std::chrono::milliseconds idle_timeout{10000};
+  // nice value of the pool threads (Linux); lowering it below 0 needs
+  // CAP_SYS_NICE and is ignored with a warning otherwise
+  int priority = 0;
+  // CPUs the pool threads run on; empty = every CPU that no service_group
+  // has pinned a service to
+  std::vector<int> cpus;
+};
+
+// Durations in microseconds, in power-of-two buckets: counts[0] holds those
+// under 1us, counts[i] those from 2^(i-1) up to 2^i us, and the last bucket
+// everything from about 67s on.
+struct latency_histogram {
+  static constexpr std::size_t buckets = 28;
+  std::array<uint64_t, buckets> counts{};
+
+  static std::size_t bucket(uint64_t us) noexcept
+  {
+    std::size_t b = 0;
+    while (us && b < buckets - 1) {
+      us >>= 1;
+      ++b;
+    }
+    return b;
+  }
+
+  // upper end of bucket @p b in us (the last one is open-ended)
+  static uint64_t bucket_limit_us(std::size_t b) noexcept
+  {
+    return uint64_t(1) << b;
+  }
+
+  uint64_t total() const noexcept
+  {
+    uint64_t n = 0;
+    for (auto c : counts) n += c;
+    return n;
+  }
+
+  // Upper end of the bucket the @p q quantile (0.5, 0.99, ...) falls in,
+  // i.e. at most twice the real value; 0 while empty.
+  uint64_t quantile_us(double q) const noexcept
+  {
+    uint64_t n = total();
+    if (!n) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * double(n - 1)) + 1, seen = 0;
+    for (std::size_t b = 0; b < buckets; ++b)
+      if ((seen += counts[b]) >= rank) return bucket_limit_us(b);
+    return bucket_limit_us(buckets - 1);
+  }
+};
+
+struct offload_pool_stats {
+  uint32_t threads;
+  uint32_t idle_threads;
+  uint32_t peak_threads;
+  uint32_t queue_size;
+
+  uint64_t task_started;
+  uint64_t task_terminated;
+
+  // time tasks spent queued before a worker picked them up
+  uint64_t queue_wait_total_us;
+  uint64_t queue_wait_max_us;
+  latency_histogram queue_wait;
+  // time from a task's start to its end, including the time its fiber
+  // waited on futures, channels or sleeps
+  uint64_t run_time_total_us;
+  latency_histogram run_time;
+};
+
+// A named pool of worker threads for blocking or CPU-heavy work.
+//
+// Threads are started on demand: a submitted task that finds no idle worker
+// starts a new one, up to max_threads, and threads above min_threads exit
+// again after idle_timeout. Like the default async() pool, every task runs in
+// its own fiber on the worker thread, so a task that waits on a fiber
+// primitive (future, channel, asyik::sleep_for) frees the thread for the
+// next task.
+//
+// Tasks are usually submitted through service::async(pool, f, args...).
+class offload_pool {
+ public:
+  using task_type = internal::small_task;
+
+  ~offload_pool();
+  offload_pool(const offload_pool&) = delete;
+  offload_pool& operator=(const offload_pool&) = delete;
+
+  // Queue a task. Blocks the calling fiber while a bounded queue is full.
+  void submit(task_type&& t);
+
+  const std::string& name() const;
+  const offload_pool_config& config() const;
+  offload_pool_stats get_stats() const;
+
+  // Stop accepting tasks; workers drain the queue, then exit.
+  void shutdown();
+
+ private:
+  struct core;
+  struct private_ {};
+
+ public:
+  offload_pool(private_, std::string name, const offload_pool_config& cfg);
+
+ private:
+  std::shared_ptr<core> core_;
+
+  friend offload_pool_ptr make_offload_pool(std::string name,
+                                            const offload_pool_config& cfg);
+};
+
+offload_pool_ptr make_offload_pool(std::string name,
+                                   const offload_pool_config& cfg = {});
+
+}  // namespace asyik
+
+#endif  // LIBASYIK_ASYIK_OFFLOAD_POOL_HPP
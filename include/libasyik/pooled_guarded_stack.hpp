@@ -3,15 +3,55 @@
 
 #include <sys/mman.h>
 
+#include <atomic>
 #include <boost/context/stack_context.hpp>
 #include <boost/context/stack_traits.hpp>
 #include <cassert>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace asyik {
 
+struct stack_pool_config {
+  // usable bytes per stack, rounded up to whole pages
+  std::size_t stack_size = boost::context::stack_traits::default_size();
+  // high-water mark: free stacks kept for reuse; a stack released while
+  // this many are already pooled is unmapped instead
+  std::size_t max_free = 4096;
+  // trim() leaves this many free stacks resident and hands the memory of
+  // the others back to the kernel (madvise), keeping their mappings
+  std::size_t trim_keep = 64;
+  // carve stacks out of huge-page slabs (MAP_HUGETLB, falling back to
+  // transparent huge pages) instead of mapping every stack on its own.
+  // Slab stacks have no guard page, and are neither unmapped nor trimmed.
+  bool huge_pages = false;
+  // slab size in huge_pages mode, rounded up to whole 2MB pages
+  std::size_t slab_size = 2 * 1024 * 1024;
+  // profiling: pattern-fill stacks and measure how deep each fiber got
+  // before its stack came back; costs a scan of the used part per fiber
+  bool measure_usage = false;
+  // called with the peak bytes a fiber used and the usable stack size, on
+  // the thread that deallocates the stack (measure_usage only)
+  std::function<void(std::size_t used, std::size_t size)> on_usage;
+};
+
+struct stack_pool_stats {
+  std::size_t in_use;    // handed out to fibers
+  std::size_t free;      // pooled for reuse, trimmed ones included
+  std::size_t trimmed;   // free stacks whose memory trim() released
+  std::size_t mapped;    // in use + free
+  std::size_t max_used;  // deepest stack use seen (measure_usage only)
+};
+
 /// A fiber stack allocator that combines pooling with mmap guard pages.
 ///
 /// Each stack is allocated via mmap with an extra guard page at the bottom
@@ -19,6 +59,17 @@ namespace asyik {
 /// free-list instead of being munmap'd. On reuse the guard page is still in
 /// place — no extra syscalls needed.
 ///
+/// The thread that allocates first becomes the owner (for a service, its
+/// run() thread) and keeps a private free-list that it uses without taking
+/// the mutex; other threads share a mutex-protected one. At most
+/// stack_pool_config::max_free stacks are pooled, and trim() releases the
+/// memory of all but trim_keep of them, so a spike of concurrent fibers
+/// does not pin its stacks for the lifetime of the process.
+///
+/// With stack_pool_config::measure_usage the stacks are pattern-filled, and
+/// the peak usage of every fiber is measured when its stack comes back, to
+/// size stacks from real numbers rather than guesses.
+///
 /// The internal storage is reference-counted (via shared_ptr), so copies of
 /// the allocator share the same pool — matching the semantics of
 /// boost::context::pooled_fixedsize_stack.
@@ -28,7 +79,11 @@ class pooled_guarded_stack {
 
   explicit pooled_guarded_stack(
       std::size_t stack_size = traits_type::default_size())
-      : impl_(std::make_shared<impl>(stack_size))
+      : pooled_guarded_stack(make_config(stack_size))
+  {}
+
+  explicit pooled_guarded_stack(const stack_pool_config& cfg)
+      : impl_(std::make_shared<impl>(cfg))
   {}
 
   boost::context::stack_context allocate() { return impl_->allocate(); }
@@ -38,57 +93,202 @@ class pooled_guarded_stack {
     impl_->deallocate(sctx);
   }
 
+  /// Release the memory of pooled stacks beyond trim_keep. The owner thread
+  /// trims its private free-list too, other threads only the shared one.
+  void trim() noexcept { impl_->trim(); }
+
+  stack_pool_stats get_stats() const noexcept { return impl_->stats(); }
+
+  std::size_t stack_size() const noexcept { return impl_->stack_size_; }
+
  private:
+  static stack_pool_config make_config(std::size_t stack_size)
+  {
+    stack_pool_config cfg;
+    cfg.stack_size = stack_size;
+    return cfg;
+  }
+
+  // Free stacks, identified by their top (stack_context::sp). Trimmed ones
+  // are kept apart so trim() does not madvise them again and allocate()
+  // prefers stacks that are still resident.
+  struct free_list {
+    std::vector<void*> hot;   // most recently released last
+    std::vector<void*> cold;  // memory released by trim()
+
+    void* pop(bool& was_trimmed) noexcept
+    {
+      auto& v = hot.empty() ? cold : hot;
+      if (v.empty()) return nullptr;
+      was_trimmed = &v == &cold;
+      void* sp = v.back();
+      v.pop_back();
+      return sp;
+    }
+  };
+
   struct impl {
-    explicit impl(std::size_t stack_size) : stack_size_(stack_size)
+    explicit impl(const stack_pool_config& cfg) : cfg_(cfg)
     {
       page_size_ = traits_type::page_size();
       // Round stack_size up to a multiple of page_size
-      std::size_t pages = (stack_size_ + page_size_ - 1) / page_size_;
+      std::size_t pages = (cfg_.stack_size + page_size_ - 1) / page_size_;
       stack_size_ = pages * page_size_;
-      // Total mmap size: stack + 1 guard page
-      mmap_size_ = stack_size_ + page_size_;
+      // Total mmap size: stack + 1 guard page (no guard in slab mode)
+      mmap_size_ = cfg_.huge_pages ? stack_size_ : stack_size_ + page_size_;
     }
 
     ~impl()
     {
-      for (void* base : free_list_) {
-        ::munmap(base, mmap_size_);
+      if (cfg_.huge_pages) {
+        for (auto& s : slabs_) ::munmap(s.first, s.second);
+        return;
       }
+      for (auto* fl : {&local_, &shared_})
+        for (auto* v : {&fl->hot, &fl->cold})
+          for (void* sp : *v) ::munmap(base_of(sp), mmap_size_);
     }
 
     boost::context::stack_context allocate()
     {
-      void* base = pop_or_mmap();
+      void* sp = nullptr;
+      bool was_trimmed = false;
+      if (is_owner(true)) sp = local_.pop(was_trimmed);
+      if (!sp) {
+        std::lock_guard<std::mutex> lk(mu_);
+        sp = shared_.pop(was_trimmed);
+      }
+      if (sp) {
+        free_.fetch_sub(1, std::memory_order_relaxed);
+        if (was_trimmed) {
+          trimmed_.fetch_sub(1, std::memory_order_relaxed);
+          // the kernel may have zeroed it
+          if (cfg_.measure_usage) fill(sp, stack_size_);
+        }
+      } else {
+        sp = cfg_.huge_pages ? from_slab() : map_stack();
+      }
+      in_use_.fetch_add(1, std::memory_order_relaxed);
 
       boost::context::stack_context sctx;
       sctx.size = stack_size_;
       // sp points to the TOP of the usable stack (stack grows downward)
       // Layout: [guard page | usable stack]
       //         base        base+page_size  base+page_size+stack_size (= sp)
-      sctx.sp = static_cast<char*>(base) + mmap_size_;
+      sctx.sp = sp;
       return sctx;
     }
 
     void deallocate(boost::context::stack_context& sctx) noexcept
     {
-      // Recover the mmap base from sp
-      void* base = static_cast<char*>(sctx.sp) - mmap_size_;
+      in_use_.fetch_sub(1, std::memory_order_relaxed);
+      if (cfg_.measure_usage) measure(sctx.sp);
+      // the high-water check is racy across threads by at most a few stacks
+      if (!cfg_.huge_pages &&
+          free_.load(std::memory_order_relaxed) >= cfg_.max_free) {
+        ::munmap(base_of(sctx.sp), mmap_size_);
+        mapped_.fetch_sub(1, std::memory_order_relaxed);
+        return;
+      }
+      free_.fetch_add(1, std::memory_order_relaxed);
+      if (is_owner(false)) {
+        local_.hot.push_back(sctx.sp);
+        return;
+      }
+      std::lock_guard<std::mutex> lk(mu_);
+      shared_.hot.push_back(sctx.sp);
+    }
+
+    void trim() noexcept
+    {
+      if (cfg_.huge_pages) return;
+      // the private list first: it is the one a service thread refills
+      std::size_t keep = cfg_.trim_keep;
+      if (is_owner(false)) keep = trim_list(local_, keep);
       std::lock_guard<std::mutex> lk(mu_);
-      free_list_.push_back(base);
+      trim_list(shared_, keep);
+    }
+
+    stack_pool_stats stats() const noexcept
+    {
+      stack_pool_stats s;
+      s.in_use = in_use_.load(std::memory_order_relaxed);
+      s.free = free_.load(std::memory_order_relaxed);
+      s.trimmed = trimmed_.load(std::memory_order_relaxed);
+      s.mapped = mapped_.load(std::memory_order_relaxed);
+      s.max_used = max_used_.load(std::memory_order_relaxed);
+      return s;
     }
 
+    stack_pool_config cfg_;
+    std::size_t stack_size_;
+
    private:
-    void* pop_or_mmap()
+    void* base_of(void* sp) const noexcept
     {
-      {
-        std::lock_guard<std::mutex> lk(mu_);
-        if (!free_list_.empty()) {
-          void* base = free_list_.back();
-          free_list_.pop_back();
-          return base;
-        }
+      return static_cast<char*>(sp) - mmap_size_;
+    }
+
+    static constexpr std::uint64_t fill_pattern = 0x5a5a5a5a5a5a5a5aull;
+
+    // pattern-fills the @p bytes below the stack top @p sp
+    static void fill(void* sp, std::size_t bytes) noexcept
+    {
+      auto* hi = static_cast<std::uint64_t*>(sp);
+      for (auto* p = hi - bytes / sizeof(std::uint64_t); p < hi; ++p)
+        *p = fill_pattern;
+    }
+
+    // Finds the deepest word the fiber overwrote, scanning up from the
+    // bottom of the stack, reports it and restores the pattern above it.
+    void measure(void* sp) noexcept
+    {
+      auto* hi = static_cast<std::uint64_t*>(sp);
+      auto* p = hi - stack_size_ / sizeof(std::uint64_t);
+      while (p < hi && *p == fill_pattern) ++p;
+      std::size_t used = (hi - p) * sizeof(std::uint64_t);
+      fill(sp, used);
+
+      std::size_t prev = max_used_.load(std::memory_order_relaxed);
+      while (used > prev && !max_used_.compare_exchange_weak(
+                                prev, used, std::memory_order_relaxed)) {
       }
+      if (cfg_.on_usage) cfg_.on_usage(used, stack_size_);
+    }
+
+    // binds the pool to the first allocating thread
+    bool is_owner(bool claim) noexcept
+    {
+      auto me = std::this_thread::get_id();
+      auto owner = owner_.load(std::memory_order_relaxed);
+      if (owner == me) return true;
+      if (!claim || owner != std::thread::id()) return false;
+      return owner_.compare_exchange_strong(owner, me);
+    }
+
+    // Releases the memory of the oldest resident stacks of @p fl beyond
+    // @p keep; returns how many more may stay resident elsewhere.
+    std::size_t trim_list(free_list& fl, std::size_t keep) noexcept
+    {
+      if (fl.hot.size() <= keep) return keep - fl.hot.size();
+      std::size_t n = fl.hot.size() - keep;
+      for (std::size_t i = 0; i < n; ++i) {
+        void* sp = fl.hot[i];
+        // the guard page stays in place, only the usable pages go
+        void* lo = static_cast<char*>(sp) - stack_size_;
+#ifdef MADV_FREE
+        if (::madvise(lo, stack_size_, MADV_FREE) != 0)
+#endif
+          ::madvise(lo, stack_size_, MADV_DONTNEED);
+        fl.cold.push_back(sp);
+      }
+      fl.hot.erase(fl.hot.begin(), fl.hot.begin() + n);
+      trimmed_.fetch_add(n, std::memory_order_relaxed);
+      return 0;
+    }
+
+    void* map_stack()
+    {
       // Allocate a new stack via mmap
       void* base = ::mmap(nullptr, mmap_size_, PROT_READ | PROT_WRITE,
                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
@@ -100,14 +300,58 @@ class pooled_guarded_stack {
         ::munmap(base, mmap_size_);
         throw std::bad_alloc();
       }
-      return base;
+      mapped_.fetch_add(1, std::memory_order_relaxed);
+      void* sp = static_cast<char*>(base) + mmap_size_;
+      if (cfg_.measure_usage) fill(sp, stack_size_);
+      return sp;
+    }
+
+    // Maps a slab, keeps its first stack and pools the rest.
+    void* from_slab()
+    {
+      const std::size_t huge = 2 * 1024 * 1024;
+      std::size_t bytes = (std::max(cfg_.slab_size, stack_size_) + huge - 1) /
+                          huge * huge;
+      void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (base == MAP_FAILED) {
+        // no reserved huge pages: ask for transparent ones instead
+        base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        ::madvise(base, bytes, MADV_HUGEPAGE);
+#endif
+      }
+
+      std::size_t n = bytes / stack_size_;
+      if (cfg_.measure_usage)
+        fill(static_cast<char*>(base) + n * stack_size_, n * stack_size_);
+      mapped_.fetch_add(n, std::memory_order_relaxed);
+      free_.fetch_add(n - 1, std::memory_order_relaxed);
+      auto* p = static_cast<char*>(base);
+      bool owner = is_owner(false);
+      std::lock_guard<std::mutex> lk(mu_);
+      slabs_.emplace_back(base, bytes);
+      auto& fl = owner ? local_.hot : shared_.hot;
+      for (std::size_t i = n - 1; i > 0; --i)
+        fl.push_back(p + (i + 1) * stack_size_);
+      return p + stack_size_;
     }
 
-    std::size_t stack_size_;
     std::size_t page_size_;
     std::size_t mmap_size_;
+    std::atomic<std::thread::id> owner_{};
+    free_list local_;  // owner thread only
     std::mutex mu_;
-    std::vector<void*> free_list_;
+    free_list shared_;                                // guarded by mu_
+    std::vector<std::pair<void*, std::size_t>> slabs_;  // guarded by mu_
+
+    std::atomic<std::size_t> in_use_{0};
+    std::atomic<std::size_t> free_{0};
+    std::atomic<std::size_t> trimmed_{0};
+    std::atomic<std::size_t> mapped_{0};
+    std::atomic<std::size_t> max_used_{0};
   };
 
   std::shared_ptr<impl> impl_;
@@ -0,0 +1,161 @@
+#ifndef LIBASYIK_ASYIK_REQUEST_ARENA_HPP
+#define LIBASYIK_ASYIK_REQUEST_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace asyik {
+
+// Monotonic memory for everything one HTTP request allocates: allocation
+// bumps a pointer, deallocation does nothing, and reset() takes it all back
+// at once.
+//
+// The first inline_size bytes live inside the arena object itself. What does
+// not fit goes to heap blocks; on the next reset() those are merged into one
+// block big enough for the whole request, so a connection stops allocating
+// after its first few requests.
+class request_arena {
+ public:
+  static constexpr std::size_t inline_size = 4096;
+
+  request_arena() noexcept : cur_(inline_), end_(inline_ + inline_size) {}
+
+  request_arena(const request_arena&) = delete;
+  request_arena& operator=(const request_arena&) = delete;
+
+  ~request_arena()
+  {
+    free_spill();
+    ::operator delete(main_);
+  }
+
+  void* allocate(std::size_t n, std::size_t align)
+  {
+    char* p = align_up(cur_, align);
+    if (p > end_ || static_cast<std::size_t>(end_ - p) < n) p = spill(n, align);
+    cur_ = p + n;
+    return p;
+  }
+
+  // Everything allocated so far must be unused by now.
+  void reset() noexcept
+  {
+    if (spill_) {
+      std::size_t total = main_size_ ? main_size_ : inline_size;
+      for (block* b = spill_; b; b = b->next) total += b->size;
+      free_spill();
+      ::operator delete(main_);
+      main_ = static_cast<char*>(::operator new(total, std::nothrow));
+      main_size_ = main_ ? total : 0;
+    }
+    cur_ = main_ ? main_ : inline_;
+    end_ = cur_ + (main_ ? main_size_ : inline_size);
+  }
+
+ private:
+  struct block {
+    block* next;
+    std::size_t size;
+  };
+
+  static char* align_up(char* p, std::size_t align) noexcept
+  {
+    auto v = reinterpret_cast<std::uintptr_t>(p);
+    return reinterpret_cast<char*>((v + align - 1) & ~(align - 1));
+  }
+
+  char* spill(std::size_t n, std::size_t align)
+  {
+    std::size_t size = spill_ ? spill_->size * 2 : inline_size;
+    if (size < n + align) size = n + align;
+    constexpr std::size_t header =
+        (sizeof(block) + alignof(std::max_align_t) - 1) &
+        ~(alignof(std::max_align_t) - 1);
+    auto* b = static_cast<block*>(::operator new(header + size));
+    b->next = spill_;
+    b->size = size;
+    spill_ = b;
+    char* data = reinterpret_cast<char*>(b) + header;
+    end_ = data + size;
+    return align_up(data, align);
+  }
+
+  void free_spill() noexcept
+  {
+    while (spill_) {
+      block* next = spill_->next;
+      ::operator delete(spill_);
+      spill_ = next;
+    }
+  }
+
+  char* cur_;
+  char* end_;
+  block* spill_ = nullptr;
+  char* main_ = nullptr;  // replaces inline_ once a request outgrew it
+  std::size_t main_size_ = 0;
+  alignas(std::max_align_t) char inline_[inline_size];
+};
+
+// Allocator handing out request_arena memory, or heap memory when it has no
+// arena. A container keeps the allocator it was constructed with: assigning
+// to it, by copy or by move, copies the elements over when the allocators
+// differ, so that moving a request's headers into a longer-lived message
+// leaves nothing in the arena. Only a move-constructed container takes the
+// allocator along, and a copy-constructed one always lands on the heap.
+template <typename T>
+class arena_allocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_swap = std::false_type;
+  using is_always_equal = std::false_type;
+
+  arena_allocator() noexcept = default;
+  explicit arena_allocator(request_arena* arena) noexcept : arena_(arena) {}
+  template <typename U>
+  arena_allocator(const arena_allocator<U>& other) noexcept
+      : arena_(other.arena())
+  {}
+
+  T* allocate(std::size_t n)
+  {
+    if (!arena_) return std::allocator<T>().allocate(n);
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept
+  {
+    if (!arena_) std::allocator<T>().deallocate(p, n);
+  }
+
+  arena_allocator select_on_container_copy_construction() const noexcept
+  {
+    return arena_allocator();
+  }
+
+  request_arena* arena() const noexcept { return arena_; }
+
+  template <typename U>
+  bool operator==(const arena_allocator<U>& other) const noexcept
+  {
+    return arena_ == other.arena();
+  }
+
+  template <typename U>
+  bool operator!=(const arena_allocator<U>& other) const noexcept
+  {
+    return arena_ != other.arena();
+  }
+
+ private:
+  request_arena* arena_ = nullptr;
+};
+
+}  // namespace asyik
+
+#endif
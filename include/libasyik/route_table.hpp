@@ -3,8 +3,12 @@
 
 #include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -65,6 +69,211 @@ inline std::string normalise_path(string_view target)
   return s;
 }
 
+/// normalise_path() without the copy: a view into @p target.
+inline string_view normalise_path_view(string_view target)
+{
+  auto qpos = target.find('?');
+  if (qpos != string_view::npos) target = target.substr(0, qpos);
+  if (target.size() > 1 && target.back() == '/') target.remove_suffix(1);
+  return target;
+}
+
+/// A route spec matched without std::regex and without allocating, with the
+/// captures of route_spec_to_regex(): the whole target, one per tag, then the
+/// query string ("" when there is none). Tags match what their regex does,
+/// backtracking where a tag is followed by more of the spec.
+class route_spec_matcher {
+ public:
+  explicit route_spec_matcher(string_view route_spec)
+  {
+    if (!route_spec.empty() && route_spec.back() == '/')
+      route_spec.remove_suffix(1);
+    std::string literal;
+    while (!route_spec.empty()) {
+      kind k;
+      std::size_t n = tag_at(route_spec, k);
+      if (!n) {
+        literal += route_spec.front();
+        route_spec.remove_prefix(1);
+        continue;
+      }
+      if (!literal.empty())
+        segments_.push_back({kind::literal, std::move(literal)});
+      literal.clear();
+      segments_.push_back({k, {}});
+      ++tags_;
+      route_spec.remove_prefix(n);
+    }
+    if (!literal.empty())
+      segments_.push_back({kind::literal, std::move(literal)});
+  }
+
+  /// On a match, @p args is resized to tags + 2 and filled in.
+  bool match(string_view target, http_route_view_args& args) const
+  {
+    args.resize(tags_ + 2);
+    args[0] = target;
+    return match_from(0, 1, target, args);
+  }
+
+ private:
+  enum class kind { literal, int_tag, string_tag, path_tag };
+  struct segment {
+    kind k;
+    std::string text;
+  };
+
+  static bool is_space(char c)
+  {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+  // length of the <int>, <string> or <path> tag @p s starts with, or 0
+  static std::size_t tag_at(string_view s, kind& k)
+  {
+    if (s.front() != '<') return 0;
+    std::size_t i = 1;
+    while (i < s.size() && is_space(s[i])) ++i;
+    std::size_t name = i;
+    while (i < s.size() && s[i] >= 'a' && s[i] <= 'z') ++i;
+    string_view tag = s.substr(name, i - name);
+    while (i < s.size() && is_space(s[i])) ++i;
+    if (i == s.size() || s[i] != '>') return 0;
+    if (tag == "int")
+      k = kind::int_tag;
+    else if (tag == "string")
+      k = kind::string_tag;
+    else if (tag == "path")
+      k = kind::path_tag;
+    else
+      return 0;
+    return i + 1;
+  }
+
+  // [0-9]+, [^/?\s]+ and [^?#\s]*
+  static bool tag_char(kind k, char c)
+  {
+    switch (k) {
+      case kind::int_tag:
+        return c >= '0' && c <= '9';
+      case kind::string_tag:
+        return c != '/' && c != '?' && !is_space(c);
+      default:
+        return c != '?' && c != '#' && !is_space(c);
+    }
+  }
+
+  bool match_from(std::size_t seg, std::size_t arg, string_view rest,
+                  http_route_view_args& args) const
+  {
+    if (seg == segments_.size()) {
+      // \/?(|\?[^\?\s]*)$
+      if (!rest.empty() && rest.front() == '/') rest.remove_prefix(1);
+      if (!rest.empty()) {
+        if (rest.front() != '?') return false;
+        for (char c : rest.substr(1))
+          if (c == '?' || is_space(c)) return false;
+      }
+      args[arg] = rest;
+      return true;
+    }
+    const segment& s = segments_[seg];
+    if (s.k == kind::literal) {
+      if (!rest.starts_with(string_view(s.text.data(), s.text.size())))
+        return false;
+      return match_from(seg + 1, arg, rest.substr(s.text.size()), args);
+    }
+    std::size_t n = 0;
+    while (n < rest.size() && tag_char(s.k, rest[n])) ++n;
+    std::size_t min = s.k == kind::path_tag ? 0 : 1;
+    for (std::size_t len = n + 1; len-- > min;) {
+      args[arg] = rest.substr(0, len);
+      if (match_from(seg + 1, arg + 1, rest.substr(len), args)) return true;
+    }
+    return false;
+  }
+
+  std::vector<segment> segments_;
+  std::size_t tags_ = 0;
+};
+
+/// Routes for http_request_view handlers, looked up without allocating: the
+/// same tiers as route_table, minus raw regex routes. Static routes are found
+/// by exact path, the others by route_spec_matcher in registration order.
+class view_route_table {
+ public:
+  struct route {
+    std::string method;
+    std::string spec;  // as registered, names the route in watchdog reports
+    route_spec_matcher matcher;
+    http_route_view_callback cb;  // may be empty with a response_template
+    std::shared_ptr<const http_response_template> response_template;
+  };
+
+  void add_route(string_view route_spec, string_view method,
+                 http_route_view_callback cb, bool insert_front = false,
+                 std::shared_ptr<const http_response_template> tmpl = nullptr)
+  {
+    route r{std::string(method.data(), method.size()),
+            std::string(route_spec.data(), route_spec.size()),
+            route_spec_matcher(route_spec), std::move(cb), std::move(tmpl)};
+    auto& vec = is_static_route(route_spec)
+                    ? exact_routes_[exact_key(normalise_path(route_spec))]
+                    : prefix_routes_;
+    if (insert_front)
+      vec.insert(vec.begin(), std::move(r));
+    else
+      vec.push_back(std::move(r));
+  }
+
+  /// The first route matching @p method and @p target, with its arguments in
+  /// @p args, or nullptr.
+  const route* find(string_view method, string_view target,
+                    http_route_view_args& args) const
+  {
+    string_view path = normalise_path_view(target);
+    auto it = exact_routes_.find(hash_key(path));
+    if (it != exact_routes_.end()) {
+      for (const auto& r : it->second) {
+        if (r.method.empty() || boost::iequals(r.method, method)) {
+          args.resize(1);
+          args[0] = path;
+          return &r;
+        }
+      }
+    }
+    for (const auto& r : prefix_routes_)
+      if ((r.method.empty() || boost::iequals(r.method, method)) &&
+          r.matcher.match(target, args))
+        return &r;
+    return nullptr;
+  }
+
+  bool empty() const
+  {
+    return exact_routes_.empty() && prefix_routes_.empty();
+  }
+
+ private:
+  static std::string_view hash_key(string_view s)
+  {
+    return std::string_view(s.data(), s.size());
+  }
+
+  // the map is keyed by views, so it can be searched with the target
+  std::string_view exact_key(std::string path)
+  {
+    auto it = exact_routes_.find(path);
+    if (it != exact_routes_.end()) return it->first;
+    paths_.push_back(std::move(path));
+    return paths_.back();
+  }
+
+  std::deque<std::string> paths_;  // stable, unlike a vector
+  std::unordered_map<std::string_view, std::vector<route>> exact_routes_;
+  std::vector<route> prefix_routes_;
+};
+
 /// Three-tier route table that avoids regex for static routes and narrows
 /// candidates by prefix for parameterized routes.
 ///
@@ -95,7 +304,9 @@ class route_table {
     } else {
       // Tier 2: prefix + regex
       std::string prefix = extract_static_prefix(route_spec);
-      prefix_entry entry{std::move(prefix), std::move(route)};
+      prefix_entry entry{std::move(prefix),
+                         std::string(route_spec.data(), route_spec.size()),
+                         std::move(route)};
       if (insert_front)
         prefix_routes_.insert(prefix_routes_.begin(), std::move(entry));
       else
@@ -104,19 +315,26 @@ class route_table {
   }
 
   /// Register a raw regex route (no known structure — fallback tier 3).
-  void add_regex_route(RouteType&& route, bool insert_front = false)
+  /// @p label stands for the route where find() reports its spec.
+  void add_regex_route(RouteType&& route, bool insert_front = false,
+                       string_view label = "<regex>")
   {
+    regex_entry entry{std::string(label.data(), label.size()),
+                      std::move(route)};
     if (insert_front)
-      fallback_routes_.insert(fallback_routes_.begin(), std::move(route));
+      fallback_routes_.insert(fallback_routes_.begin(), std::move(entry));
     else
-      fallback_routes_.push_back(std::move(route));
+      fallback_routes_.push_back(std::move(entry));
   }
 
   /// Find the first matching route for request @p req, populating @p args.
   /// Tries tiers in order: exact → prefix → fallback.
   /// Throws not_found_error if no route matches.
+  /// @p spec, if given, receives the spec the route was registered with (the
+  /// normalised path of a static route, the label of a raw regex route).
   template <typename ReqType>
-  const RouteType& find(const ReqType& req, http_route_args& args) const
+  const RouteType& find(const ReqType& req, http_route_args& args,
+                        string_view* spec = nullptr) const
   {
     std::string target{req.target()};
     std::string path =
@@ -131,6 +349,7 @@ class route_table {
           // For static routes, args[0] = full match = the path itself
           args.clear();
           args.push_back(path);
+          if (spec) *spec = it->first;
           return route;
         }
       }
@@ -148,6 +367,7 @@ class route_table {
           if (std::regex_search(target, m, std::get<1>(route))) {
             args.clear();
             for (const auto& item : m) args.push_back(item.str());
+            if (spec) *spec = entry.spec;
             return route;
           }
         }
@@ -155,13 +375,15 @@ class route_table {
     }
 
     // ── Tier 3: fallback (raw regex routes) ──
-    for (const auto& route : fallback_routes_) {
+    for (const auto& entry : fallback_routes_) {
+      const auto& route = entry.route;
       const auto& method = std::get<0>(route);
       if (method.empty() || boost::iequals(method, req.method_string())) {
         std::smatch m;
         if (std::regex_search(target, m, std::get<1>(route))) {
           args.clear();
           for (const auto& item : m) args.push_back(item.str());
+          if (spec) *spec = entry.label;
           return route;
         }
       }
@@ -180,6 +402,12 @@ class route_table {
  private:
   struct prefix_entry {
     std::string prefix;
+    std::string spec;
+    RouteType route;
+  };
+
+  struct regex_entry {
+    std::string label;
     RouteType route;
   };
 
@@ -190,7 +418,7 @@ class route_table {
   std::vector<prefix_entry> prefix_routes_;
 
   // Tier 3: raw regex routes with no known structure
-  std::vector<RouteType> fallback_routes_;
+  std::vector<regex_entry> fallback_routes_;
 };
 
 }  // namespace asyik
@@ -1,15 +1,26 @@
 #ifndef LIBASYIK_ASYIK_SERVICE_HPP
 #define LIBASYIK_ASYIK_SERVICE_HPP
 
+#include <array>
+#include <ctime>
+#include <exception>
 #include <string>
+#include <tuple>
 #include <type_traits>
+#include <vector>
 
 #include "aixlog.hpp"
 #include "asyik_fwd.hpp"
 #include "asyik_round_robin.hpp"
+#include "asyik_work_stealing.hpp"
 #include "boost/asio.hpp"
 #include "boost/fiber/all.hpp"
+#include "boost/optional.hpp"
 #include "common.hpp"
+#include "internal/mpsc_queue.hpp"
+#include "internal/small_task.hpp"
+#include "object_pool.hpp"
+#include "offload_pool.hpp"
 #include "pooled_guarded_stack.hpp"
 
 namespace fibers = boost::fibers;
@@ -27,7 +38,7 @@ struct helper {
   template <typename P, typename F, typename... Args>
   static void set(P& p, F& f, Args&&... args)
   {
-    p->set_value(f(std::forward<Args>(args)...));
+    p.set_value(f(std::forward<Args>(args)...));
   }
 };
 
@@ -37,40 +48,289 @@ struct helper<void> {
   static void set(P& p, F& f, Args&&... args)
   {
     f(std::forward<Args>(args)...);
-    p->set_value();
+    p.set_value();
   }
 };
+
+// a task queued by service::execute(), allocated from the service's node
+// pool and released by the fiber that ran it
+struct execute_node : internal::mpsc_node {
+  template <typename F>
+  explicit execute_node(F&& f) : fn(std::forward<F>(f))
+  {
+  }
+  internal::small_task fn;
+  fiber_priority priority = fiber_priority::normal;
+};
+
+// What service::offload() hands the worker: lives on the stack of the
+// calling fiber, which stays suspended until the worker is done with it.
+template <typename R>
+struct offload_result {
+  template <typename F, typename... Args>
+  void set(F& f, Args&&... args)
+  {
+    value.emplace(f(std::forward<Args>(args)...));
+  }
+  R get() { return std::move(*value); }
+  boost::optional<R> value;
+};
+
+template <>
+struct offload_result<void> {
+  template <typename F, typename... Args>
+  void set(F& f, Args&&... args)
+  {
+    f(std::forward<Args>(args)...);
+  }
+  void get() {}
+};
+
+template <typename R>
+struct offload_waiter : offload_result<R> {
+  // Suspends the calling fiber until wake(), unless that already happened.
+  // The lock is released only once the fiber has switched out, so wake()
+  // cannot schedule it while it is still running.
+  void wait() noexcept
+  {
+    boost::fibers::detail::spinlock_lock lk{splk};
+    if (done) return;
+    waiting = true;
+    ctx->suspend(lk);
+  }
+
+  // From the worker: puts the fiber back on its own scheduler, through the
+  // remote ready queue if that is another thread's. The waiter is gone as
+  // soon as the fiber runs again, so it is not touched after unlocking.
+  void wake() noexcept
+  {
+    boost::fibers::context* c;
+    {
+      boost::fibers::detail::spinlock_lock lk{splk};
+      done = true;
+      if (!waiting) return;
+      c = ctx;
+    }
+    boost::fibers::context::active()->schedule(c);
+  }
+
+  R get()
+  {
+    if (error) std::rethrow_exception(error);
+    return offload_result<R>::get();
+  }
+
+  boost::fibers::context* ctx = boost::fibers::context::active();
+  boost::fibers::detail::spinlock splk;
+  bool done = false;
+  bool waiting = false;
+  std::exception_ptr error;
+};
 };  // namespace service_internal
 
+// On a service thread the fiber sleeps on the service's timer wheel, so the
+// wake-up comes up to one timer resolution late (see
+// service::set_timer_resolution()).
 template <typename T>
 void sleep_for(T&& t)
 {
   asyik_round_robin::check_interrupt();
-  boost::this_fiber::sleep_for(t);
+  auto* sched = asyik_round_robin::current();
+  if (sched && boost::fibers::context::active()->is_context(
+                   boost::fibers::type::worker_context))
+    sched->sleep_until(
+        std::chrono::steady_clock::now() +
+        std::chrono::ceil<std::chrono::steady_clock::duration>(t));
+  else
+    boost::this_fiber::sleep_for(t);
   asyik_round_robin::check_interrupt();
 }
 
+/// One-shot timer on the timer wheel of the service thread it is armed on,
+/// for timeouts that are mostly cancelled or re-armed before they expire,
+/// such as connection idle timeouts: arming and cancelling are O(1) and do
+/// not allocate for small callbacks. The callback runs on that thread from
+/// inside the fiber scheduler, so it must neither block nor suspend; cancel
+/// a socket, set a flag or wake a fiber. Arm, cancel and destroy the timer
+/// on that thread only.
+class wheel_timer {
+ public:
+  wheel_timer() = default;
+  ~wheel_timer() { cancel(); }
+  wheel_timer(const wheel_timer&) = delete;
+  wheel_timer& operator=(const wheel_timer&) = delete;
+
+  /// Calls @p f once @p after has passed, replacing a pending callback.
+  /// False if the calling thread runs no service.
+  template <typename F>
+  bool arm(std::chrono::steady_clock::duration after, F&& f)
+  {
+    cancel();
+    sched_ = asyik_round_robin::current();
+    if (!sched_) return false;
+    node_.fn = internal::small_task(std::forward<F>(f));
+    sched_->add_timer(&node_, std::chrono::steady_clock::now() + after);
+    return true;
+  }
+
+  void cancel() noexcept
+  {
+    if (sched_) sched_->cancel_timer(&node_);
+  }
+
+  bool armed() const noexcept { return node_.linked(); }
+
+ private:
+  struct node : internal::timer_wheel_node {
+    node() noexcept { on_expiry = &fire; }
+    static void fire(internal::timer_wheel_node* n) noexcept
+    {
+      try {
+        static_cast<node*>(n)->fn();
+      } catch (...) {
+        // nowhere to report it from inside the scheduler
+      }
+    }
+    internal::small_task fn;
+  };
+
+  node node_;
+  asyik_round_robin* sched_ = nullptr;
+};
+
+/// Names the running fiber in watchdog reports (see service::set_watchdog())
+/// while in scope; @p label must stay valid until then. Does nothing while
+/// the watchdog is off.
+class fiber_label {
+ public:
+  explicit fiber_label(string_view label) noexcept
+  {
+    auto* sched = asyik_round_robin::current();
+    if (!sched || !sched->watchdog_enabled()) return;
+    sched_ = sched;
+    ctx_ = boost::fibers::context::active();
+    prev_ = asyik_round_robin::label(ctx_);
+    asyik_round_robin::set_label(ctx_, label);
+  }
+  ~fiber_label()
+  {
+    if (!ctx_) return;
+    // a handler that never yielded is reported under its own label
+    sched_->checkpoint();
+    asyik_round_robin::set_label(ctx_, prev_);
+  }
+  fiber_label(const fiber_label&) = delete;
+  fiber_label& operator=(const fiber_label&) = delete;
+
+ private:
+  asyik_round_robin* sched_ = nullptr;
+  boost::fibers::context* ctx_ = nullptr;
+  string_view prev_;
+};
+
+/// Reactor behind every service's io_context: "io_uring" when libasyik is
+/// built with LIBASYIK_ENABLE_IO_URING, "epoll" otherwise (on Linux). Asio
+/// selects it at compile time, there is no switching it per service.
+inline const char* io_backend() noexcept
+{
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+  return "io_uring";
+#elif defined(BOOST_ASIO_HAS_EPOLL)
+  return "epoll";
+#elif defined(BOOST_ASIO_HAS_KQUEUE)
+  return "kqueue";
+#elif defined(BOOST_ASIO_HAS_IOCP)
+  return "iocp";
+#else
+  return "select";
+#endif
+}
+
+/// How service::run() waits when there is no runnable fiber.
+///  - polling:      poll the io_context, then yield/sleep in growing steps
+///                  (up to 5ms) while idle. The default.
+///  - event_driven: block the thread inside the io_context until a socket
+///                  event, a timer/fiber deadline, or a cross-thread wakeup.
+///  - busy_poll:    never block or sleep: poll the io_context and yield to
+///                  the ready fibers in a tight loop. Lowest latency, at the
+///                  price of a core spinning at 100% even while idle.
+enum class service_run_mode { polling, event_driven, busy_poll };
+
+/// How the async() worker pool distributes work over its threads.
+///  - shared_queue:  every worker pops from one shared channel and keeps the
+///                   fibers it spawned. The default.
+///  - work_stealing: per-worker deques; idle workers steal queued tasks and
+///                   ready fibers from busy ones, so a fiber that blocked on
+///                   one worker can resume on another.
+enum class async_scheduling { shared_queue, work_stealing };
+
 struct async_stats {
-  uint32_t task_started;
-  uint32_t task_terminated;
-  uint32_t task_error;
+  uint64_t task_started;
+  uint64_t task_terminated;
+  uint64_t task_error;  // async() and offload() calls that threw
 
   uint32_t queue_size;
+
+  // start to end of a task, see offload_pool_stats
+  uint64_t run_time_total_us;
+  latency_histogram run_time;
+
+  // shared_queue only, see offload_pool_stats
+  uint32_t threads;
+  uint64_t queue_wait_total_us;
+  uint64_t queue_wait_max_us;
+  latency_histogram queue_wait;
+
+  // work_stealing only
+  uint64_t task_steals;   // tasks taken from a peer's deque
+  uint64_t fiber_steals;  // ready fibers migrated to a peer worker
+  std::vector<uint32_t> worker_queue_size;  // pending tasks per worker
+};
+
+// Cumulative since the service was created; diff two snapshots for rates.
+struct scheduler_stats {
+  uint64_t context_switches;
+  // runnable fibers, sampled at every scheduling decision; buckets
+  // 0, 1, 2-3, 4-7, ..., 512-1023, 1024 and more
+  std::array<uint64_t, scheduler_counters::depth_buckets> ready_depth;
+  uint64_t suspend_ns;       // thread blocked in the fiber scheduler
+  uint64_t reactor_wait_ns;  // thread blocked in the io_context (event_driven)
+
+  // set_scheduler_timing(true) only
+  uint64_t fiber_run_ns;  // running fibers other than the run-loop
+  uint64_t io_poll_ns;    // running io_context::poll() in the run-loop
+
+  uint32_t live_fibers;    // execute() fibers running a task
+  uint32_t parked_fibers;  // execute() fibers waiting in the fiber pool
+
+  // set_watchdog() only: fiber slices over the budget
+  uint64_t slow_slices;
+  uint64_t slow_slice_ns;
+  uint64_t slow_slice_max_ns;
+
+  // busy_poll run mode only: rounds of the run-loop, and those that found
+  // neither I/O completions nor ready fibers
+  uint64_t busy_polls;
+  uint64_t busy_polls_empty;
+
+  // set_lifo_slot(true) only: fibers that ran straight from the LIFO slot,
+  // and fibers moved from it to the back of the queue
+  uint64_t lifo_handoffs;
+  uint64_t lifo_demotions;
 };
 
 class service : public std::enable_shared_from_this<service> {
  private:
   struct private_ {};
 
-  static std::atomic<uint32_t> async_task_started;
-  static std::atomic<uint32_t> async_task_terminated;
-  static std::atomic<uint32_t> async_task_error;
-  static std::atomic<uint32_t> async_queue_size;
   static thread_local service_wptr active_service;
+  // binds async() fibers to their originating service; unlike active_service
+  // it follows the fiber when it migrates between worker threads
+  static fibers::fiber_specific_ptr<service_wptr> async_service;
   std::atomic<uint32_t> execute_task_count;
 
  public:
-  ~service(){};
+  ~service();
   service& operator=(const service&) = delete;
   service() = delete;
   service(const service&) = delete;
@@ -81,79 +341,225 @@ class service : public std::enable_shared_from_this<service> {
 
   static async_stats get_async_stats();
 
-  template <typename F, typename... Args>
+  /// Select how the async() worker pool schedules work. Only effective when
+  /// called before the first async() call starts the pool.
+  static void set_async_scheduling(async_scheduling s);
+  static async_scheduling get_async_scheduling();
+
+  template <typename F, typename... Args,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<F>::type, fiber_priority>::value>::type>
   fibers::future<typename std::result_of<F(Args...)>::type> execute(
       F&& fun, Args&&... args)
   {
-    auto p = std::make_shared<
-        fibers::promise<typename std::result_of<F(Args...)>::type>>();
-    auto future = p->get_future();
-    auto t = std::atomic_load(&execute_tasks);
+    return execute(fiber_priority::normal, std::forward<F>(fun),
+                   std::forward<Args>(args)...);
+  }
+
+  /// Same as execute(fun, args...), but the task's fiber runs in scheduling
+  /// class @p prio: while it is runnable, no fiber of a lower class runs.
+  /// Meant for short, latency-sensitive work such as health checks; high
+  /// priority fibers that never wait starve everything else.
+  template <typename F, typename... Args>
+  fibers::future<typename std::result_of<F(Args...)>::type> execute(
+      fiber_priority prio, F&& fun, Args&&... args)
+  {
+    using result_type = typename std::result_of<F(Args...)>::type;
+    auto p = make_promise_<result_type>();
+    auto future = p.get_future();
     execute_task_count++;
-    t->push([f = std::forward<F>(fun), &args..., p, this]() mutable {
+    post_execute_task_([f = std::forward<F>(fun), &args..., p = std::move(p),
+                        this]() mutable {
       try {
-        service_internal::helper<
-            typename std::result_of<F(Args...)>::type>::set(p, f,
-                                                            std::forward<Args>(
-                                                                args)...);
+        service_internal::helper<result_type>::set(p, f,
+                                                   std::forward<Args>(args)...);
       } catch (...) {
-        p->set_exception(std::current_exception());
+        p.set_exception(std::current_exception());
       };
       execute_task_count--;
-    });
+    }, prio);
 
     return future;
   }
 
+  /// Fire-and-forget execute(): runs fun(args...) in a new fiber on this
+  /// service without creating a promise or future. @p args are copied into
+  /// the task (use std::ref() to pass a reference); an exception escaping
+  /// @p fun is logged and dropped.
+  template <typename F, typename... Args>
+  void execute_detached(F&& fun, Args&&... args)
+  {
+    execute_task_count++;
+    post_execute_task_(
+        [f = std::forward<F>(fun),
+         a = std::make_tuple(std::forward<Args>(args)...), this]() mutable {
+          try {
+            std::apply(f, std::move(a));
+          } catch (const std::exception& e) {
+            LOG(ERROR) << "execute_detached(): task threw: " << e.what()
+                       << "\n";
+          } catch (...) {
+            LOG(ERROR) << "execute_detached(): task threw\n";
+          };
+          execute_task_count--;
+        });
+  }
+
   void set_default_log_severity(log_severity s)
   {
     BOOST_ASSERT(default_log_sink);
     default_log_sink->filter = AixLog::Filter(s);
   }
 
-  template <typename F, typename... Args>
+  template <typename F, typename... Args,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<F>::type, offload_pool_ptr>::value>::type>
   fibers::future<typename std::result_of<F(Args...)>::type> async(
       F&& fun, Args&&... args)
   {
     if (!is_workers_initiated()) init_workers();
 
-    auto p = std::make_shared<
-        fibers::promise<typename std::result_of<F(Args...)>::type>>();
-    auto future = p->get_future();
-    auto t = std::atomic_load(&tasks);
-    async_queue_size++;
-    t->push([f = std::forward<F>(fun), as = weak_from_this(), &args...,
-             p]() mutable {
-      auto prev_as = service::active_service;
-      service::active_service = as;
-      try {
-        service_internal::helper<
-            typename std::result_of<F(Args...)>::type>::set(p, f,
-                                                            std::forward<Args>(
-                                                                args)...);
-      } catch (...) {
-        async_task_error++;
-        p->set_exception(std::current_exception());
-      };
-      service::active_service = prev_as;
-    });
+    auto p = make_promise_<typename std::result_of<F(Args...)>::type>();
+    auto future = p.get_future();
+    submit_async(make_async_task_(std::move(p), std::forward<F>(fun),
+                                  std::forward<Args>(args)...));
 
     return future;
   };
 
+  /// Same as async(fun, args...), but runs on @p pool instead of the default
+  /// worker pool.
+  template <typename F, typename... Args>
+  fibers::future<typename std::result_of<F(Args...)>::type> async(
+      const offload_pool_ptr& pool, F&& fun, Args&&... args)
+  {
+    auto p = make_promise_<typename std::result_of<F(Args...)>::type>();
+    auto future = p.get_future();
+    pool->submit(make_async_task_(std::move(p), std::forward<F>(fun),
+                                  std::forward<Args>(args)...));
+
+    return future;
+  };
+
+  /// Runs fun(args...) on the async() worker pool and returns its result,
+  /// or rethrows what it threw, like async(fun, args...).get() but cheaper:
+  /// no promise or shared state is allocated, and nothing is copied. The
+  /// calling fiber suspends, and the worker that ran @p fun puts it straight
+  /// back on its scheduler's ready queue. Call it from a fiber; @p fun and
+  /// @p args are used in place until it returns.
+  template <typename F, typename... Args,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<F>::type, offload_pool_ptr>::value>::type>
+  typename std::result_of<F(Args...)>::type offload(F&& fun, Args&&... args)
+  {
+    if (!is_workers_initiated()) init_workers();
+    return offload_(
+        [](internal::small_task&& t) { submit_async(std::move(t)); }, fun,
+        std::forward<Args>(args)...);
+  }
+
+  /// Same as offload(fun, args...), but runs on @p pool.
+  template <typename F, typename... Args>
+  typename std::result_of<F(Args...)>::type offload(
+      const offload_pool_ptr& pool, F&& fun, Args&&... args)
+  {
+    return offload_(
+        [&pool](internal::small_task&& t) { pool->submit(std::move(t)); },
+        fun, std::forward<Args>(args)...);
+  }
+
   void run(bool stop_on_complete = false);
+
+  /// Select how run() waits for work; must be called before run().
+  void set_run_mode(service_run_mode m) { run_mode_ = m; }
+  service_run_mode get_run_mode() const { return run_mode_; }
+
+  /// Keep up to @p n fibers that finished an execute() task parked, and hand
+  /// them the next tasks instead of creating and tearing down a fiber per
+  /// task (default 256, 0 disables the pool). Must be called before run().
+  ///
+  /// A task may then run on a fiber that already ran others: it must not
+  /// rely on boost::this_fiber::get_id() being fresh or on fiber_specific_ptr
+  /// values starting out empty.
+  void set_fiber_pool_size(std::size_t n) { fiber_pool_size_ = n; }
+  std::size_t get_fiber_pool_size() const { return fiber_pool_size_; }
+
+  /// Resolution of the timer wheel that asyik::sleep_for() and wheel_timer
+  /// use on this service (default 1ms): timers fire up to that late, and a
+  /// coarser one wakes the thread less often. Must be called before run().
+  void set_timer_resolution(std::chrono::steady_clock::duration d)
+  {
+    timer_resolution_ = d;
+  }
+  std::chrono::steady_clock::duration get_timer_resolution() const
+  {
+    return timer_resolution_;
+  }
+
+  /// Run a fiber woken by another fiber on this service (a promise set, a
+  /// channel pushed to, a mutex unlocked) or by an I/O completion right
+  /// after the running one, instead of behind every other ready fiber, so
+  /// that it finds the data it was woken for still in cache. At most 3
+  /// fibers run that way in a row before the ready queue gets a turn, and
+  /// never ahead of a higher fiber_priority. Wakeups from other threads and
+  /// timers stay FIFO. Off by default; must be called before run().
+  void set_lifo_slot(bool on) { lifo_slot_ = on; }
+  bool get_lifo_slot() const { return lifo_slot_; }
+
+  /// Replace the allocator of execute() fiber stacks; must be called before
+  /// run(). While the service runs, pooled stacks beyond
+  /// stack_pool_config::trim_keep are trimmed every few seconds.
+  void set_fiber_stack_config(const stack_pool_config& cfg)
+  {
+    fiber_stack_pool_ = pooled_guarded_stack(cfg);
+  }
+  stack_pool_stats get_fiber_stack_stats() const
+  {
+    return fiber_stack_pool_.get_stats();
+  }
+
+  /// Scheduler metrics of the service thread; may be called from any thread.
+  scheduler_stats get_scheduler_stats() const;
+  /// Also measure how long fibers run and io_context polls take. Costs two
+  /// clock reads per context switch and per poll, so it is off by default.
+  void set_scheduler_timing(bool on)
+  {
+    sched_counters_->timing.store(on, std::memory_order_relaxed);
+  }
+
+  /// Watchdog for handlers that hold the service thread: every time a fiber
+  /// runs longer than @p budget without suspending, the slice is counted in
+  /// the scheduler stats and passed to @p on_slow_slice, or logged as a
+  /// warning without one. The callback runs on the service thread inside
+  /// the scheduler, so it must neither block nor suspend. Must be called
+  /// before run(); a zero budget turns the watchdog off. Like timing, it
+  /// costs a clock read per context switch.
+  void set_watchdog(std::chrono::nanoseconds budget,
+                    std::function<void(const slow_slice&)> on_slow_slice = {});
+
   void stop()
   {
-    execute([s = &stopped, cv = &terminate_req_cond, i = &io_service]() {
+    execute_detached([s = &stopped, cv = &terminate_req_cond,
+                      i = &io_service]() {
       *s = true;
       std::move(i);
     });
   };
   bool is_stopped() { return stopped; }
 
-  static service_ptr get_current_service() { return active_service.lock(); }
+  static service_ptr get_current_service()
+  {
+    if (auto* as = async_service.get()) return as->lock();
+    return active_service.lock();
+  }
 
   boost::asio::io_context& get_io_service() { return io_service; };
+
+  /// The current time as an HTTP Date header value, e.g. "Sun, 06 Nov 1994
+  /// 08:49:37 GMT". It is formatted again at most once per second, so a
+  /// server can stamp every response with it. Call it on the service thread.
+  string_view http_date();
+
   static void terminate();
 
   static std::chrono::time_point<std::chrono::high_resolution_clock>
@@ -168,6 +574,7 @@ class service : public std::enable_shared_from_this<service> {
   }
 
   std::atomic<bool> stopped;
+  service_run_mode run_mode_{service_run_mode::polling};
   // Counts dispatched fibers that have not yet fully exited (their function
   // returned AND their captured objects destroyed). service::run() waits for
   // this to reach zero before returning so that Asio-registered objects
@@ -176,16 +583,143 @@ class service : public std::enable_shared_from_this<service> {
   std::atomic<int> active_fiber_count{0};
   boost::asio::io_context io_service;
   boost::asio::io_context::strand strand;
-  std::shared_ptr<fibers::buffered_channel<std::function<void()>>>
-      execute_tasks;
+
+  // execute() submissions: lock-free for the producers. The dispatcher fiber
+  // drains the queue and parks on execute_doorbell_ only once it is empty,
+  // so a burst of cross-thread execute() calls costs a single wakeup.
+  // Producers only block, as they did on the former 1024-slot channel, while
+  // that many tasks are pending.
+  static constexpr int64_t execute_queue_capacity = 1024;
+  internal::intrusive_mpsc_queue<service_internal::execute_node>
+      execute_queue_;
+  std::atomic<int64_t> execute_pending_{0};
+  std::atomic<bool> execute_parked_{false};
+  std::atomic<bool> execute_urgent_{false};  // a high priority task queued
+  fibers::buffered_channel<bool> execute_doorbell_{2};
+  fibers::buffered_channel<bool> execute_space_{1024};
+  // execute() nodes and the shared states of the futures returned by
+  // execute()/async() are recycled through these instead of the heap; they
+  // are lock-free like the queue, since producers on any thread take from
+  // them
+  static constexpr std::size_t promise_block_size = 192;
+  std::shared_ptr<lockfree_block_pool> execute_node_pool_;
+  std::shared_ptr<lockfree_block_pool> promise_pool_;
+
+  template <typename R>
+  fibers::promise<R> make_promise_()
+  {
+    return fibers::promise<R>(
+        std::allocator_arg,
+        pool_allocator<char, lockfree_block_pool>(promise_pool_));
+  }
+
+  template <typename F>
+  void post_execute_task_(F&& f,
+                          fiber_priority prio = fiber_priority::normal)
+  {
+    void* mem =
+        execute_node_pool_->allocate(sizeof(service_internal::execute_node));
+    service_internal::execute_node* n;
+    try {
+      n = ::new (mem) service_internal::execute_node(std::forward<F>(f));
+    } catch (...) {
+      execute_node_pool_->deallocate(mem,
+                                     sizeof(service_internal::execute_node));
+      throw;
+    }
+    n->priority = prio;
+    post_execute_(n);
+  }
+
+  void free_execute_node_(service_internal::execute_node* n) noexcept;
+
+  // Fibers that finished their task and wait for the dispatcher to hand them
+  // another one, most recently parked last. Only touched on the service
+  // thread.
+  struct pooled_fiber {
+    boost::fibers::context* ctx;
+    service_internal::execute_node* task;
+  };
+  std::size_t fiber_pool_size_{256};
+  std::vector<pooled_fiber*> idle_fibers_;
+  std::atomic<uint32_t> parked_fiber_count_{0};  // idle_fibers_.size()
+  bool fiber_pool_closed_{false};
+  void run_pooled_fiber_(service_internal::execute_node* n);
+  void release_idle_fibers_();
+  void post_execute_(service_internal::execute_node* n);
+  void dispatch_execute_tasks_();
+  void close_execute_queue_();
   static void init_workers();
+  static void submit_async(internal::small_task&& t);
+  static void count_async_error_() noexcept;
 
-  static std::shared_ptr<fibers::buffered_channel<std::function<void()>>> tasks;
+  template <typename P, typename F, typename... Args>
+  internal::small_task make_async_task_(P&& p, F&& fun, Args&&... args)
+  {
+    return [f = std::forward<F>(fun), as = weak_from_this(), &args...,
+            p = std::move(p)]() mutable {
+      async_service.reset(&as);
+      try {
+        service_internal::helper<typename std::result_of<F(Args...)>::type>::
+            set(p, f, std::forward<Args>(args)...);
+      } catch (...) {
+        count_async_error_();
+        p.set_exception(std::current_exception());
+      };
+      async_service.reset(nullptr);
+    };
+  }
+
+  template <typename Submit, typename F, typename... Args>
+  typename std::result_of<F(Args...)>::type offload_(Submit&& submit, F& fun,
+                                                     Args&&... args)
+  {
+    asyik_round_robin::check_interrupt();
+    service_internal::offload_waiter<
+        typename std::result_of<F(Args...)>::type>
+        w;
+    auto as = weak_from_this();
+    // everything lives on this fiber's stack until wake(), so the task
+    // only holds references and stays within small_task's inline buffer
+    submit([&w, &as, &fun, &args...]() {
+      async_service.reset(&as);
+      try {
+        w.set(fun, std::forward<Args>(args)...);
+      } catch (...) {
+        count_async_error_();
+        w.error = std::current_exception();
+      };
+      async_service.reset(nullptr);
+      w.wake();
+    });
+    w.wait();
+    return w.get();
+  }
+
+  void run_polling(bool stop_on_complete);
+  void run_event_driven(bool stop_on_complete);
+  void run_busy_poll(bool stop_on_complete);
+
+  static std::shared_ptr<work_stealing_group> ws_group;
+  static offload_pool_ptr default_pool;
+  static std::atomic<async_scheduling> async_scheduling_;
   static std::shared_ptr<AixLog::Sink> default_log_sink;
 
   boost::fibers::condition_variable terminate_req_cond;
   boost::fibers::mutex terminate_req_mtx;
   pooled_guarded_stack fiber_stack_pool_;
+  std::shared_ptr<scheduler_counters> sched_counters_;
+  std::shared_ptr<std::atomic<bool>> sched_urgent_wakeup_;
+  std::function<void(const slow_slice&)> on_slow_slice_;
+  std::chrono::steady_clock::duration timer_resolution_{
+      std::chrono::milliseconds(1)};
+  bool lifo_slot_ = false;
+  std::time_t http_date_time_ = -1;
+  char http_date_[29];
+  std::size_t poll_io_();
+  static constexpr std::chrono::seconds stack_trim_interval{10};
+  boost::asio::steady_timer stack_trim_timer_{io_service};
+  void schedule_stack_trim_();
 
  public:
   friend service_ptr make_service();
@@ -196,7 +730,21 @@ inline static service_ptr get_current_service()
   return service::get_current_service();
 }
 
+/// service::offload() on the service the calling fiber belongs to; throws
+/// unexpected_error outside of a service.
+template <typename F, typename... Args>
+typename std::result_of<F(Args...)>::type offload(F&& fun, Args&&... args)
+{
+  auto as = service::get_current_service();
+  if (!as) throw unexpected_error("offload() called outside of a service");
+  return as->offload(std::forward<F>(fun), std::forward<Args>(args)...);
+}
+
 service_ptr make_service();
+/// Services whose execute() fibers get stacks of @p fiber_stack_size usable
+/// bytes, or stacks pooled as configured by @p fiber_stacks.
+service_ptr make_service(std::size_t fiber_stack_size);
+service_ptr make_service(const stack_pool_config& fiber_stacks);
 
 }  // namespace asyik
 
@@ -0,0 +1,87 @@
+#ifndef LIBASYIK_ASYIK_SERVICE_GROUP_HPP
+#define LIBASYIK_ASYIK_SERVICE_GROUP_HPP
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "service.hpp"
+
+namespace asyik {
+
+class service_group;
+using service_group_ptr = std::shared_ptr<service_group>;
+
+struct service_group_config {
+  // services to start, one thread each; 0 = one per CPU picked below
+  std::size_t services = 0;
+  // pin every service thread to one CPU, handing out the CPUs in order and
+  // wrapping around when there are more services than CPUs
+  bool pin = true;
+  // CPUs to pin to; empty = the CPUs of numa_nodes, or every CPU the
+  // process may run on
+  std::vector<int> cpus;
+  // keep the services on these NUMA nodes, e.g. the one the NIC is on
+  std::vector<int> numa_nodes;
+  // move async() and offload pool threads off the pinned CPUs while the
+  // group runs
+  bool reserve_cpus = true;
+  service_run_mode run_mode = service_run_mode::polling;
+  // fiber stacks of every service, see make_service()
+  stack_pool_config fiber_stacks;
+};
+
+// Thread-per-core set of services.
+//
+// start() spawns one thread per service, pins it, and only then creates the
+// service on it, so the memory a service allocates for itself is local to
+// the NUMA node of its core. The per-service init callback is where servers
+// are set up, typically an http_server bound with reuse_port = true on every
+// service, letting the kernel spread connections over them. The services
+// start running together once all of them are initialized.
+class service_group {
+ public:
+  using init_type = std::function<void(service_ptr as, std::size_t index)>;
+
+  ~service_group();
+  service_group(const service_group&) = delete;
+  service_group& operator=(const service_group&) = delete;
+
+  // Starts the services and returns when every one of them went through
+  // @p init and is about to run(). If @p init throws on any of them, none
+  // runs, and start() rethrows the first exception.
+  void start(init_type init = {});
+
+  // Stops every service; join() waits for their threads to exit.
+  void stop();
+  void join();
+
+  std::size_t size() const { return cpus_.size(); }
+  service_ptr get_service(std::size_t index) const;
+  // CPU the service runs on, -1 when not pinned
+  int get_cpu(std::size_t index) const { return cpus_.at(index); }
+  const service_group_config& config() const { return cfg_; }
+
+ private:
+  struct private_ {};
+
+ public:
+  service_group(private_, const service_group_config& cfg);
+
+ private:
+  service_group_config cfg_;
+  std::vector<int> cpus_;
+  std::vector<service_ptr> services_;
+  std::vector<std::thread> threads_;
+  bool started_ = false;
+  bool reserved_ = false;
+
+  friend service_group_ptr make_service_group(const service_group_config& cfg);
+};
+
+service_group_ptr make_service_group(const service_group_config& cfg = {});
+
+}  // namespace asyik
+
+#endif  // LIBASYIK_ASYIK_SERVICE_GROUP_HPP
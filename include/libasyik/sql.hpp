@@ -45,8 +45,13 @@ class sql_pool : public std::enable_shared_from_this<sql_pool> {
   sql_session_ptr get_session(service_ptr as);
   void set_health_check_period(int sec) { health_check_period = sec; }
 
+  // queries of this pool's sessions run here, one thread per connection at
+  // most, instead of on the default async() pool
+  const offload_pool_ptr& get_offload_pool() const { return offload_pool_; }
+
  private:
   fibers::mutex mtx_;
+  offload_pool_ptr offload_pool_;
   std::list<std::unique_ptr<soci::session>> soci_sessions;
   std::atomic<int> health_check_period;
 
@@ -60,6 +65,10 @@ sql_pool_ptr make_sql_pool(F&& factory, C&& connectString, size_t num_pool)
 {
   auto p = std::make_shared<sql_pool>(sql_pool::private_{});
 
+  offload_pool_config cfg;
+  cfg.max_threads = num_pool;
+  p->offload_pool_ = make_offload_pool("sql", cfg);
+
   for (size_t i = 0; i < num_pool; i++) {
     std::lock_guard<fibers::mutex> l(p->mtx_);
 
@@ -161,7 +170,7 @@ class sql_session : public std::enable_shared_from_this<sql_session> {
   void query(string_view s, Args&&... args)
   {
     service
-        ->async([&args..., s, ses = soci_session.get()]() {
+        ->async(offload, [&args..., s, ses = soci_session.get()]() {
           ((*ses << s), ..., std::forward<Args>(args));
         })
         .get();
@@ -187,7 +196,7 @@ class sql_session : public std::enable_shared_from_this<sql_session> {
   soci::rowset<soci::row> query_rows(string_view s, Args&&... args)
   {
     return service
-        ->async([&args..., s, ses = soci_session.get()]() {
+        ->async(offload, [&args..., s, ses = soci_session.get()]() {
           soci::rowset<soci::row> rs =
               ((ses->prepare << s), ..., std::forward<Args>(args));
           return rs;
@@ -202,6 +211,7 @@ class sql_session : public std::enable_shared_from_this<sql_session> {
  private:
   sql_pool_wptr pool;
   service_ptr service;
+  offload_pool_ptr offload;
 
  public:
   std::unique_ptr<soci::session> soci_session;
@@ -47,6 +47,49 @@ std::string route_spec_to_regex(string_view route_spc)
 
 }  // namespace internal
 
+http_response_template::http_response_template(http_result status,
+                                               header_list headers,
+                                               string_view body)
+    : status_(status), body_(body)
+{
+  namespace http = boost::beast::http;
+  bool has_server = false;
+  for (const auto& h : headers) {
+    auto f = http::string_to_field(h.first);
+    if (f == http::field::date || f == http::field::content_length ||
+        f == http::field::connection || f == http::field::transfer_encoding)
+      throw invalid_input_error("http_response_template sets " +
+                                std::string(h.first) + " by itself");
+    has_server = has_server || f == http::field::server;
+    headers_.emplace_back(std::string(h.first), std::string(h.second));
+  }
+
+  auto reason = http::obsolete_reason(static_cast<http::status>(status));
+  head_ = "HTTP/1.1 " + std::to_string(status) + " " + std::string(reason) +
+          "\r\n";
+  if (!has_server) head_ += "Server: " LIBASYIK_VERSION_STRING "\r\n";
+  for (const auto& h : headers_) head_ += h.first + ": " + h.second + "\r\n";
+  head_ += "Date: ";
+  date_at_ = head_.size();
+  head_ += std::string(29, ' ') + "\r\nContent-Length:";
+  full_ = head_ + " " + std::to_string(body_.size()) + "\r\n\r\n" + body_;
+  head_ += std::string(length_digits + 1, ' ') + "\r\n\r\n";
+}
+
+void http_response_template::fill(http_beast_response& res) const
+{
+  namespace http = boost::beast::http;
+  res.result(status_);
+  bool has_server = false;
+  for (const auto& h : headers_) {
+    res.insert(h.first, h.second);
+    has_server = has_server || http::string_to_field(h.first) ==
+                                   http::field::server;
+  }
+  if (!has_server) res.set(http::field::server, LIBASYIK_VERSION_STRING);
+  res.body() = body_;
+}
+
 bool http_analyze_url(string_view u, http_url_scheme& scheme)
 {
   namespace url = boost::urls;
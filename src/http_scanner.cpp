@@ -0,0 +1,263 @@
+#include "libasyik/internal/http_scanner.hpp"
+
+#include <strings.h>
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define LIBASYIK_HTTP_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace asyik {
+namespace internal {
+namespace http_scanner {
+
+namespace {
+
+// RFC 7230 tchar
+struct token_table {
+  bool is[256] = {};
+  constexpr token_table()
+  {
+    for (int c = '0'; c <= '9'; ++c) is[c] = true;
+    for (int c = 'a'; c <= 'z'; ++c) is[c] = is[c - 'a' + 'A'] = true;
+    for (char c : "!#$%&'*+-.^_`|~") is[static_cast<unsigned char>(c)] = true;
+    is[0] = false;  // the terminator of the string above
+  }
+};
+constexpr token_table tokens;
+
+inline bool is_token(char c)
+{
+  return tokens.is[static_cast<unsigned char>(c)];
+}
+
+// Every kernel returns the first byte in [p, end) it stops at, or end. The
+// name kernels may stop early at a byte that is a tchar after all; the caller
+// checks and carries on.
+
+const char* target_end_scalar(const char* p, const char* end)
+{
+  for (; p < end; ++p) {
+    auto c = static_cast<unsigned char>(*p);
+    if (c <= 0x20 || c == 0x7f) break;
+  }
+  return p;
+}
+
+const char* value_end_scalar(const char* p, const char* end)
+{
+  for (; p < end; ++p) {
+    auto c = static_cast<unsigned char>(*p);
+    if ((c < 0x20 && c != '\t') || c == 0x7f) break;
+  }
+  return p;
+}
+
+const char* name_end_scalar(const char* p, const char* end)
+{
+  while (p < end && is_token(*p)) ++p;
+  return p;
+}
+
+#ifdef LIBASYIK_HTTP_SCANNER_X86
+
+// _mm_cmpestri byte ranges, picohttpparser style; 16 bytes are loaded, plus
+// room for the literal's NUL
+alignas(16) const char target_stops[17] = "\x00\x20\x7f\x7f";
+alignas(16) const char value_stops[17] = "\x00\x08\x0a\x1f\x7f\x7f";
+// not a tchar, apart from '|' and '~' in the last range
+alignas(16) const char name_stops[17] =
+    "\x00\x20\"\"()\x2c\x2c//:@[]{\xff";
+
+__attribute__((target("sse4.2"))) const char* find_ranges_sse42(
+    const char* p, const char* end, const char* ranges, int ranges_size)
+{
+  const __m128i r = _mm_load_si128(reinterpret_cast<const __m128i*>(ranges));
+  for (; end - p >= 16; p += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int i = _mm_cmpestri(
+        r, ranges_size, v, 16,
+        _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+    if (i != 16) return p + i;
+  }
+  return p;
+}
+
+const char* target_end_sse42(const char* p, const char* end)
+{
+  return target_end_scalar(find_ranges_sse42(p, end, target_stops, 4), end);
+}
+
+const char* value_end_sse42(const char* p, const char* end)
+{
+  return value_end_scalar(find_ranges_sse42(p, end, value_stops, 6), end);
+}
+
+const char* name_end_sse42(const char* p, const char* end)
+{
+  return name_end_scalar(find_ranges_sse42(p, end, name_stops, 16), end);
+}
+
+// bytes up to @p max, plus DEL, minus HTAB unless @p tab stops too
+template <bool Tab>
+__attribute__((target("avx2"))) const char* find_ctl_avx2(const char* p,
+                                                          const char* end,
+                                                          char max)
+{
+  const __m256i hi = _mm256_set1_epi8(max);
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  const __m256i tab = _mm256_set1_epi8('\t');
+  for (; end - p >= 32; p += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i stop = _mm256_cmpeq_epi8(_mm256_max_epu8(v, hi), hi);
+    if (!Tab) stop = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, tab), stop);
+    stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, del));
+    if (unsigned m = static_cast<unsigned>(_mm256_movemask_epi8(stop)))
+      return p + __builtin_ctz(m);
+  }
+  return p;
+}
+
+const char* target_end_avx2(const char* p, const char* end)
+{
+  return target_end_scalar(find_ctl_avx2<true>(p, end, 0x20), end);
+}
+
+const char* value_end_avx2(const char* p, const char* end)
+{
+  return value_end_scalar(find_ctl_avx2<false>(p, end, 0x1f), end);
+}
+
+#endif
+
+struct kernels {
+  const char* (*target_end)(const char*, const char*);
+  const char* (*value_end)(const char*, const char*);
+  const char* (*name_end)(const char*, const char*);
+  const char* isa;
+};
+
+kernels pick_kernels()
+{
+#ifdef LIBASYIK_HTTP_SCANNER_X86
+  __builtin_cpu_init();
+  // field names are short: 16 bytes at a time is plenty for them
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2"))
+    return {target_end_avx2, value_end_avx2, name_end_sse42, "avx2"};
+  if (__builtin_cpu_supports("sse4.2"))
+    return {target_end_sse42, value_end_sse42, name_end_sse42, "sse4.2"};
+#endif
+  return {target_end_scalar, value_end_scalar, name_end_scalar, "scalar"};
+}
+
+const kernels active = pick_kernels();
+
+bool iequals(string_view a, const char* b, std::size_t n)
+{
+  return a.size() == n && strncasecmp(a.data(), b, n) == 0;
+}
+
+bool parse_length(string_view v, uint64_t& n)
+{
+  if (v.empty()) return false;
+  n = 0;
+  for (char c : v) {
+    if (c < '0' || c > '9' || n > (UINT64_MAX - 9) / 10) return false;
+    n = n * 10 + (c - '0');
+  }
+  return true;
+}
+
+}  // namespace
+
+scan_status scan_request(const char* data, std::size_t size,
+                         request_head& head)
+{
+  const char* p = data;
+  const char* end = data + size;
+
+  // request-line = method SP request-target SP HTTP-version CRLF
+  const char* tok = p;
+  p = name_end_scalar(p, end);
+  if (p == end) return scan_status::partial;
+  if (p == tok || *p != ' ') return scan_status::fallback;
+  head.method = string_view(tok, p - tok);
+
+  tok = ++p;
+  p = active.target_end(p, end);
+  if (p == end) return scan_status::partial;
+  if (p == tok || *p != ' ') return scan_status::fallback;
+  head.target = string_view(tok, p - tok);
+
+  ++p;
+  if (end - p < 10) return scan_status::partial;
+  if (std::memcmp(p, "HTTP/1.", 7) != 0 || (p[7] != '0' && p[7] != '1') ||
+      p[8] != '\r' || p[9] != '\n')
+    return scan_status::fallback;
+  head.version = p[7] == '1' ? 11 : 10;
+  p += 10;
+
+  // *( field-name ":" OWS field-value OWS CRLF ) CRLF
+  head.num_headers = 0;
+  head.content_length = 0;
+  bool has_length = false;
+  while (true) {
+    if (p == end) return scan_status::partial;
+    if (*p == '\r') {
+      if (end - p < 2) return scan_status::partial;
+      if (p[1] != '\n') return scan_status::fallback;
+      p += 2;
+      break;
+    }
+    // obsolete line folding is for beast to reject or unfold
+    if (head.num_headers == max_headers || *p == ' ' || *p == '\t')
+      return scan_status::fallback;
+
+    tok = p;
+    while ((p = active.name_end(p, end)) < end && is_token(*p)) ++p;
+    if (p == end) return scan_status::partial;
+    if (p == tok || *p != ':') return scan_status::fallback;
+    string_view name(tok, p - tok);
+
+    ++p;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    tok = p;
+    p = active.value_end(p, end);
+    if (end - p < 2) return scan_status::partial;
+    if (p[0] != '\r' || p[1] != '\n') return scan_status::fallback;
+    const char* value_end = p;
+    while (value_end > tok && (value_end[-1] == ' ' || value_end[-1] == '\t'))
+      --value_end;
+    string_view value(tok, value_end - tok);
+    p += 2;
+
+    if (iequals(name, "content-length", 14)) {
+      if (has_length || !parse_length(value, head.content_length))
+        return scan_status::fallback;
+      has_length = true;
+    } else if (iequals(name, "transfer-encoding", 17)) {
+      return scan_status::fallback;
+    }
+    head.headers[head.num_headers++] = header{name, value};
+  }
+
+  head.size = static_cast<std::size_t>(p - data);
+  return scan_status::complete;
+}
+
+string_view request_head::field(string_view name) const
+{
+  for (std::size_t i = 0; i < num_headers; ++i)
+    if (iequals(headers[i].name, name.data(), name.size()))
+      return headers[i].value;
+  return {};
+}
+
+const char* scan_isa() { return active.isa; }
+
+}  // namespace http_scanner
+}  // namespace internal
+}  // namespace asyik
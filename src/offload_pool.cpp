@@ -0,0 +1,251 @@
+#include "libasyik/offload_pool.hpp"
+
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include "aixlog.hpp"
+#include "boost/fiber/all.hpp"
+#include "libasyik/internal/cpu_affinity.hpp"
+#include "libasyik/internal/task_stats.hpp"
+
+namespace fibers = boost::fibers;
+using fiber = boost::fibers::fiber;
+
+namespace asyik {
+
+struct offload_pool::core : std::enable_shared_from_this<core> {
+  using clock = std::chrono::steady_clock;
+
+  struct item {
+    task_type fn;
+    clock::time_point queued_at;
+  };
+
+  static std::size_t channel_capacity(std::size_t n)
+  {
+    // buffered_channel wants a power of two
+    std::size_t c = 2;
+    while (c < n) c <<= 1;
+    return c;
+  }
+
+  core(std::string n, const offload_pool_config& c)
+      : name(std::move(n)), cfg(c), queue(channel_capacity(c.max_queue))
+  {
+    if (!cfg.max_threads)
+      cfg.max_threads = std::max(1u, std::thread::hardware_concurrency());
+    cfg.min_threads = std::min(cfg.min_threads, cfg.max_threads);
+    cfg.max_queue = channel_capacity(cfg.max_queue);
+  }
+
+  void submit(task_type&& t)
+  {
+    // a task that no idle worker is going to pick up gets a new thread, as
+    // long as the pool is allowed to grow. Sequentially consistent, pairs
+    // with the timeout branch of worker(): either this sees the worker gone
+    // from idle, or the worker sees the task and stays
+    if (queue_size.fetch_add(1) + 1 > static_cast<long>(idle.load()))
+      try_grow();
+
+    if (queue.push(item{std::move(t), clock::now()}) !=
+        fibers::channel_op_status::success) {
+      queue_size.fetch_sub(1, std::memory_order_relaxed);
+      throw std::runtime_error("offload pool '" + name + "' is shut down");
+    }
+  }
+
+  void try_grow()
+  {
+    if (!reserve_thread()) return;
+    try {
+      start_thread();
+    } catch (const std::system_error& e) {
+      // the task stays queued for the threads there are, or for the next
+      // submit() to try again
+      threads.fetch_sub(1);
+      LOG(ERROR) << "offload pool '" << name
+                 << "': cannot start a thread: " << e.what() << "\n";
+    }
+  }
+
+  // counts one more thread, unless the pool is at max_threads
+  bool reserve_thread()
+  {
+    auto n = threads.load();
+    do {
+      if (n >= cfg.max_threads) return false;
+    } while (!threads.compare_exchange_weak(n, n + 1));
+
+    auto peak = peak_threads.load(std::memory_order_relaxed);
+    while (peak < n + 1 && !peak_threads.compare_exchange_weak(peak, n + 1))
+      ;
+    return true;
+  }
+
+  // threads above min_threads leave once idle for too long
+  bool try_shrink()
+  {
+    auto n = threads.load(std::memory_order_relaxed);
+    do {
+      if (n <= cfg.min_threads) return false;
+    } while (!threads.compare_exchange_weak(n, n - 1));
+    return true;
+  }
+
+  void start_thread()
+  {
+    std::thread th([self = shared_from_this()]() { self->worker(); });
+    th.detach();
+  }
+
+  void setup_thread()
+  {
+    std::string tname = "asyik:" + name;
+    tname.resize(std::min<std::size_t>(tname.size(), 15));
+    pthread_setname_np(pthread_self(), tname.c_str());
+
+    if (cfg.priority &&
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)),
+                    cfg.priority) != 0)
+      LOG(WARNING) << "offload pool '" << name << "': cannot set priority "
+                   << cfg.priority << ": " << std::strerror(errno) << "\n";
+  }
+
+  void worker()
+  {
+    setup_thread();
+    // fibers spawned by this thread that are still running; only touched on
+    // this thread, the worker's fibers never migrate
+    int live = 0;
+    uint64_t placed = ~uint64_t(0);
+
+    item it;
+    for (;;) {
+      // follow service_group CPU reservations made since the last task
+      auto gen = internal::reserved_cpus_generation();
+      if (gen != placed && (placed == ~uint64_t(0) || cfg.cpus.empty())) {
+        placed = gen;
+        internal::place_offload_thread(cfg.cpus);
+      }
+
+      idle.fetch_add(1, std::memory_order_relaxed);
+      auto st = queue.pop_wait_for(it, cfg.idle_timeout);
+      idle.fetch_sub(1);
+
+      if (st == fibers::channel_op_status::closed) {
+        threads.fetch_sub(1, std::memory_order_relaxed);
+        break;
+      }
+      if (st == fibers::channel_op_status::timeout) {
+        // a submit() that still counted this thread as idle did not grow
+        // the pool for its task: stay for it, unless the pool is full again
+        if (!live && try_shrink() && (!queue_size.load() || !reserve_thread()))
+          break;
+        continue;
+      }
+
+      queue_size.fetch_sub(1, std::memory_order_relaxed);
+      counters.waited(std::chrono::duration_cast<std::chrono::microseconds>(
+                          clock::now() - it.queued_at)
+                          .count());
+
+      ++live;
+      fiber fb([this, &live, fn = std::move(it.fn)]() mutable {
+        auto t0 = clock::now();
+        counters.started();
+        fn();
+        // release captures while the task is still accounted as running
+        fn = {};
+        counters.terminated(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                clock::now() - t0)
+                .count());
+        --live;
+      });
+      fb.detach();
+      // run the task until it finishes or waits on a fiber primitive before
+      // counting this thread as idle again; a task that blocks the thread
+      // must not hide behind an idle count, or submit() would not grow
+      boost::this_fiber::yield();
+    }
+
+    // fibers of this thread still reference `live`
+    while (live) boost::this_fiber::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  void shutdown() { queue.close(); }
+
+  offload_pool_stats stats()
+  {
+    offload_pool_stats s;
+    s.threads = static_cast<uint32_t>(threads.load());
+    s.idle_threads = static_cast<uint32_t>(idle.load());
+    s.peak_threads = static_cast<uint32_t>(peak_threads.load());
+    s.queue_size = static_cast<uint32_t>(std::max(0L, queue_size.load()));
+    auto t = counters.sum();
+    s.task_started = t.started;
+    s.task_terminated = t.terminated;
+    s.queue_wait_total_us = t.queue_wait_total_us;
+    s.queue_wait_max_us = t.queue_wait_max_us;
+    s.queue_wait = t.queue_wait;
+    s.run_time_total_us = t.run_time_total_us;
+    s.run_time = t.run_time;
+    return s;
+  }
+
+  const std::string name;
+  offload_pool_config cfg;
+
+  // the same fiber-aware channel the fixed pool used: submitters block (as
+  // fibers) while it is full, idle workers wait on it with a timeout
+  fibers::buffered_channel<item> queue;
+
+  std::atomic<std::size_t> threads{0};
+  std::atomic<std::size_t> idle{0};
+  std::atomic<std::size_t> peak_threads{0};
+  std::atomic<long> queue_size{0};
+
+  internal::task_stats counters;
+};
+
+offload_pool::offload_pool(private_, std::string name,
+                           const offload_pool_config& cfg)
+    : core_(std::make_shared<core>(std::move(name), cfg))
+{
+}
+
+offload_pool::~offload_pool() { core_->shutdown(); }
+
+void offload_pool::submit(task_type&& t) { core_->submit(std::move(t)); }
+
+const std::string& offload_pool::name() const { return core_->name; }
+
+const offload_pool_config& offload_pool::config() const { return core_->cfg; }
+
+offload_pool_stats offload_pool::get_stats() const { return core_->stats(); }
+
+void offload_pool::shutdown() { core_->shutdown(); }
+
+offload_pool_ptr make_offload_pool(std::string name,
+                                   const offload_pool_config& cfg)
+{
+  auto p = std::make_shared<offload_pool>(offload_pool::private_{},
+                                          std::move(name), cfg);
+  auto& c = *p->core_;
+  c.threads = c.cfg.min_threads;
+  c.peak_threads = c.cfg.min_threads;
+  for (std::size_t i = 0; i < c.cfg.min_threads; ++i) c.start_thread();
+  return p;
+}
+
+}  // namespace asyik
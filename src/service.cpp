@@ -1,13 +1,17 @@
 #include "libasyik/service.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <regex>
 
 #include "aixlog.hpp"
 #include "boost/fiber/all.hpp"
 #include "libasyik/asyik_round_robin.hpp"
+#include "libasyik/internal/cpu_affinity.hpp"
+#include "libasyik/internal/task_stats.hpp"
 
 namespace ip = boost::asio::ip;
 namespace asio = boost::asio;
@@ -18,46 +22,184 @@ namespace asyik {
 std::chrono::time_point<std::chrono::high_resolution_clock>
     service::start;  //!!!
 
-std::shared_ptr<fibers::buffered_channel<std::function<void()>>> service::tasks;
+std::shared_ptr<work_stealing_group> service::ws_group;
+offload_pool_ptr service::default_pool;
+std::atomic<async_scheduling> service::async_scheduling_{
+    async_scheduling::shared_queue};
+// points into the running async() task, nothing to clean up
+fibers::fiber_specific_ptr<service_wptr> service::async_service(
+    [](service_wptr*) {});
 std::shared_ptr<AixLog::Sink> service::default_log_sink;
 
 service::service(struct service::private_&&)
     : stopped(false),
       io_service(),
       strand(io_service),
-      execute_tasks(
-          std::make_shared<fibers::buffered_channel<std::function<void()>>>(
-              1024))
+      execute_node_pool_(std::make_shared<lockfree_block_pool>(
+          sizeof(service_internal::execute_node), execute_queue_capacity)),
+      promise_pool_(std::make_shared<lockfree_block_pool>(
+          promise_block_size, execute_queue_capacity))
 {
   if (!default_log_sink)
     default_log_sink =
         AixLog::Log::init<AixLog::SinkCout>(AixLog::Severity::info);
   fibers::use_scheduling_algorithm<asyik::asyik_round_robin>();
+  sched_counters_ = asyik_round_robin::current()->counters();
+  sched_urgent_wakeup_ = asyik_round_robin::current()->urgent_wakeup();
   execute_task_count = 0;
 }
 
+service::~service()
+{
+  // tasks that never got to run; destroying them breaks their promises
+  while (auto* n = execute_queue_.pop()) free_execute_node_(n);
+}
+
 service_ptr make_service()
 {
   return std::make_shared<service>(service::private_{});
 }
 
-std::atomic<uint32_t> service::async_task_started;
-std::atomic<uint32_t> service::async_task_terminated;
-std::atomic<uint32_t> service::async_task_error;
-std::atomic<uint32_t> service::async_queue_size;
+service_ptr make_service(std::size_t fiber_stack_size)
+{
+  stack_pool_config cfg;
+  cfg.stack_size = fiber_stack_size;
+  return make_service(cfg);
+}
+
+service_ptr make_service(const stack_pool_config& fiber_stacks)
+{
+  auto as = make_service();
+  as->set_fiber_stack_config(fiber_stacks);
+  return as;
+}
+
+namespace {
+// Errors of every async() pool, and the tasks of the work-stealing pool.
+// Never freed: detached workers may still count during static destruction.
+internal::task_stats& async_counters()
+{
+  static auto* c = new internal::task_stats;
+  return *c;
+}
+}  // namespace
+
+void service::count_async_error_() noexcept { async_counters().failed(); }
 
 async_stats service::get_async_stats()
 {
-  async_stats stats;
+  async_stats stats{};
+
+  auto t = async_counters().sum();
+  stats.task_started = t.started;
+  stats.task_terminated = t.terminated;
+  stats.task_error = t.errors;
+  stats.queue_size = static_cast<uint32_t>(std::max<int64_t>(t.queued, 0));
+  stats.run_time_total_us = t.run_time_total_us;
+  stats.run_time = t.run_time;
+
+  if (auto pool = std::atomic_load(&default_pool)) {
+    auto ps = pool->get_stats();
+    stats.task_started = ps.task_started;
+    stats.task_terminated = ps.task_terminated;
+    stats.queue_size = ps.queue_size;
+    stats.run_time_total_us = ps.run_time_total_us;
+    stats.run_time = ps.run_time;
+    stats.threads = ps.threads;
+    stats.queue_wait_total_us = ps.queue_wait_total_us;
+    stats.queue_wait_max_us = ps.queue_wait_max_us;
+    stats.queue_wait = ps.queue_wait;
+  }
+  if (auto group = std::atomic_load(&ws_group)) {
+    stats.task_steals = group->task_steals();
+    stats.fiber_steals = group->fiber_steals();
+    stats.worker_queue_size = group->queue_depths();
+  }
 
-  stats.task_started = async_task_started;
-  stats.task_terminated = async_task_terminated;
-  stats.task_error = async_task_error;
-  stats.queue_size = async_queue_size;
+  return stats;
+}
+
+string_view service::http_date()
+{
+  std::time_t now = std::time(nullptr);
+  if (now != http_date_time_) {
+    // by hand: strftime() would follow the locale
+    static const char days[] = "SunMonTueWedThuFriSat";
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    std::tm tm;
+    gmtime_r(&now, &tm);
+    auto two = [](char* p, int v) {
+      p[0] = static_cast<char>('0' + v / 10);
+      p[1] = static_cast<char>('0' + v % 10);
+    };
+    char* p = http_date_;
+    std::memcpy(p, days + 3 * tm.tm_wday, 3);
+    std::memcpy(p + 3, ", ", 2);
+    two(p + 5, tm.tm_mday);
+    p[7] = ' ';
+    std::memcpy(p + 8, months + 3 * tm.tm_mon, 3);
+    p[11] = ' ';
+    two(p + 12, (tm.tm_year + 1900) / 100);
+    two(p + 14, (tm.tm_year + 1900) % 100);
+    p[16] = ' ';
+    two(p + 17, tm.tm_hour);
+    p[19] = ':';
+    two(p + 20, tm.tm_min);
+    p[22] = ':';
+    two(p + 23, tm.tm_sec);
+    std::memcpy(p + 25, " GMT", 4);
+    http_date_time_ = now;
+  }
+  return string_view(http_date_, sizeof(http_date_));
+}
 
+scheduler_stats service::get_scheduler_stats() const
+{
+  const auto& c = *sched_counters_;
+  scheduler_stats stats{};
+  stats.context_switches = c.context_switches.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < stats.ready_depth.size(); ++i)
+    stats.ready_depth[i] = c.ready_depth[i].load(std::memory_order_relaxed);
+  stats.suspend_ns = c.suspend_ns.load(std::memory_order_relaxed);
+  stats.reactor_wait_ns = c.reactor_wait_ns.load(std::memory_order_relaxed);
+  stats.fiber_run_ns = c.fiber_run_ns.load(std::memory_order_relaxed);
+  stats.io_poll_ns = c.io_poll_ns.load(std::memory_order_relaxed);
+  stats.live_fibers = static_cast<uint32_t>(
+      std::max(0, active_fiber_count.load(std::memory_order_relaxed)));
+  stats.parked_fibers = parked_fiber_count_.load(std::memory_order_relaxed);
+  stats.slow_slices = c.slow_slices.load(std::memory_order_relaxed);
+  stats.slow_slice_ns = c.slow_slice_ns.load(std::memory_order_relaxed);
+  stats.slow_slice_max_ns =
+      c.slow_slice_max_ns.load(std::memory_order_relaxed);
+  stats.busy_polls = c.busy_polls.load(std::memory_order_relaxed);
+  stats.busy_polls_empty = c.busy_polls_empty.load(std::memory_order_relaxed);
+  stats.lifo_handoffs = c.lifo_handoffs.load(std::memory_order_relaxed);
+  stats.lifo_demotions = c.lifo_demotions.load(std::memory_order_relaxed);
   return stats;
 }
 
+void service::set_watchdog(std::chrono::nanoseconds budget,
+                           std::function<void(const slow_slice&)> on_slow_slice)
+{
+  if (!on_slow_slice)
+    on_slow_slice = [](const slow_slice& s) {
+      LOG(WARNING) << "fiber " << s.fiber << " ran for "
+                   << s.duration.count() / 1000 << "us without yielding"
+                   << (s.label.empty() ? "" : ", in ") << s.label << "\n";
+    };
+  on_slow_slice_ = std::move(on_slow_slice);
+  sched_counters_->watchdog_budget_ns.store(
+      static_cast<uint64_t>(std::max<int64_t>(0, budget.count())),
+      std::memory_order_relaxed);
+}
+
+void service::set_async_scheduling(async_scheduling s)
+{
+  async_scheduling_ = s;
+}
+
+async_scheduling service::get_async_scheduling() { return async_scheduling_; }
+
 thread_local service_wptr service::active_service;
 void service::run(bool stop_on_complete)
 {
@@ -66,71 +208,23 @@ void service::run(bool stop_on_complete)
                    "use different thread and create new service!");
 
   service::active_service = shared_from_this();
-  fiber fb([as = shared_from_this()]() {
-    std::function<void()> tsk;
-    while (!as->stopped && boost::fibers::channel_op_status::closed !=
-                               as->execute_tasks->pop(tsk)) {
-      as->active_fiber_count.fetch_add(1, std::memory_order_relaxed);
-      fiber fb(std::allocator_arg, as->fiber_stack_pool_,
-               [tsk_in = std::move(tsk), as]() mutable {
-                 // RAII guard: decrement the counter when this fiber finishes,
-                 // regardless of exceptions. The guard destructor runs inside
-                 // the still-active fiber (before Boost.Fiber GC takes over),
-                 // so the decrement is always visible to the post-drain wait
-                 // loop.
-                 struct FiberGuard {
-                   std::atomic<int>& ctr;
-                   ~FiberGuard() noexcept
-                   {
-                     ctr.fetch_sub(1, std::memory_order_release);
-                   }
-                 } guard{as->active_fiber_count};
-
-                 tsk_in();
-
-                 // Eagerly destroy captured objects (beast streams, websockets,
-                 // any Asio-registered handles) HERE, while this fiber is still
-                 // executing and the io_context is provably alive.  When
-                 // Boost.Fiber later reclaims this fiber's context, tsk_in is
-                 // already empty so its destructor is a no-op and the
-                 // use-after-free race is eliminated.
-                 tsk_in = {};
-               });
-      fb.detach();
-    }
-  });
+  asyik_round_robin::current()->on_slow_slice(on_slow_slice_);
+  asyik_round_robin::current()->set_timer_resolution(timer_resolution_);
+  asyik_round_robin::current()->set_lifo_slot(lifo_slot_);
+  fiber fb([as = shared_from_this()]() { as->dispatch_execute_tasks_(); });
+  schedule_stack_trim_();
 
-  std::shared_ptr<boost::asio::io_service::work> work;
+  if (run_mode_ == service_run_mode::event_driven)
+    run_event_driven(stop_on_complete);
+  else if (run_mode_ == service_run_mode::busy_poll)
+    run_busy_poll(stop_on_complete);
+  else
+    run_polling(stop_on_complete);
 
-  // in-thread io_service loop
-  // Use adaptive sleep to avoid busy-polling and excessive clock_gettime
-  // syscalls, which are especially expensive on VPS/cloud environments where
-  // clock_gettime may not be handled by vDSO and becomes a real syscall.
-  int idle_count = 0;
-  while (!stopped && (!stop_on_complete || execute_task_count > 0)) {
-    if (io_service.poll()) {
-      idle_count = 0;
-    } else {
-      idle_count++;
-      if (idle_count < 100) {
-        // brief spin phase: yield to other fibers quickly
-        boost::this_fiber::yield();
-      } else if (idle_count < 200) {
-        // short sleep phase (use boost directly to avoid check_interrupt
-        // in the service run-loop; the main fiber must not be interrupted)
-        boost::this_fiber::sleep_for(std::chrono::microseconds(100));
-      } else {
-        // deep idle: sleep longer to minimize CPU/syscall overhead
-        boost::this_fiber::sleep_for(std::chrono::milliseconds(5));
-      }
-    }
-    if (!stopped && (!stop_on_complete || execute_task_count > 0))
-      io_service.restart();
-  }
-
-  execute_tasks->close();
+  stack_trim_timer_.cancel();
+  close_execute_queue_();
 
-  // Phase 1: drain the task channel – give all dispatched-but-not-yet-started
+  // Phase 1: drain the task queue – give all dispatched-but-not-yet-started
   // fibers a chance to pick up their task and begin executing.
   for (int i = 0; i < 200; i++) {
     io_service.poll();
@@ -193,6 +287,275 @@ void service::run(bool stop_on_complete)
   service::active_service.reset();
 }
 
+void service::schedule_stack_trim_()
+{
+  // give the memory of stacks left over from a burst of fibers back to the
+  // kernel; the pool keeps their mappings for the next burst
+  stack_trim_timer_.expires_after(stack_trim_interval);
+  stack_trim_timer_.async_wait([this](const boost::system::error_code& ec) {
+    if (ec) return;
+    fiber_stack_pool_.trim();
+    schedule_stack_trim_();
+  });
+}
+
+void service::post_execute_(service_internal::execute_node* n)
+{
+  // execute_pending_ works as a semaphore count: only a producer that finds
+  // execute_queue_capacity tasks already pending waits for the dispatcher to
+  // hand it a slot, exactly one per task popped
+  bool ring;
+  if (execute_pending_.fetch_add(1, std::memory_order_seq_cst) >=
+          execute_queue_capacity &&
+      execute_space_.pop(ring) == fibers::channel_op_status::closed) {
+    // service already stopped, like a push to a closed channel
+    free_execute_node_(n);
+    return;
+  }
+
+  // n may be gone once pushed
+  bool urgent = n->priority == fiber_priority::high;
+  if (urgent) execute_urgent_.store(true, std::memory_order_relaxed);
+  execute_queue_.push(n);
+  // only the first task after the dispatcher parked pays for a wakeup; a high
+  // priority one also has the scheduler pick that up ahead of its ready fibers
+  if (execute_parked_.load(std::memory_order_seq_cst) &&
+      execute_parked_.exchange(false, std::memory_order_seq_cst) &&
+      execute_doorbell_.try_push(true) == fibers::channel_op_status::success &&
+      urgent)
+    sched_urgent_wakeup_->store(true, std::memory_order_relaxed);
+}
+
+void service::dispatch_execute_tasks_()
+{
+  service_ptr as = shared_from_this();
+  auto* sched = asyik_round_robin::current();
+  auto* self = boost::fibers::context::active();
+  while (!stopped) {
+    service_internal::execute_node* n;
+    while (!stopped && (n = execute_queue_.pop())) {
+      if (execute_pending_.fetch_sub(1, std::memory_order_seq_cst) >
+          execute_queue_capacity)
+        execute_space_.push(true);
+
+      active_fiber_count.fetch_add(1, std::memory_order_relaxed);
+      if (!idle_fibers_.empty()) {
+        // a parked fiber takes the task; no fiber set-up or tear-down
+        auto* pf = idle_fibers_.back();
+        idle_fibers_.pop_back();
+        parked_fiber_count_.store(idle_fibers_.size(),
+                                  std::memory_order_relaxed);
+        pf->task = n;
+        asyik_round_robin::set_priority(pf->ctx, n->priority);
+        self->schedule(pf->ctx);
+        continue;
+      }
+      sched->set_launch_priority(n->priority);
+      try {
+        fiber fb(std::allocator_arg, fiber_stack_pool_,
+                 [n, as]() { as->run_pooled_fiber_(n); });
+        fb.detach();
+      } catch (const std::exception& e) {
+        // no fiber got the class, so the next one launched must not either;
+        // dropping the task breaks its promise
+        sched->set_launch_priority(fiber_priority::normal);
+        active_fiber_count.fetch_sub(1, std::memory_order_relaxed);
+        free_execute_node_(n);
+        LOG(ERROR) << "execute(): cannot launch a fiber: " << e.what()
+                   << "\n";
+      }
+    }
+    if (stopped) break;
+
+    // a producer is half-way through push(), its task shows up shortly
+    if (!execute_queue_.empty()) {
+      boost::this_fiber::yield();
+      continue;
+    }
+
+    execute_parked_.store(true, std::memory_order_seq_cst);
+    // re-check after publishing the parked flag, pairs with post_execute_();
+    // a ring that races with this is only a spurious wakeup later
+    if (!execute_queue_.empty()) {
+      execute_parked_.store(false, std::memory_order_relaxed);
+      continue;
+    }
+    // Wake up ahead of normal fibers, or a high priority task would wait a
+    // full scheduling round before it even gets a fiber
+    asyik_round_robin::set_priority(self, fiber_priority::high);
+    bool ring;
+    auto st = execute_doorbell_.pop(ring);
+    asyik_round_robin::set_priority(self, fiber_priority::normal);
+    if (st == fibers::channel_op_status::closed) break;
+    // Without one, keep the pace of a normal fiber: waiting a round lets the
+    // running fibers finish, and keeps their number in check while tasks
+    // keep coming
+    if (!execute_urgent_.exchange(false, std::memory_order_relaxed))
+      boost::this_fiber::yield();
+  }
+  release_idle_fibers_();
+}
+
+void service::run_pooled_fiber_(service_internal::execute_node* n)
+{
+  pooled_fiber self{boost::fibers::context::active(), n};
+  while (self.task) {
+    {
+      // RAII guard: decrement the counter when this task finishes,
+      // regardless of exceptions. The guard destructor runs inside the
+      // still-active fiber (before Boost.Fiber GC takes over), so the
+      // decrement is always visible to the post-drain wait loop.
+      struct FiberGuard {
+        std::atomic<int>& ctr;
+        ~FiberGuard() noexcept { ctr.fetch_sub(1, std::memory_order_release); }
+      } guard{active_fiber_count};
+
+      // Eagerly destroy captured objects (beast streams, websockets, any
+      // Asio-registered handles) together with the node, while this fiber
+      // is still executing and the io_context is provably alive, instead
+      // of leaving them to Boost.Fiber's later reclaim of this context.
+      struct NodeGuard {
+        service& as;
+        service_internal::execute_node* n;
+        ~NodeGuard() noexcept { as.free_execute_node_(n); }
+      } node_guard{*this, self.task};
+
+      self.task->fn();
+    }
+
+    if (fiber_pool_closed_ || idle_fibers_.size() >= fiber_pool_size_) break;
+    self.task = nullptr;
+    idle_fibers_.push_back(&self);
+    parked_fiber_count_.store(idle_fibers_.size(), std::memory_order_relaxed);
+    self.ctx->suspend();  // until the dispatcher hands over a task, or
+                          // release_idle_fibers_() lets it exit
+  }
+}
+
+void service::release_idle_fibers_()
+{
+  fiber_pool_closed_ = true;
+  auto* self = boost::fibers::context::active();
+  for (auto* pf : idle_fibers_) self->schedule(pf->ctx);
+  idle_fibers_.clear();
+  parked_fiber_count_.store(0, std::memory_order_relaxed);
+}
+
+void service::free_execute_node_(service_internal::execute_node* n) noexcept
+{
+  n->~execute_node();
+  execute_node_pool_->deallocate(n, sizeof(service_internal::execute_node));
+}
+
+void service::close_execute_queue_()
+{
+  execute_space_.close();
+  execute_doorbell_.close();
+}
+
+void service::run_polling(bool stop_on_complete)
+{
+  // in-thread io_service loop
+  // Use adaptive sleep to avoid busy-polling and excessive clock_gettime
+  // syscalls, which are especially expensive on VPS/cloud environments where
+  // clock_gettime may not be handled by vDSO and becomes a real syscall.
+  int idle_count = 0;
+  while (!stopped && (!stop_on_complete || execute_task_count > 0)) {
+    if (poll_io_()) {
+      idle_count = 0;
+    } else {
+      idle_count++;
+      if (idle_count < 100) {
+        // brief spin phase: yield to other fibers quickly
+        boost::this_fiber::yield();
+      } else if (idle_count < 200) {
+        // short sleep phase (use boost directly to avoid check_interrupt
+        // in the service run-loop; the main fiber must not be interrupted)
+        boost::this_fiber::sleep_for(std::chrono::microseconds(100));
+      } else {
+        // deep idle: sleep longer to minimize CPU/syscall overhead
+        boost::this_fiber::sleep_for(std::chrono::milliseconds(5));
+      }
+    }
+    if (!stopped && (!stop_on_complete || execute_task_count > 0))
+      io_service.restart();
+  }
+}
+
+std::size_t service::poll_io_()
+{
+  if (!sched_counters_->timing.load(std::memory_order_relaxed))
+    return io_service.poll();
+  auto t0 = std::chrono::steady_clock::now();
+  auto n = io_service.poll();
+  scheduler_counters::add(sched_counters_->io_poll_ns,
+                          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - t0)
+                              .count());
+  return n;
+}
+
+void service::run_event_driven(bool stop_on_complete)
+{
+  auto* sched = asyik_round_robin::current();
+  BOOST_ASSERT_MSG(sched, "service::run() must be called from the thread "
+                          "that created the service");
+
+  // keep run_one_until() blocking even when no I/O is pending
+  auto work = asio::make_work_guard(io_service);
+  sched->attach_reactor(&io_service);
+  // detach before io_service goes away, even if a handler throws
+  struct reactor_detach {
+    asyik_round_robin* sched;
+    ~reactor_detach() { sched->attach_reactor(nullptr); }
+  } detach{sched};
+
+  auto keep_running = [this, stop_on_complete]() {
+    return !stopped && (!stop_on_complete || execute_task_count > 0);
+  };
+
+  while (keep_running()) {
+    poll_io_();
+
+    // Let every other ready fiber run once. The scheduler returns either
+    // min() (others still runnable: just poll again) or the earliest fiber
+    // deadline, in which case nothing can happen on this thread until an
+    // I/O event, that deadline, or a cross-thread wakeup.
+    auto deadline = sched->park_until_idle();
+    if (deadline != (std::chrono::steady_clock::time_point::min)() &&
+        keep_running()) {
+      auto t0 = std::chrono::steady_clock::now();
+      io_service.run_one_until(deadline);
+      scheduler_counters::add(
+          sched_counters_->reactor_wait_ns,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - t0)
+              .count());
+    }
+  }
+}
+
+void service::run_busy_poll(bool stop_on_complete)
+{
+  auto* sched = asyik_round_robin::current();
+  BOOST_ASSERT_MSG(sched, "service::run() must be called from the thread "
+                          "that created the service");
+
+  // poll() would otherwise stop the io_context whenever it runs out of work
+  auto work = asio::make_work_guard(io_service);
+  auto& c = *sched_counters_;
+  while (!stopped && (!stop_on_complete || execute_task_count > 0)) {
+    // fibers woken from other threads only reach the ready queue inside the
+    // next yield(), and are counted in the round after
+    bool busy = poll_io_() > 0 || sched->has_ready_workers();
+    scheduler_counters::add(c.busy_polls, 1);
+    if (!busy) scheduler_counters::add(c.busy_polls_empty, 1);
+    // never sleeps: with nothing else ready, the scheduler hands the thread
+    // straight back after expiring due timers
+    boost::this_fiber::yield();
+  }
+}
+
 void service::init_workers()
 {
   // Get thread multiplier from environment variable, default to 5
@@ -206,27 +569,63 @@ void service::init_workers()
   }
 
   int pool_size = std::thread::hardware_concurrency() * multiplier;
-  std::atomic_store(
-      &tasks,
-      std::make_shared<fibers::buffered_channel<std::function<void()>>>(1024));
-  is_workers_initiated(true);
 
-  for (std::size_t i = 0; i < (size_t)pool_size; ++i) {
-    std::thread th([]() {
-      std::function<void()> tsk;
-      auto safe_tasks = std::atomic_load(&tasks);
-      while (boost::fibers::channel_op_status::closed != safe_tasks->pop(tsk)) {
-        async_queue_size--;
-        fiber fb([tsk_in = std::move(tsk)]() {
-          async_task_started++;
-          tsk_in();
-          async_task_terminated++;
-        });
+  if (async_scheduling_ == async_scheduling::work_stealing) {
+    auto group = std::make_shared<work_stealing_group>(pool_size);
+    std::atomic_store(&ws_group, group);
+    is_workers_initiated(true);
 
-        fb.detach();
-      };
-    });
-    th.detach();
-  };
+    for (std::size_t i = 0; i < (size_t)pool_size; ++i) {
+      std::thread th([group, i]() {
+        // not inherited from a pinned service thread that started the pool
+        internal::place_offload_thread({});
+        fibers::use_scheduling_algorithm<asyik_work_stealing>(group, i);
+        work_stealing_group::task_type tsk;
+        auto& counters = async_counters();
+        while (group->pop(i, tsk)) {
+          counters.queued(-1);
+          // launched into this worker's ready queue, from where an idle peer
+          // may still steal it before it starts
+          fiber fb([tsk_in = std::move(tsk), &counters]() mutable {
+            auto t0 = std::chrono::steady_clock::now();
+            counters.started();
+            tsk_in();
+            counters.terminated(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0)
+                    .count());
+          });
+
+          fb.detach();
+        }
+      });
+      th.detach();
+    }
+    return;
+  }
+
+  // elastic: keep one thread per core warm, grow up to the configured size
+  // while tasks are queued with no idle thread to take them
+  offload_pool_config cfg;
+  cfg.min_threads = std::thread::hardware_concurrency();
+  cfg.max_threads = pool_size;
+  cfg.max_queue = 1024;
+  auto pool = make_offload_pool("async", cfg);
+  // like the detached workers, the default pool lives until the process
+  // exits: shutting it down from static destructors would run into fiber
+  // schedulers that are already gone
+  new offload_pool_ptr(pool);
+  std::atomic_store(&default_pool, std::move(pool));
+  is_workers_initiated(true);
+}
+
+void service::submit_async(internal::small_task&& t)
+{
+  if (auto group = std::atomic_load(&ws_group)) {
+    async_counters().queued(1);
+    group->submit(std::move(t));
+  } else {
+    std::atomic_load(&default_pool)->submit(std::move(t));
+  }
 }
 }  // namespace asyik
@@ -0,0 +1,242 @@
+#include "libasyik/service_group.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+#include "aixlog.hpp"
+#include "libasyik/internal/cpu_affinity.hpp"
+
+namespace asyik {
+namespace internal {
+
+namespace {
+std::mutex reserved_mtx;
+std::vector<int> reserved_claims;  // per CPU, guarded by reserved_mtx
+std::atomic<uint64_t> reserved_gen{0};
+}  // namespace
+
+std::vector<int> usable_cpus()
+{
+  std::vector<int> cpus;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(getpid(), sizeof(set), &set) == 0) {
+    for (int c = 0; c < CPU_SETSIZE; ++c)
+      if (CPU_ISSET(c, &set)) cpus.push_back(c);
+  }
+  if (cpus.empty()) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int c = 0; c < n; ++c) cpus.push_back(c);
+  }
+  return cpus;
+}
+
+std::vector<int> numa_node_cpus(int node)
+{
+  // cpulist reads like "0-3,8-11"
+  std::vector<int> cpus;
+  std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) +
+                  "/cpulist");
+  std::string range;
+  while (std::getline(f, range, ',')) {
+    int lo, hi;
+    int n = std::sscanf(range.c_str(), "%d-%d", &lo, &hi);
+    if (n < 1) continue;
+    if (n == 1) hi = lo;
+    for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+  }
+  return cpus;
+}
+
+bool pin_thread(const std::vector<int>& cpus)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int c : cpus)
+    if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void reserve_cpus(const std::vector<int>& cpus)
+{
+  std::lock_guard<std::mutex> lk(reserved_mtx);
+  for (int c : cpus) {
+    if (c < 0) continue;
+    if (reserved_claims.size() <= std::size_t(c))
+      reserved_claims.resize(c + 1);
+    reserved_claims[c]++;
+  }
+  reserved_gen.fetch_add(1, std::memory_order_release);
+}
+
+void release_cpus(const std::vector<int>& cpus)
+{
+  std::lock_guard<std::mutex> lk(reserved_mtx);
+  for (int c : cpus)
+    if (c >= 0 && std::size_t(c) < reserved_claims.size() &&
+        reserved_claims[c] > 0)
+      reserved_claims[c]--;
+  reserved_gen.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t reserved_cpus_generation()
+{
+  return reserved_gen.load(std::memory_order_acquire);
+}
+
+void place_offload_thread(const std::vector<int>& cpus)
+{
+  // a thread inherits the affinity of its creator, which may well be a
+  // pinned service thread, so always set it explicitly
+  std::vector<int> target = cpus;
+  if (target.empty()) {
+    auto all = usable_cpus();
+    {
+      std::lock_guard<std::mutex> lk(reserved_mtx);
+      for (int c : all)
+        if (std::size_t(c) >= reserved_claims.size() || !reserved_claims[c])
+          target.push_back(c);
+    }
+    if (target.empty()) target = std::move(all);
+  }
+  if (!pin_thread(target))
+    LOG(WARNING) << "cannot set the CPU affinity of an offload thread: "
+                 << std::strerror(errno) << "\n";
+}
+
+}  // namespace internal
+
+service_group::service_group(private_, const service_group_config& cfg)
+    : cfg_(cfg)
+{
+  std::vector<int> cpus = cfg_.cpus;
+  if (cpus.empty() && !cfg_.numa_nodes.empty()) {
+    auto usable = internal::usable_cpus();
+    for (int node : cfg_.numa_nodes)
+      for (int c : internal::numa_node_cpus(node))
+        if (std::find(usable.begin(), usable.end(), c) != usable.end())
+          cpus.push_back(c);
+    if (cpus.empty())
+      LOG(WARNING) << "service_group: no usable CPU on the given NUMA "
+                      "node(s), using all CPUs\n";
+  }
+  if (cpus.empty()) cpus = internal::usable_cpus();
+
+  std::size_t n = cfg_.services ? cfg_.services : cpus.size();
+  for (std::size_t i = 0; i < n; ++i)
+    cpus_.push_back(cfg_.pin ? cpus[i % cpus.size()] : -1);
+  services_.resize(n);
+}
+
+service_group::~service_group()
+{
+  stop();
+  join();
+}
+
+service_group_ptr make_service_group(const service_group_config& cfg)
+{
+  return std::make_shared<service_group>(service_group::private_{}, cfg);
+}
+
+service_ptr service_group::get_service(std::size_t index) const
+{
+  return services_.at(index);
+}
+
+void service_group::start(init_type init)
+{
+  BOOST_ASSERT_MSG(!started_, "service_group can only be started once");
+  started_ = true;
+
+  if (cfg_.pin && cfg_.reserve_cpus) {
+    internal::reserve_cpus(cpus_);
+    reserved_ = true;
+  }
+
+  // outlives start(): threads may still be leaving the barrier
+  struct barrier {
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::size_t ready = 0;
+    bool go = false;
+    std::exception_ptr error;
+  };
+  auto b = std::make_shared<barrier>();
+
+  for (std::size_t i = 0; i < cpus_.size(); ++i) {
+    threads_.emplace_back([this, i, init, b]() {
+      std::string tname = "asyik:svc-" + std::to_string(i);
+      pthread_setname_np(pthread_self(), tname.substr(0, 15).c_str());
+      if (cpus_[i] >= 0 && !internal::pin_thread({cpus_[i]}))
+        LOG(WARNING) << "service_group: cannot pin service " << i
+                     << " to CPU " << cpus_[i] << ": "
+                     << std::strerror(errno) << "\n";
+
+      service_ptr as;
+      std::exception_ptr error;
+      try {
+        as = make_service(cfg_.fiber_stacks);
+        as->set_run_mode(cfg_.run_mode);
+        if (init) init(as, i);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      bool run;
+      {
+        std::unique_lock<std::mutex> lk(b->mtx);
+        services_[i] = as;
+        if (error && !b->error) b->error = error;
+        if (++b->ready == cpus_.size()) b->cond.notify_all();
+        b->cond.wait(lk, [&b]() { return b->go; });
+        run = !b->error;
+      }
+      if (run) as->run();
+    });
+  }
+
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lk(b->mtx);
+    b->cond.wait(lk, [&]() { return b->ready == cpus_.size(); });
+    b->go = true;
+    error = b->error;
+  }
+  b->cond.notify_all();
+
+  if (error) {
+    join();
+    std::rethrow_exception(error);
+  }
+}
+
+void service_group::stop()
+{
+  for (auto& as : services_)
+    if (as) as->stop();
+}
+
+void service_group::join()
+{
+  for (auto& th : threads_)
+    if (th.joinable()) th.join();
+  if (reserved_) {
+    internal::release_cpus(cpus_);
+    reserved_ = false;
+  }
+}
+
+}  // namespace asyik
@@ -30,23 +30,27 @@ sql_session_ptr sql_pool::get_session(service_ptr as)
   }
   session->pool = shared_from_this();
   session->service = as;
+  session->offload = offload_pool_;
 
   return session;
 }
 
 void sql_session::begin()
 {
-  service->async([ses = soci_session.get()]() { ses->begin(); }).get();
+  service->async(offload, [ses = soci_session.get()]() { ses->begin(); })
+      .get();
 }
 
 void sql_session::commit()
 {
-  service->async([ses = soci_session.get()]() { ses->commit(); }).get();
+  service->async(offload, [ses = soci_session.get()]() { ses->commit(); })
+      .get();
 }
 
 void sql_session::rollback()
 {
-  service->async([ses = soci_session.get()]() { ses->rollback(); }).get();
+  service->async(offload, [ses = soci_session.get()]() { ses->rollback(); })
+      .get();
 }
 
 void sql_session::listen(const std::string& channel, notify_handler_t handler)
@@ -59,7 +63,7 @@ void sql_session::listen(const std::string& channel, notify_handler_t handler)
 
   // issue LISTEN command on the DB connection
   service
-      ->async([ses = soci_session.get(), channel]() {
+      ->async(offload, [ses = soci_session.get(), channel]() {
         try {
           *ses << (std::string("LISTEN ") + channel + ";");
         } catch (...) {
@@ -176,7 +180,7 @@ void sql_session::unlisten(const std::string& channel)
 
   // issue UNLISTEN
   service
-      ->async([ses = soci_session.get(), channel]() {
+      ->async(offload, [ses = soci_session.get(), channel]() {
         try {
           *ses << (std::string("UNLISTEN ") + channel + ";");
         } catch (...) {
@@ -196,7 +200,7 @@ void sql_session::unlisten_all()
 
   // issue UNLISTEN *
   service
-      ->async([ses = soci_session.get()]() {
+      ->async(offload, [ses = soci_session.get()]() {
         try {
           *ses << std::string("UNLISTEN *;");
         } catch (...) {
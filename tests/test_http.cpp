@@ -1,3 +1,7 @@
+#include <cstring>
+#include <regex>
+#include <sstream>
+
 #include "catch2/catch.hpp"
 #include "libasyik/http.hpp"
 #include "libasyik/route_table.hpp"
@@ -1742,6 +1746,755 @@ TEST_CASE("Test HTTP keep-alive and connection-close behavior",
   as->run();
 }
 
+TEST_CASE("Test HTTP/1.1 pipelining", "[http][keepalive][pipelining]")
+{
+  namespace http = boost::beast::http;
+  namespace net = boost::asio;
+  using tcp = net::ip::tcp;
+  using namespace keepalive_helpers;
+
+  auto as = asyik::make_service();
+  // Port 4016 – not used by any other test case in this file.
+  auto server = asyik::make_http_server(as, "127.0.0.1", 4016);
+
+  std::atomic<int> n_handled{0};
+  server->on_http_request(
+      "/seq/<int>", "GET",
+      [&n_handled](http_request_ptr req, const http_route_args& args) {
+        n_handled.fetch_add(1, std::memory_order_relaxed);
+        req->response.body = "seq=" + std::string(args[1]);
+        req->response.result(200);
+      });
+  server->on_http_request("/echo", "POST",
+                          [](http_request_ptr req, const http_route_args&) {
+                            req->response.body = req->body;
+                            req->response.result(200);
+                          });
+
+  asyik::sleep_for(std::chrono::milliseconds(100));
+
+  // N requests serialized back to back, the last one optionally asking the
+  // server to close
+  auto pipeline = [](int n, bool close_last) {
+    std::string out;
+    for (int i = 0; i < n; i++) {
+      if (i % 3 == 2) {
+        http::request<http::string_body> req{http::verb::post, "/echo", 11};
+        req.set(http::field::host, "127.0.0.1");
+        req.body() = "seq=" + std::to_string(i);
+        if (close_last && i == n - 1)
+          req.set(http::field::connection, "close");
+        req.prepare_payload();
+        std::ostringstream os;
+        os << req;
+        out += os.str();
+      } else {
+        out += "GET /seq/" + std::to_string(i) +
+               " HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+        if (close_last && i == n - 1) out += "Connection: close\r\n";
+        out += "\r\n";
+      }
+    }
+    return out;
+  };
+
+  as->execute([&]() {
+    // ------------------------------------------------------------------ //
+    // 1.  Many requests in one write: every one is answered, in order.     //
+    // ------------------------------------------------------------------ //
+    {
+      const int N = 30;
+      std::vector<std::string> bodies;
+      auto ex = run_bg([&] {
+        net::io_context ioc;
+        auto sock = connect_raw(ioc, "127.0.0.1", 4016);
+        net::write(sock, net::buffer(pipeline(N, false)));
+
+        boost::beast::flat_buffer buf;
+        for (int i = 0; i < N; i++) {
+          http::response<http::string_body> res;
+          http::read(sock, buf, res);
+          bodies.push_back(res.body());
+        }
+        boost::beast::error_code ec;
+        sock.shutdown(tcp::socket::shutdown_both, ec);
+      });
+
+      if (ex) std::rethrow_exception(ex);
+      REQUIRE(bodies.size() == N);
+      for (int i = 0; i < N; i++)
+        REQUIRE(bodies[i] == "seq=" + std::to_string(i));
+    }
+
+    // ------------------------------------------------------------------ //
+    // 2.  Requests split across writes, and a pipeline ending in           //
+    //     Connection: close, after which the server closes.                //
+    // ------------------------------------------------------------------ //
+    {
+      const int N = 7;
+      std::vector<std::string> bodies;
+      bool server_closed = false;
+      auto ex = run_bg([&] {
+        net::io_context ioc;
+        auto sock = connect_raw(ioc, "127.0.0.1", 4016);
+        auto all = pipeline(N, true);
+        // cut mid-request, so the server must flush what it already
+        // answered before waiting for the rest
+        auto cut = all.size() / 2 + 3;
+        net::write(sock, net::buffer(all.substr(0, cut)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        net::write(sock, net::buffer(all.substr(cut)));
+
+        boost::beast::flat_buffer buf;
+        for (int i = 0; i < N; i++) {
+          http::response<http::string_body> res;
+          http::read(sock, buf, res);
+          bodies.push_back(res.body());
+        }
+        boost::beast::error_code ec;
+        http::response<http::string_body> res;
+        http::read(sock, buf, res, ec);
+        server_closed = (ec == http::error::end_of_stream ||
+                         ec == boost::asio::error::eof ||
+                         ec == boost::asio::error::connection_reset);
+      });
+
+      if (ex) std::rethrow_exception(ex);
+      REQUIRE(bodies.size() == N);
+      for (int i = 0; i < N; i++)
+        REQUIRE(bodies[i] == "seq=" + std::to_string(i));
+      REQUIRE(server_closed);
+    }
+
+    server->close();
+    as->stop();
+  });
+
+  as->run();
+}
+
+TEST_CASE("Test SIMD parser engine", "[http][parser_engine]")
+{
+  namespace http = boost::beast::http;
+  namespace net = boost::asio;
+  using tcp = net::ip::tcp;
+  using namespace keepalive_helpers;
+
+  auto as = asyik::make_service();
+  // Port 4017 – not used by any other test case in this file.
+  auto server = asyik::make_http_server(as, "127.0.0.1", 4017);
+  REQUIRE(server->get_parser_engine() == asyik::http_parser_engine::beast);
+  server->set_parser_engine(asyik::http_parser_engine::simd);
+  server->set_request_header_limit(2048);
+  server->set_request_body_limit(256 * 1024);
+
+  server->on_http_request(
+      "/echo", [](http_request_ptr req, const http_route_args&) {
+        req->response.body = std::string(req->beast_request.method_string()) +
+                             " " + std::string(req->target()) + " " +
+                             std::to_string(req->beast_request.version()) +
+                             " " + std::string(req->headers["x-token"]) +
+                             " " + std::to_string(req->body.size());
+        req->response.headers.set("x-body-ok",
+                                  req->body == std::string(req->body.size(),
+                                                           'b')
+                                      ? "yes"
+                                      : "no");
+        req->response.result(200);
+      });
+
+  asyik::sleep_for(std::chrono::milliseconds(100));
+
+  auto exchange = [](const std::string& raw, int responses) {
+    std::vector<http::response<http::string_body>> out;
+    auto ex = run_bg([&] {
+      net::io_context ioc;
+      auto sock = connect_raw(ioc, "127.0.0.1", 4017);
+      // two writes, to split the head across reads
+      net::write(sock, net::buffer(raw.substr(0, raw.size() / 2)));
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      net::write(sock, net::buffer(raw.substr(raw.size() / 2)));
+
+      boost::beast::flat_buffer buf;
+      for (int i = 0; i < responses; i++) {
+        http::response<http::string_body> res;
+        boost::beast::error_code ec;
+        http::read(sock, buf, res, ec);
+        if (ec) break;
+        out.push_back(std::move(res));
+      }
+    });
+    if (ex) std::rethrow_exception(ex);
+    return out;
+  };
+
+  as->execute([&]() {
+    // request line and headers, with OWS around the value
+    {
+      auto res = exchange(
+          "GET /echo?q=" + std::string(100, 'q') +
+              " HTTP/1.1\r\nHost: 127.0.0.1\r\nX-Token: \t abc def \r\n"
+              "Connection: close\r\n\r\n",
+          1);
+      REQUIRE(res.size() == 1);
+      REQUIRE(res[0].body() ==
+              "GET /echo?q=" + std::string(100, 'q') + " 11 abc def 0");
+    }
+
+    // Content-Length body arriving over many reads, HTTP/1.0
+    {
+      std::string body(200 * 1024, 'b');
+      auto res = exchange("POST /echo HTTP/1.0\r\nX-Token: big\r\n"
+                          "Content-Length: " +
+                              std::to_string(body.size()) + "\r\n\r\n" + body,
+                          1);
+      REQUIRE(res.size() == 1);
+      REQUIRE(res[0].body() == "POST /echo 10 big 204800");
+      REQUIRE(res[0]["x-body-ok"] == "yes");
+    }
+
+    // pipelined, with a chunked request in the middle that goes to beast
+    {
+      std::string raw;
+      for (int i = 0; i < 3; i++)
+        raw += "GET /echo HTTP/1.1\r\nX-Token: t" + std::to_string(i) +
+               "\r\n\r\n";
+      raw +=
+          "POST /echo HTTP/1.1\r\nX-Token: chunked\r\nTransfer-Encoding: "
+          "chunked\r\n\r\n3\r\nbbb\r\n2\r\nbb\r\n0\r\n\r\n";
+      raw += "POST /echo HTTP/1.1\r\nX-Token: last\r\nContent-Length: 3\r\n"
+             "Connection: close\r\n\r\nbbb";
+      auto res = exchange(raw, 5);
+      REQUIRE(res.size() == 5);
+      for (int i = 0; i < 3; i++)
+        REQUIRE(res[i].body() == "GET /echo 11 t" + std::to_string(i) + " 0");
+      REQUIRE(res[3].body() == "POST /echo 11 chunked 5");
+      REQUIRE(res[4].body() == "POST /echo 11 last 3");
+    }
+
+    // limits still answer 413
+    {
+      auto res = exchange("GET /echo HTTP/1.1\r\nX-Token: " +
+                              std::string(4096, 'h') + "\r\n\r\n",
+                          1);
+      REQUIRE(res.size() == 1);
+      REQUIRE(res[0].result_int() == 413);
+
+      res = exchange(
+          "POST /echo HTTP/1.1\r\nContent-Length: 1000000\r\n\r\nbbb", 1);
+      REQUIRE(res.size() == 1);
+      REQUIRE(res[0].result_int() == 413);
+    }
+
+    // malformed heads are left to beast, which drops the connection
+    {
+      auto res = exchange("GET /echo HTTP/1.1\r\nBad Name: x\r\n\r\n", 1);
+      REQUIRE(res.empty());
+    }
+
+    server->close();
+    as->stop();
+  });
+
+  as->run();
+}
+
+TEST_CASE("Test request view handlers", "[http][request_view]")
+{
+  namespace http = boost::beast::http;
+  namespace net = boost::asio;
+  using tcp = net::ip::tcp;
+  using namespace keepalive_helpers;
+
+  auto as = asyik::make_service();
+  // Port 4018 – not used by any other test case in this file.
+  auto server = asyik::make_http_server(as, "127.0.0.1", 4018);
+  server->set_parser_engine(asyik::http_parser_engine::simd);
+
+  server->on_http_request_view(
+      "/v/<int>/<string>", "GET",
+      [](http_request_view& req, const http_route_view_args& args) {
+        REQUIRE(args.size() == 4);
+        req.response.body = std::string(args[1]) + "," +
+                            std::string(args[2]) + "," +
+                            std::string(args[3]) + "," +
+                            std::string(req["X-Token"]) + "," +
+                            std::string(req.method()) + "," +
+                            (req.keep_alive() ? "keep" : "close");
+        req.response.result(200);
+      });
+  server->on_http_request_view(
+      "/v/echo", "POST",
+      [](http_request_view& req, const http_route_view_args& args) {
+        REQUIRE(args.size() == 1);
+        REQUIRE(args[0] == "/v/echo");
+        int headers = 0;
+        req.for_each_header([&headers](string_view, string_view) {
+          ++headers;
+        });
+        req.response.body = std::string(req.body());
+        req.response.headers.set("x-headers", std::to_string(headers));
+        req.response.result(200);
+      });
+  // view routes come first, regular ones still serve the rest
+  server->on_http_request_view(
+      "/both", [](http_request_view& req, const http_route_view_args&) {
+        req.response.body = "view";
+        req.response.result(200);
+      });
+  server->on_http_request("/both",
+                          [](http_request_ptr req, const http_route_args&) {
+                            req->response.body = "regular";
+                            req->response.result(200);
+                          });
+  server->on_http_request("/r/<int>",
+                          [](http_request_ptr req, const http_route_args& a) {
+                            req->response.body = "r" + a[1];
+                            req->response.result(200);
+                          });
+
+  asyik::sleep_for(std::chrono::milliseconds(100));
+
+  // all requests pipelined on one connection; the 404 closes it
+  auto run = [&]() {
+    std::vector<std::string> bodies;
+    auto ex = run_bg([&] {
+      net::io_context ioc;
+      auto sock = connect_raw(ioc, "127.0.0.1", 4018);
+      std::string raw =
+          "GET /v/12/abc?q=1 HTTP/1.1\r\nx-token: tok\r\n\r\n"
+          "POST /v/echo HTTP/1.1\r\nA: 1\r\nB: 2\r\nContent-Length: 5\r\n\r\n"
+          "hello"
+          "POST /v/echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+          "3\r\nabc\r\n0\r\n\r\n"
+          "GET /both HTTP/1.1\r\n\r\n"
+          "GET /r/7 HTTP/1.1\r\n\r\n"
+          "GET /v/x/abc HTTP/1.1\r\n\r\n";
+      auto reply = [&](int n) {
+        boost::beast::flat_buffer buf;
+        for (int i = 0; i < n; i++) {
+          http::response<http::string_body> res;
+          http::read(sock, buf, res);
+          bodies.push_back(std::to_string(res.result_int()) + " " +
+                           res.body() + " " +
+                           std::string(res["x-headers"]));
+        }
+      };
+      net::write(sock, net::buffer(raw));
+      reply(6);
+    });
+    if (ex) std::rethrow_exception(ex);
+    return bodies;
+  };
+
+  as->execute([&]() {
+    for (auto engine : {asyik::http_parser_engine::simd,
+                        asyik::http_parser_engine::beast}) {
+      server->set_parser_engine(engine);
+      auto bodies = run();
+      REQUIRE(bodies.size() == 6);
+      REQUIRE(bodies[0] == "200 12,abc,?q=1,tok,GET,keep ");
+      REQUIRE(bodies[1] == "200 hello 3");
+      // chunked: parsed by beast, which joins the chunks
+      REQUIRE(bodies[2] == "200 abc 1");
+      REQUIRE(bodies[3] == "200 view ");
+      REQUIRE(bodies[4] == "200 r7 ");
+      REQUIRE(bodies[5] == "404  ");
+    }
+
+    server->close();
+    as->stop();
+  });
+
+  as->run();
+}
+
+TEST_CASE("request_arena allocates, spills and rewinds", "[request_arena]")
+{
+  using asyik::request_arena;
+
+  request_arena arena;
+  auto* a = static_cast<char*>(arena.allocate(3, 1));
+  auto* b = static_cast<char*>(arena.allocate(8, 8));
+  REQUIRE(reinterpret_cast<std::uintptr_t>(b) % 8 == 0);
+  REQUIRE(b > a);
+
+  // more than the inline block: spills to the heap, and reset() merges it
+  std::vector<char*> spilled;
+  for (int i = 0; i < 16; i++) {
+    spilled.push_back(static_cast<char*>(arena.allocate(1024, 16)));
+    std::memset(spilled.back(), i, 1024);
+  }
+  for (int i = 0; i < 16; i++) REQUIRE(spilled[i][1023] == i);
+  arena.reset();
+  auto* first = static_cast<char*>(arena.allocate(16 * 1024, 16));
+  arena.reset();
+  REQUIRE(arena.allocate(16 * 1024, 16) == first);
+
+  // header fields: move construction keeps the arena, copies go to the heap
+  http_fields::allocator_type alloc(&arena);
+  http_beast_response res{std::piecewise_construct, std::make_tuple(),
+                          std::make_tuple(alloc)};
+  res.set("x-test", "value");
+  REQUIRE(res.get_allocator().arena() == &arena);
+  http_beast_response copy = res;
+  REQUIRE(copy.get_allocator().arena() == nullptr);
+  REQUIRE(copy["x-test"] == "value");
+  http_beast_response moved = std::move(res);
+  REQUIRE(moved.get_allocator().arena() == &arena);
+  REQUIRE(moved["x-test"] == "value");
+
+  // moving into a message on the heap copies the fields out of the arena
+  http_beast_response kept;
+  kept = std::move(moved);
+  REQUIRE(kept.get_allocator().arena() == nullptr);
+  REQUIRE(kept["x-test"] == "value");
+
+  // and the other way around the arena stays
+  http_beast_response target{std::piecewise_construct, std::make_tuple(),
+                             std::make_tuple(alloc)};
+  target = std::move(copy);
+  REQUIRE(target.get_allocator().arena() == &arena);
+  REQUIRE(target["x-test"] == "value");
+
+  // a plain message stays on the heap
+  http_beast_request req;
+  REQUIRE(req.get_allocator().arena() == nullptr);
+}
+
+TEST_CASE("Test request arena across keep-alive requests",
+          "[http][request_arena]")
+{
+  namespace http = boost::beast::http;
+  namespace net = boost::asio;
+  using tcp = net::ip::tcp;
+  using namespace keepalive_helpers;
+
+  auto as = asyik::make_service();
+  // Port 4019 – not used by any other test case in this file.
+  auto server = asyik::make_http_server(as, "127.0.0.1", 4019);
+
+  int n = 0;
+  server->on_http_request(
+      "/arena", [&n](http_request_ptr req, const http_route_args&) {
+        // only the first response carries x-first
+        if (n++ == 0) req->response.headers.set("x-first", "1");
+        auto cookie = req->headers["cookie"];
+        req->response.headers.set("x-cookie-size",
+                                  std::to_string(cookie.size()));
+        req->response.body = std::string(req->headers["x-id"]);
+        req->response.result(200);
+      });
+
+  asyik::sleep_for(std::chrono::milliseconds(100));
+
+  as->execute([&]() {
+    for (auto engine : {asyik::http_parser_engine::beast,
+                        asyik::http_parser_engine::simd}) {
+      server->set_parser_engine(engine);
+      n = 0;
+      std::vector<http::response<http::string_body>> out;
+      auto ex = run_bg([&] {
+        net::io_context ioc;
+        auto sock = connect_raw(ioc, "127.0.0.1", 4019);
+        // the big cookie does not fit the inline arena block
+        for (auto cookie : {std::string(), std::string(16 * 1024, 'c'),
+                            std::string(), std::string(100, 'd')}) {
+          http::request<http::string_body> req{http::verb::get, "/arena", 11};
+          req.set("x-id", std::to_string(out.size()));
+          if (cookie.size()) req.set(http::field::cookie, cookie);
+          http::write(sock, req);
+          boost::beast::flat_buffer buf;
+          http::response<http::string_body> res;
+          http::read(sock, buf, res);
+          out.push_back(std::move(res));
+        }
+      });
+      if (ex) std::rethrow_exception(ex);
+
+      REQUIRE(out.size() == 4);
+      const char* cookies[] = {"0", "16384", "0", "100"};
+      for (std::size_t i = 0; i < out.size(); i++) {
+        REQUIRE(out[i].result_int() == 200);
+        REQUIRE(out[i].body() == std::to_string(i));
+        REQUIRE(out[i]["x-cookie-size"] == cookies[i]);
+        REQUIRE(out[i].count("x-first") == (i == 0));
+        REQUIRE(out[i][http::field::server] == LIBASYIK_VERSION_STRING);
+      }
+    }
+
+    server->close();
+    as->stop();
+  });
+
+  as->run();
+}
+
+TEST_CASE("Test response templates", "[http][response_template]")
+{
+  namespace http = boost::beast::http;
+  namespace net = boost::asio;
+  using tcp = net::ip::tcp;
+  using namespace keepalive_helpers;
+
+  REQUIRE_THROWS_AS(
+      asyik::http_response_template(200, {{"Content-Length", "2"}}, "OK"),
+      asyik::invalid_input_error);
+
+  auto as = asyik::make_service();
+  // Port 4020 – not used by any other test case in this file.
+  auto server = asyik::make_http_server(as, "127.0.0.1", 4020);
+
+  server->on_http_request_template(
+      "/health", "GET",
+      asyik::http_response_template(200, {{"Content-Type", "text/plain"}},
+                                    "OK"));
+  server->on_http_request_template(
+      "/hello/<string>", "GET",
+      asyik::http_response_template(
+          201, {{"Content-Type", "text/plain"}, {"X-A", "1"}}),
+      [](http_request_view& req, const http_route_view_args& args) {
+        if (args[1] == "big")
+          req.response.body = std::string(100000, 'x');
+        else if (args[1] != "empty")
+          req.response.body = "hello " + std::string(args[1]);
+      });
+  server->on_http_request("/regular",
+                          [](http_request_ptr req, const http_route_args&) {
+                            req->response.body = "regular";
+                            req->response.result(200);
+                          });
+
+  asyik::sleep_for(std::chrono::milliseconds(100));
+
+  const std::regex date_re(
+      R"(^(Mon|Tue|Wed|Thu|Fri|Sat|Sun), \d\d )"
+      R"((Jan|Feb|Mar|Apr|May|Jun|Jul|Aug|Sep|Oct|Nov|Dec) \d{4} )"
+      R"(\d\d:\d\d:\d\d GMT$)");
+  auto date_ok = [&date_re](string_view d) {
+    return std::regex_match(std::string(d), date_re);
+  };
+
+  // sends @p raw at once and reads @p n responses, then whether the server
+  // closed the connection
+  auto exchange = [](const std::string& raw, int n, bool& closed) {
+    std::vector<http::response<http::string_body>> out;
+    auto ex = run_bg([&] {
+      net::io_context ioc;
+      auto sock = connect_raw(ioc, "127.0.0.1", 4020);
+      net::write(sock, net::buffer(raw));
+      boost::beast::flat_buffer buf;
+      for (int i = 0; i < n; i++) {
+        http::response_parser<http::string_body> parser;
+        parser.body_limit(1024 * 1024);
+        http::read(sock, buf, parser);
+        out.push_back(parser.release());
+      }
+      boost::system::error_code ec;
+      char c;
+      sock.read_some(net::buffer(&c, 1), ec);
+      closed = ec == net::error::eof;
+    });
+    if (ex) std::rethrow_exception(ex);
+    return out;
+  };
+
+  as->execute([&]() {
+    REQUIRE(date_ok(as->http_date()));
+
+    for (auto engine : {asyik::http_parser_engine::beast,
+                        asyik::http_parser_engine::simd}) {
+      server->set_parser_engine(engine);
+      bool closed = false;
+
+      // keep-alive and pipelined: the prebuilt bytes
+      auto out = exchange(
+          "GET /health HTTP/1.1\r\n\r\n"
+          "GET /hello/bob HTTP/1.1\r\n\r\n"
+          "GET /hello/big HTTP/1.1\r\n\r\n"
+          "GET /hello/empty HTTP/1.1\r\n\r\n"
+          "GET /regular HTTP/1.1\r\n\r\n"
+          "GET /health HTTP/1.1\r\nConnection: close\r\n\r\n",
+          6, closed);
+      REQUIRE(closed);
+      REQUIRE(out[0].result_int() == 200);
+      REQUIRE(out[0].body() == "OK");
+      REQUIRE(out[0][http::field::content_type] == "text/plain");
+      REQUIRE(out[0][http::field::content_length] == "2");
+      REQUIRE(out[0][http::field::server] == LIBASYIK_VERSION_STRING);
+      REQUIRE(date_ok(out[0][http::field::date]));
+      REQUIRE(out[1].result_int() == 201);
+      REQUIRE(out[1].body() == "hello bob");
+      REQUIRE(out[1]["x-a"] == "1");
+      REQUIRE(date_ok(out[1][http::field::date]));
+      REQUIRE(out[2].body() == std::string(100000, 'x'));
+      REQUIRE(out[3].body() == "");
+      REQUIRE(out[3][http::field::content_length] == "0");
+      REQUIRE(out[4].body() == "regular");
+      REQUIRE(date_ok(out[4][http::field::date]));
+      // closing: built as a beast response instead
+      REQUIRE(out[5].body() == "OK");
+      REQUIRE(out[5][http::field::content_type] == "text/plain");
+      REQUIRE(out[5][http::field::connection] == "close");
+      REQUIRE(date_ok(out[5][http::field::date]));
+
+      // HTTP/1.0, with a handler
+      out = exchange("GET /hello/ann HTTP/1.0\r\n\r\n", 1, closed);
+      REQUIRE(closed);
+      REQUIRE(out[0].result_int() == 201);
+      REQUIRE(out[0].body() == "hello ann");
+      REQUIRE(out[0]["x-a"] == "1");
+    }
+
+    server->close();
+    as->stop();
+  });
+
+  as->run();
+}
+
+TEST_CASE("Test watchdog labels handlers with their route", "[http]")
+{
+  namespace http = boost::beast::http;
+  namespace net = boost::asio;
+  using namespace keepalive_helpers;
+
+  auto as = asyik::make_service();
+  std::vector<std::string> labels;
+  as->set_watchdog(std::chrono::milliseconds(5),
+                   [&labels](const asyik::slow_slice& s) {
+                     labels.emplace_back(s.label.data(), s.label.size());
+                   });
+  // Port 4021 – not used by any other test case in this file.
+  auto server = asyik::make_http_server(as, "127.0.0.1", 4021);
+
+  auto spin = []() {
+    auto until =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+    while (std::chrono::steady_clock::now() < until) {
+    }
+  };
+  server->on_http_request("/slow/<int>", "GET",
+                          [spin](http_request_ptr req, const http_route_args&) {
+                            spin();
+                            req->response.result(200);
+                          });
+  server->on_http_request_view(
+      "/view/<string>", "GET",
+      [spin](http_request_view& req, const http_route_view_args&) {
+        spin();
+        req.response.result(200);
+      });
+  server->on_http_request_regex(
+      std::regex("^/rx/.*$"), "GET",
+      [spin](http_request_ptr req, const http_route_args&) {
+        spin();
+        req->response.result(200);
+      });
+
+  as->execute([&]() {
+    asyik::sleep_for(std::chrono::milliseconds(100));
+    auto ex = run_bg([] {
+      net::io_context ioc;
+      auto sock = connect_raw(ioc, "127.0.0.1", 4021);
+      net::write(sock, net::buffer(std::string(
+                           "GET /slow/7?a=1 HTTP/1.1\r\n\r\n"
+                           "GET /view/abc HTTP/1.1\r\n\r\n"
+                           "GET /rx/q HTTP/1.1\r\n\r\n")));
+      boost::beast::flat_buffer buf;
+      for (int i = 0; i < 3; i++) {
+        http::response<http::string_body> res;
+        http::read(sock, buf, res);
+      }
+    });
+    if (ex) std::rethrow_exception(ex);
+
+    server->close();
+    as->stop();
+  });
+
+  as->run();
+
+  // the spec the route was registered with, not the request target
+  auto has = [&labels](const std::string& l) {
+    return std::find(labels.begin(), labels.end(), l) != labels.end();
+  };
+  REQUIRE(has("/slow/<int>"));
+  REQUIRE(has("/view/<string>"));
+  REQUIRE(has("<regex>"));
+  REQUIRE(!has("/slow/7?a=1"));
+}
+
+TEST_CASE("Test HTTP idle timeout", "[http][keepalive]")
+{
+  namespace http = boost::beast::http;
+  namespace net = boost::asio;
+  using namespace keepalive_helpers;
+
+  auto as = asyik::make_service();
+  // Port 4022 – not used by any other test case in this file.
+  auto server = asyik::make_http_server(as, "127.0.0.1", 4022);
+  server->set_idle_timeout(std::chrono::milliseconds(200));
+  server->on_http_request("/ping", "GET",
+                          [](http_request_ptr req, const http_route_args&) {
+                            req->response.body = "pong";
+                            req->response.result(200);
+                          });
+
+  int busy_ok = 0;
+  int idle_ok = 0;
+  boost::system::error_code idle_ec;
+  std::chrono::milliseconds idle_closed_after{0};
+  as->execute([&]() {
+    asyik::sleep_for(std::chrono::milliseconds(100));
+    for (auto engine : {asyik::http_parser_engine::beast,
+                        asyik::http_parser_engine::simd}) {
+      server->set_parser_engine(engine);
+      auto ex = run_bg([&] {
+        net::io_context ioc;
+        // a client that keeps sending in time outlives the timeout
+        auto busy = connect_raw(ioc, "127.0.0.1", 4022);
+        boost::beast::flat_buffer busy_buf;
+        for (int i = 0; i < 8; i++) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(100));
+          if (one_request(busy, busy_buf, http::verb::get, "/ping", 11)
+                  .body() == "pong")
+            busy_ok++;
+        }
+
+        // one that goes quiet after its request gets disconnected
+        auto idle = connect_raw(ioc, "127.0.0.1", 4022);
+        struct timeval tv = {5, 0};  // do not hang if it never is
+        setsockopt(idle.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv,
+                   sizeof(tv));
+        boost::beast::flat_buffer idle_buf;
+        if (one_request(idle, idle_buf, http::verb::get, "/ping", 11)
+                .body() == "pong")
+          idle_ok++;
+        auto t0 = std::chrono::steady_clock::now();
+        http::response<http::string_body> res;
+        http::read(idle, idle_buf, res, idle_ec);
+        idle_closed_after =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - t0);
+      });
+      if (ex) std::rethrow_exception(ex);
+      if (idle_ec != http::error::end_of_stream) break;
+    }
+
+    server->close();
+    as->stop();
+  });
+
+  as->run();
+
+  REQUIRE(busy_ok == 16);
+  REQUIRE(idle_ok == 2);
+  REQUIRE(idle_ec == http::error::end_of_stream);
+  REQUIRE(idle_closed_after >= std::chrono::milliseconds(150));
+  REQUIRE(idle_closed_after < std::chrono::seconds(2));
+}
+
 TEST_CASE("Test http url view", "[http_url_view]")
 {
   auto as = asyik::make_service();
@@ -2075,6 +2828,15 @@ TEST_CASE("route_table tier priority: exact > prefix > fallback",
   const auto& found3 = table.find(req3, args);
   // Fallback match — came from regex_route
   REQUIRE(args[0].find("/api") != std::string::npos);
+
+  // each tier reports the spec the route was registered with
+  string_view spec;
+  table.find(req1, args, &spec);
+  REQUIRE(spec == "/api/users/42");
+  table.find(req2, args, &spec);
+  REQUIRE(spec == "/api/users/<int>");
+  table.find(req3, args, &spec);
+  REQUIRE(spec == "<regex>");
 }
 
 // ── insert_front ordering ──
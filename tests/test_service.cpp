@@ -1,12 +1,19 @@
 
+#include <sched.h>
+#include <sys/resource.h>
+
+#include <array>
 #include <boost/asio/ip/udp.hpp>
+#include <set>
 
 #include "catch2/catch.hpp"
 #include "libasyik/asyik_round_robin.hpp"
 #include "libasyik/error.hpp"
+#include "libasyik/futures.hpp"
 #include "libasyik/http.hpp"
 #include "libasyik/internal/use_fiber_future.hpp"
 #include "libasyik/service.hpp"
+#include "libasyik/service_group.hpp"
 
 namespace asyik {
 void _TEST_invoke_service(){};
@@ -154,6 +161,56 @@ TEST_CASE("Check return value from async()", "[service]")
   as->run();
 }
 
+TEST_CASE("offload() runs on the worker pool and resumes the caller",
+          "[service][offload]")
+{
+  for (auto mode : {asyik::service_run_mode::polling,
+                    asyik::service_run_mode::event_driven}) {
+    auto as = asyik::make_service();
+    as->set_run_mode(mode);
+    auto pool = asyik::make_offload_pool("offload-test");
+    std::atomic<int> done{0};
+
+    as->execute([&]() {
+      auto caller = std::this_thread::get_id();
+      std::thread::id worker;
+      asyik::service_ptr origin;
+      std::string s = asyik::offload(
+          [&worker, &origin](int i) {
+            worker = std::this_thread::get_id();
+            origin = asyik::get_current_service();
+            return std::to_string(i);
+          },
+          42);
+      REQUIRE(s == "42");
+      REQUIRE(origin == as);
+      REQUIRE(worker != caller);
+      REQUIRE(std::this_thread::get_id() == caller);
+
+      int n = 0;
+      as->offload(pool, [&n]() { n = 7; });
+      REQUIRE(n == 7);
+      auto p = as->offload([]() { return std::make_unique<int>(3); });
+      REQUIRE(*p == 3);
+      auto fail = []() -> int {
+        throw asyik::already_expired_error("expected");
+      };
+      REQUIRE_THROWS_AS(as->offload(fail), asyik::already_expired_error);
+
+      // many fibers waiting at once, woken from several worker threads
+      for (int i = 0; i < 50; i++)
+        as->execute([&, i]() {
+          for (int j = 0; j < 20; j++)
+            REQUIRE(as->offload([](int k) { return k * 2; }, i) == i * 2);
+          if (++done == 50) as->stop();
+        });
+    });
+
+    as->run();
+    REQUIRE(done == 50);
+  }
+}
+
 TEST_CASE("Test return value execute from async", "[service]")
 {
   auto as = asyik::make_service();
@@ -242,6 +299,494 @@ TEST_CASE("stop service from another thread/async", "[service]")
   as->run();
 }
 
+TEST_CASE("execute_detached() and move-only tasks", "[service]")
+{
+  auto as = asyik::make_service();
+  int sum = 0;
+
+  // arguments are copied, std::ref() passes a reference
+  as->execute_detached([](int a, int& out) { out += a; }, 40, std::ref(sum));
+  // a throwing task is logged and does not take the service down
+  as->execute_detached([]() { throw std::runtime_error("detached"); });
+
+  auto owned = std::make_unique<int>(2);
+  auto f = as->execute([p = std::move(owned)]() { return *p; });
+  as->execute_detached([&sum, &f, as]() {
+    sum += f.get();
+    as->stop();
+  });
+
+  as->run();
+  REQUIRE(sum == 42);
+}
+
+TEST_CASE("futures of different result sizes share the promise pool",
+          "[service]")
+{
+  // the small shared states recycled by the first round are handed to the
+  // bigger ones of the second; run under ASan to catch an overflow
+  using wide = std::array<uint64_t, 8>;
+  auto as = asyik::make_service();
+  as->execute([as]() {
+    for (int round = 0; round < 2; round++) {
+      std::vector<fibers::future<void>> small;
+      for (int i = 0; i < 64; i++) {
+        small.push_back(as->execute([]() {}));
+        small.push_back(as->async([]() {}));
+      }
+      for (auto& f : small) f.get();
+
+      std::vector<fibers::future<std::string>> text;
+      std::vector<fibers::future<wide>> words;
+      for (int i = 0; i < 64; i++) {
+        text.push_back(
+            as->execute([i]() { return std::string(40, 'a' + i % 26); }));
+        words.push_back(
+            as->async([i]() { return wide{{uint64_t(i), 1, 2, 3, 4, 5, 6}}; }));
+      }
+      for (int i = 0; i < 64; i++) {
+        REQUIRE(text[i].get() == std::string(40, 'a' + i % 26));
+        auto w = words[i].get();
+        REQUIRE(w[0] == uint64_t(i));
+        REQUIRE(w[6] == 6);
+      }
+    }
+    as->stop();
+  });
+
+  as->run();
+}
+
+TEST_CASE("execute() reuses parked fibers up to the fiber pool size",
+          "[service]")
+{
+  auto as = asyik::make_service();
+  as->set_fiber_pool_size(2);
+  REQUIRE(as->get_fiber_pool_size() == 2);
+
+  // fiber-specific data survives on a reused fiber, a new one starts empty
+  static fibers::fiber_specific_ptr<int> tag;
+  auto reused = []() {
+    if (tag.get()) return true;
+    tag.reset(new int(1));
+    return false;
+  };
+
+  as->execute([as, reused]() {
+    // a finished fiber parks before the waiter gets to run again
+    REQUIRE(!as->execute(reused).get());
+    REQUIRE(as->execute(reused).get());
+
+    // five concurrent tasks, only two of their fibers stay parked
+    auto batch = [as, reused]() {
+      fibers::promise<void> gate;
+      auto open = gate.get_future().share();
+      std::vector<fibers::future<bool>> fs;
+      for (int i = 0; i < 5; i++)
+        fs.push_back(as->execute([open, reused]() {
+          open.wait();
+          return reused();
+        }));
+      gate.set_value();
+      int n = 0;
+      for (auto& f : fs) n += f.get();
+      return n;
+    };
+    REQUIRE(batch() == 1);
+    REQUIRE(batch() == 2);
+    as->stop();
+  });
+  as->run();
+}
+
+TEST_CASE("pooled fiber stacks are capped, trimmed and counted", "[service]")
+{
+  asyik::stack_pool_config cfg;
+  cfg.stack_size = 64 * 1024;
+  cfg.max_free = 4;
+  cfg.trim_keep = 1;
+  asyik::pooled_guarded_stack pool(cfg);
+
+  std::vector<boost::context::stack_context> stacks;
+  for (int i = 0; i < 6; i++) stacks.push_back(pool.allocate());
+  auto st = pool.get_stats();
+  REQUIRE(st.in_use == 6);
+  REQUIRE(st.mapped == 6);
+  REQUIRE(st.free == 0);
+
+  // the owner (first allocating thread) and other threads both give back
+  for (int i = 0; i < 3; i++) pool.deallocate(stacks[i]);
+  std::thread([&]() {
+    for (int i = 3; i < 6; i++) pool.deallocate(stacks[i]);
+  }).join();
+  st = pool.get_stats();
+  REQUIRE(st.in_use == 0);
+  REQUIRE(st.free == 4);  // the two beyond max_free got unmapped
+  REQUIRE(st.mapped == 4);
+
+  pool.trim();
+  st = pool.get_stats();
+  REQUIRE(st.trimmed == 3);
+  REQUIRE(st.free == 4);
+
+  // trimmed stacks are still usable, resident ones are handed out first
+  auto a = pool.allocate();
+  static_cast<char*>(a.sp)[-1] = 1;
+  pool.deallocate(a);
+  REQUIRE(pool.get_stats().mapped == 4);
+
+  auto as = asyik::make_service();
+  as->set_fiber_stack_config(cfg);
+  as->execute([as]() {
+    REQUIRE(as->get_fiber_stack_stats().in_use >= 1);
+    as->stop();
+  });
+  as->run();
+}
+
+TEST_CASE("fiber stack usage is measured when a stack is released",
+          "[service]")
+{
+  asyik::stack_pool_config cfg;
+  cfg.stack_size = 128 * 1024;
+  cfg.measure_usage = true;
+  std::vector<std::size_t> used;  // deallocated on the service thread
+  cfg.on_usage = [&used](std::size_t u, std::size_t size) {
+    REQUIRE(size == 128 * 1024);
+    used.push_back(u);
+  };
+
+  auto as = asyik::make_service(cfg);
+  as->set_fiber_pool_size(0);
+  as->execute([as]() {
+    as->execute([]() {
+        volatile char buf[32 * 1024];
+        for (std::size_t i = 0; i < sizeof(buf); i += 512) buf[i] = 1;
+      }).get();
+    as->execute([]() {}).get();
+    as->stop();
+  });
+  as->run();
+
+  REQUIRE(used.size() >= 2);
+  REQUIRE(used[0] >= 32 * 1024);
+  REQUIRE(used[1] < 32 * 1024);  // the pattern was restored for reuse
+  REQUIRE(as->get_fiber_stack_stats().max_used == used[0]);
+  REQUIRE(asyik::make_service(64 * 1024) != nullptr);
+}
+
+TEST_CASE("service_group runs pinned services and stops them together",
+          "[service]")
+{
+  asyik::service_group_config cfg;
+  cfg.services = 3;
+  auto group = asyik::make_service_group(cfg);
+  REQUIRE(group->size() == 3);
+
+  std::atomic<int> inits{0};
+  group->start([&inits](asyik::service_ptr as, std::size_t index) {
+    REQUIRE(as);
+    REQUIRE(index < 3);
+    inits++;
+  });
+  REQUIRE(inits == 3);
+
+  std::set<std::thread::id> threads;
+  for (std::size_t i = 0; i < group->size(); i++) {
+    REQUIRE(group->get_cpu(i) >= 0);
+    auto as = group->get_service(i);
+    // each service is on its own thread, pinned to its CPU
+    auto on = as->execute([]() {
+                  cpu_set_t set;
+                  CPU_ZERO(&set);
+                  sched_getaffinity(0, sizeof(set), &set);
+                  return std::make_pair(std::this_thread::get_id(),
+                                        CPU_COUNT(&set));
+                })
+                  .get();
+    threads.insert(on.first);
+    REQUIRE(on.second == 1);
+  }
+  REQUIRE(threads.size() == 3);
+
+  group->stop();
+  group->join();
+  for (std::size_t i = 0; i < group->size(); i++)
+    REQUIRE(group->get_service(i)->is_stopped());
+
+  // a failing init keeps every service from running
+  auto failing = asyik::make_service_group(cfg);
+  REQUIRE_THROWS_AS(failing->start([](asyik::service_ptr, std::size_t index) {
+    if (index == 1) throw std::runtime_error("init failed");
+  }),
+                    std::runtime_error);
+}
+
+TEST_CASE("scheduler stats count switches, queue depth and time",
+          "[service]")
+{
+  auto as = asyik::make_service();
+  as->set_scheduler_timing(true);
+  as->execute([as]() {
+    auto busy = []() {
+      auto until = std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(5);
+      while (std::chrono::steady_clock::now() < until) {
+      }
+    };
+    auto f1 = as->execute(busy);
+    auto f2 = as->execute(busy);
+    f1.get();
+    f2.get();
+    REQUIRE(as->get_scheduler_stats().live_fibers >= 1);  // this one
+
+    asyik::sleep_for(std::chrono::milliseconds(50));  // the thread idles
+    as->stop();
+  });
+  as->run();
+
+  auto st = as->get_scheduler_stats();
+  REQUIRE(st.context_switches > 0);
+  uint64_t samples = 0;
+  for (auto n : st.ready_depth) samples += n;
+  REQUIRE(samples >= st.context_switches);
+  REQUIRE(st.ready_depth[2] > 0);  // both busy fibers were runnable at once
+  REQUIRE(st.fiber_run_ns >= 10000000);
+  REQUIRE(st.io_poll_ns > 0);
+  REQUIRE(st.suspend_ns > 0);
+  REQUIRE(st.live_fibers == 0);
+  REQUIRE(st.parked_fibers == 0);
+}
+
+TEST_CASE("execute() with a priority runs ahead of lower classes",
+          "[service]")
+{
+  auto as = asyik::make_service();
+  as->execute([as]() {
+    std::string order;
+    auto n1 = as->execute([&order]() { order += 'n'; });
+    auto l = as->execute(asyik::fiber_priority::low, [&order]() {
+      order += 'l';
+    });
+    auto n2 = as->execute([&order]() { order += 'n'; });
+    auto h = as->execute(asyik::fiber_priority::high, [&order]() {
+      order += 'h';
+      return 42;
+    });
+    n1.get();
+    l.get();
+    n2.get();
+    REQUIRE(h.get() == 42);
+    REQUIRE(order == "hnnl");
+
+    // a pooled fiber takes the class of its next task
+    order.clear();
+    auto n3 = as->execute([&order]() { order += 'n'; });
+    auto h2 = as->execute(asyik::fiber_priority::high, [&order]() {
+      order += 'h';
+    });
+    n3.get();
+    h2.get();
+    REQUIRE(order == "hn");
+    as->stop();
+  });
+  as->run();
+}
+
+TEST_CASE("a task whose fiber cannot be launched leaves no priority behind",
+          "[service]")
+{
+  auto priority_of_self = []() {
+    auto* props = static_cast<asyik::fiber_props*>(
+        boost::fibers::context::active()->get_properties());
+    return props ? props->priority : asyik::fiber_priority::normal;
+  };
+  auto as = asyik::make_service();
+  as->set_fiber_pool_size(0);
+  bool broken = false;
+  auto woken = asyik::fiber_priority::high;
+  auto launched = asyik::fiber_priority::high;
+  as->execute([&]() {
+    // no stack can be mapped at this size
+    asyik::stack_pool_config huge;
+    huge.stack_size = std::size_t(1) << 62;
+    as->set_fiber_stack_config(huge);
+    auto h = as->execute(asyik::fiber_priority::high, []() {});
+    try {
+      h.get();
+    } catch (const fibers::future_error&) {
+      broken = true;
+    }
+    woken = priority_of_self();
+
+    as->set_fiber_stack_config(asyik::stack_pool_config{});
+    launched = as->execute(priority_of_self).get();
+    as->stop();
+  });
+  as->run();
+  REQUIRE(broken);
+  REQUIRE(woken == asyik::fiber_priority::normal);
+  REQUIRE(launched == asyik::fiber_priority::normal);
+}
+
+TEST_CASE("the LIFO slot runs a just-woken fiber next", "[service][lifo]")
+{
+  for (bool lifo : {false, true}) {
+    auto as = asyik::make_service();
+    as->set_lifo_slot(lifo);
+    std::string order;
+    as->execute([&]() {
+      boost::fibers::promise<void> p;
+      auto f = p.get_future();
+      boost::fibers::fiber waiter([&f, &order]() {
+        f.get();
+        order += 'w';
+      });
+      boost::this_fiber::yield();  // the waiter blocks on f
+
+      boost::fibers::fiber a([&order]() { order += 'a'; });
+      boost::fibers::fiber b([&order]() { order += 'b'; });
+      p.set_value();
+      waiter.join();
+      a.join();
+      b.join();
+      as->stop();
+    });
+    as->run();
+    // the slot holds the last one woken; the others go back in order
+    REQUIRE(order == (lifo ? "wab" : "abw"));
+    auto stats = as->get_scheduler_stats();
+    REQUIRE((stats.lifo_handoffs > 0) == lifo);
+  }
+}
+
+TEST_CASE("the LIFO slot does not starve the ready queue", "[service][lifo]")
+{
+  auto as = asyik::make_service();
+  as->set_lifo_slot(true);
+  const int round_trips = 3000;
+  int bystander = 0;
+  as->execute([&]() {
+    // a ping-pong pair keeps handing the thread to each other through
+    // the slot, while a third fiber only ever yields
+    boost::fibers::buffered_channel<int> ping(2), pong(2);
+    bool done = false;
+    boost::fibers::fiber other([&]() {
+      while (!done) {
+        ++bystander;
+        boost::this_fiber::yield();
+      }
+    });
+    boost::fibers::fiber echo([&]() {
+      int v;
+      while (ping.pop(v) == boost::fibers::channel_op_status::success)
+        pong.push(v);
+    });
+    for (int i = 0; i < round_trips; i++) {
+      ping.push(i);
+      REQUIRE(pong.value_pop() == i);
+    }
+    done = true;
+    ping.close();
+    echo.join();
+    other.join();
+    as->stop();
+  });
+  as->run();
+
+  // every round trip hands off twice, and at most 3 handoffs run before
+  // the queue gets a turn
+  auto stats = as->get_scheduler_stats();
+  REQUIRE(stats.lifo_handoffs >= round_trips);
+  REQUIRE(stats.lifo_demotions > 0);
+  REQUIRE(bystander >= round_trips / 4);
+}
+
+TEST_CASE("watchdog reports fibers that do not yield in time", "[service]")
+{
+  auto as = asyik::make_service();
+  std::vector<std::string> labels;
+  std::chrono::nanoseconds longest{0};
+  as->set_watchdog(std::chrono::milliseconds(5),
+                   [&](const asyik::slow_slice& s) {
+                     labels.emplace_back(s.label.data(), s.label.size());
+                     longest = std::max(longest, s.duration);
+                   });
+  as->execute([as]() {
+    auto f1 = as->execute([]() {
+      asyik::fiber_label label("/busy");
+      auto until =
+          std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+      while (std::chrono::steady_clock::now() < until) {
+      }
+    });
+    auto f2 = as->execute([]() {
+      for (int i = 0; i < 10; ++i) boost::this_fiber::yield();
+    });
+    f1.get();
+    f2.get();
+    as->stop();
+  });
+  as->run();
+
+  REQUIRE(labels == std::vector<std::string>{"/busy"});
+  REQUIRE(longest >= std::chrono::milliseconds(20));
+  auto st = as->get_scheduler_stats();
+  REQUIRE(st.slow_slices == 1);
+  REQUIRE(st.slow_slice_max_ns >= 20000000);
+  REQUIRE(st.slow_slice_ns >= st.slow_slice_max_ns);
+}
+
+TEST_CASE("sleep_for and wheel_timer run on the service timer wheel",
+          "[service]")
+{
+  auto as = asyik::make_service();
+  as->set_timer_resolution(std::chrono::milliseconds(2));
+  as->execute([as]() {
+    std::string order;
+    std::vector<fibers::future<void>> sleepers;
+    for (int ms : {30, 10, 20})
+      sleepers.push_back(as->execute([&order, ms]() {
+        auto t0 = std::chrono::steady_clock::now();
+        asyik::sleep_for(std::chrono::milliseconds(ms));
+        REQUIRE(std::chrono::steady_clock::now() - t0 >=
+                std::chrono::milliseconds(ms));
+        order += char('0' + ms / 10);
+      }));
+    for (auto& f : sleepers) f.get();
+    REQUIRE(order == "123");
+
+    int fired = 0;
+    asyik::wheel_timer t1, t2;
+    REQUIRE(t1.arm(std::chrono::milliseconds(5), [&fired]() { fired += 1; }));
+    REQUIRE(t2.arm(std::chrono::milliseconds(5), [&fired]() { fired += 10; }));
+    t2.cancel();
+    REQUIRE(t1.armed());
+    asyik::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(fired == 1);
+    REQUIRE(!t1.armed());
+    as->stop();
+  });
+  as->run();
+}
+
+TEST_CASE("stopping a service wakes fibers sleeping on the timer wheel",
+          "[service]")
+{
+  auto as = asyik::make_service();
+  as->execute_detached([]() { asyik::sleep_for(std::chrono::hours(1)); });
+  as->execute_detached([as]() {
+    asyik::sleep_for(std::chrono::milliseconds(10));
+    as->stop();
+  });
+  auto t0 = std::chrono::steady_clock::now();
+  as->run();
+  // the graceful phase waits 500ms, then the sleeper is woken to unwind
+  REQUIRE(std::chrono::steady_clock::now() - t0 <
+          std::chrono::milliseconds(900));
+  REQUIRE(as->get_scheduler_stats().live_fibers == 0);
+}
+
 TEST_CASE("test proper cleanup of function object in execute()", "[service]")
 {
   auto as = asyik::make_service();
@@ -362,6 +907,531 @@ TEST_CASE(
   as->run(true);
 }
 
+TEST_CASE("execute() from many threads runs every task exactly once",
+          "[service]")
+{
+  auto as = asyik::make_service();
+  const int producers = 4;
+  const int tasks = 5000;  // well past the 1024 pending-task limit
+  int count = 0;           // only touched on the service thread
+
+  std::vector<std::thread> ths;
+  for (int p = 0; p < producers; ++p)
+    ths.emplace_back([as, &count]() {
+      for (int i = 0; i < tasks; ++i)
+        as->execute([as, &count]() {
+          if (++count == producers * tasks) as->stop();
+        });
+    });
+
+  as->run();
+  for (auto& t : ths) t.join();
+  REQUIRE(count == producers * tasks);
+}
+
+TEST_CASE("named offload pool grows under load and shrinks when idle",
+          "[service][offload_pool]")
+{
+  auto as = asyik::make_service();
+  asyik::offload_pool_config cfg;
+  cfg.min_threads = 1;
+  cfg.max_threads = 4;
+  cfg.idle_timeout = std::chrono::milliseconds(50);
+  auto pool = asyik::make_offload_pool("test", cfg);
+  REQUIRE(pool->name() == "test");
+  REQUIRE(pool->get_stats().threads == 1);
+
+  as->execute([as, pool]() {
+    std::vector<fibers::future<int>> results;
+    // each task blocks its thread, so the pool must grow to run them
+    for (int i = 0; i < 8; i++)
+      results.push_back(as->async(pool, [i]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return i;
+      }));
+    for (int i = 0; i < 8; i++) REQUIRE(results[i].get() == i);
+
+    // a task's run time is only counted after its result is set
+    auto settled =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(1000);
+    while (pool->get_stats().run_time.total() < 8 &&
+           std::chrono::steady_clock::now() < settled)
+      asyik::sleep_for(std::chrono::milliseconds(1));
+    auto s = pool->get_stats();
+    REQUIRE(s.peak_threads == 4);
+    REQUIRE(s.task_started == 8);
+    REQUIRE(s.queue_wait_max_us >= 10000);
+    REQUIRE(s.queue_wait.total() == 8);
+    REQUIRE(s.run_time.total() == 8);
+    REQUIRE(s.run_time.quantile_us(0.5) >= 20000);
+    REQUIRE(s.run_time_total_us >= 8 * 20000);
+
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(1000);
+    while (pool->get_stats().threads > 1 &&
+           std::chrono::steady_clock::now() < deadline)
+      asyik::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(pool->get_stats().threads == 1);
+
+    REQUIRE_THROWS(as->async(pool, []() -> int { throw 1; }).get());
+    as->stop();
+  });
+
+  as->run();
+}
+
+TEST_CASE("an offload pool shrinking to zero threads still runs new tasks",
+          "[service][offload_pool]")
+{
+  // tasks arrive about when the last worker times out; one that is queued
+  // while that worker leaves must not wait for the next submission
+  auto as = asyik::make_service();
+  asyik::offload_pool_config cfg;
+  cfg.min_threads = 0;
+  cfg.max_threads = 1;
+  cfg.idle_timeout = std::chrono::milliseconds(1);
+  auto pool = asyik::make_offload_pool("shrink", cfg);
+
+  int done = 0;
+  as->execute([as, pool, &done]() {
+    for (; done < 300; done++) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(900 + done % 7 * 50));
+      auto f = as->async(pool, [i = done]() { return i; });
+      if (f.wait_for(std::chrono::seconds(2)) != fibers::future_status::ready ||
+          f.get() != done)
+        break;
+    }
+    as->stop();
+  });
+
+  as->run();
+  REQUIRE(done == 300);
+}
+
+TEST_CASE("async_stats add up the tasks of every worker thread",
+          "[service][offload_pool]")
+{
+  auto as = asyik::make_service();
+  as->execute([as]() {
+    as->async([]() {}).get();  // start the pool
+    auto before = asyik::service::get_async_stats();
+
+    std::vector<fibers::future<void>> results;
+    for (int i = 0; i < 200; i++)
+      results.push_back(as->async([i]() {
+        std::this_thread::sleep_for(std::chrono::microseconds(i % 4 * 500));
+        if (i % 20 == 0) throw std::runtime_error("expected");
+      }));
+    int failed = 0;
+    for (auto& f : results) try {
+        f.get();
+      } catch (const std::runtime_error&) {
+        failed++;
+      }
+    REQUIRE(failed == 10);
+
+    // a task is counted as terminated only after its future is set
+    auto after = asyik::service::get_async_stats();
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(1000);
+    while (after.task_terminated - before.task_terminated < 200 &&
+           std::chrono::steady_clock::now() < deadline) {
+      asyik::sleep_for(std::chrono::milliseconds(1));
+      after = asyik::service::get_async_stats();
+    }
+    REQUIRE(after.task_terminated - before.task_terminated == 200);
+    REQUIRE(after.task_error - before.task_error == 10);
+    REQUIRE(after.run_time.total() == after.task_terminated);
+    REQUIRE(after.queue_wait.total() >= after.run_time.total());
+    asyik::latency_histogram run_time;
+    for (std::size_t b = 0; b < run_time.buckets; b++)
+      run_time.counts[b] = after.run_time.counts[b] - before.run_time.counts[b];
+    REQUIRE(run_time.total() == 200);
+    // a quarter of the tasks slept 1.5ms, another quarter 1ms
+    REQUIRE(run_time.quantile_us(0.9) >= 1024);
+    REQUIRE(run_time.quantile_us(0.1) < 1024);
+    REQUIRE(after.run_time_total_us - before.run_time_total_us >= 150000);
+    as->stop();
+  });
+  as->run();
+}
+
+TEST_CASE("event-driven run mode executes fibers, sleeps and async()",
+          "[service][event_driven]")
+{
+  auto as = asyik::make_service();
+  as->set_run_mode(asyik::service_run_mode::event_driven);
+  REQUIRE(as->get_run_mode() == asyik::service_run_mode::event_driven);
+
+  std::string sequence;
+  as->execute([&] {
+    sequence += "A";
+    asyik::sleep_for(std::chrono::milliseconds(10));
+    sequence += "A";
+    asyik::sleep_for(std::chrono::milliseconds(20));
+    sequence += "A";
+  });
+  as->execute([as, &sequence] {
+    asyik::sleep_for(std::chrono::milliseconds(20));
+    sequence += "B";
+    std::string s = as->async([]() -> std::string { return "async"; }).get();
+    REQUIRE(s == "async");
+    asyik::sleep_for(std::chrono::milliseconds(20));
+    sequence += "B";
+    as->stop();
+  });
+  as->run();
+  REQUIRE(sequence == "AABAB");
+}
+
+TEST_CASE("event-driven run mode wakes up on cross-thread execute()",
+          "[service][event_driven]")
+{
+  auto as = asyik::make_service();
+  as->set_run_mode(asyik::service_run_mode::event_driven);
+  std::atomic<int> count{0};
+
+  std::thread th([as, &count]() {
+    for (int i = 0; i < 5; i++) {
+      // let the service go fully idle before every wakeup
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      auto ts = std::chrono::steady_clock::now();
+      as->execute([ts, &count]() {
+          auto diff = std::chrono::steady_clock::now() - ts;
+          REQUIRE(std::chrono::duration_cast<std::chrono::milliseconds>(diff)
+                      .count() < 20);
+          count++;
+        }).get();
+    }
+    as->stop();
+  });
+
+  as->run();
+  th.join();
+  REQUIRE(count == 5);
+}
+
+TEST_CASE("cross-thread wakeups are not lost when they coalesce",
+          "[service][event_driven]")
+{
+  for (auto mode : {asyik::service_run_mode::polling,
+                    asyik::service_run_mode::event_driven,
+                    asyik::service_run_mode::busy_poll}) {
+    auto as = asyik::make_service();
+    as->set_run_mode(mode);
+    boost::fibers::buffered_channel<boost::fibers::promise<int>*> ch(64);
+    std::vector<std::thread> setters;
+    for (int i = 0; i < 3; i++)
+      setters.emplace_back([&ch]() {
+        boost::fibers::promise<int>* p;
+        while (ch.pop(p) == boost::fibers::channel_op_status::success)
+          p->set_value(1);
+      });
+
+    std::atomic<int> woken{0};
+    std::atomic<int> running{16};
+    for (int f = 0; f < 16; f++)
+      as->execute([&]() {
+        for (int i = 0; i < 2000; i++) {
+          boost::fibers::promise<int> p;
+          auto fut = p.get_future();
+          ch.push(&p);
+          woken += fut.get();
+        }
+        if (--running == 0) as->stop();
+      });
+
+    auto t0 = std::chrono::steady_clock::now();
+    as->run();
+    ch.close();
+    for (auto& t : setters) t.join();
+    REQUIRE(woken == 16 * 2000);
+    REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::seconds(20));
+  }
+}
+
+TEST_CASE("event-driven run mode does not spin while idle",
+          "[service][event_driven]")
+{
+  auto as = asyik::make_service();
+  as->set_run_mode(asyik::service_run_mode::event_driven);
+
+  as->execute([as]() {
+    auto cpu_us = []() {
+      struct rusage ru;
+      getrusage(RUSAGE_THREAD, &ru);
+      return ru.ru_utime.tv_sec * 1000000L + ru.ru_utime.tv_usec +
+             ru.ru_stime.tv_sec * 1000000L + ru.ru_stime.tv_usec;
+    };
+    auto start = cpu_us();
+    asyik::sleep_for(std::chrono::milliseconds(500));
+    auto used = cpu_us() - start;
+    LOG(INFO) << "event-driven idle cpu(us)=" << used << "\n";
+    REQUIRE(used < 50000);
+    as->stop();
+  });
+  as->run();
+}
+
+TEST_CASE("event-driven run mode with auto stopping run()",
+          "[service][event_driven]")
+{
+  auto as = asyik::make_service();
+  as->set_run_mode(asyik::service_run_mode::event_driven);
+  int count = 0;
+
+  for (int i = 0; i < 100; i++) {
+    as->execute([&count, as]() {
+      as->async([]() {
+          asyik::sleep_for(std::chrono::milliseconds(rand() % 50));
+        }).get();
+      count++;
+    });
+  }
+
+  as->run(true);
+  REQUIRE(count == 100);
+}
+
+TEST_CASE("busy-poll run mode runs fibers, sleeps, async() and wakeups",
+          "[service][busy_poll]")
+{
+  auto as = asyik::make_service();
+  as->set_run_mode(asyik::service_run_mode::busy_poll);
+  REQUIRE(as->get_run_mode() == asyik::service_run_mode::busy_poll);
+
+  std::string sequence;
+  as->execute([&] {
+    sequence += "A";
+    asyik::sleep_for(std::chrono::milliseconds(10));
+    sequence += "A";
+    asyik::sleep_for(std::chrono::milliseconds(20));
+    sequence += "A";
+  });
+  std::atomic<int> remote{0};
+  std::thread th;
+  as->execute([&] {
+    asyik::sleep_for(std::chrono::milliseconds(20));
+    sequence += "B";
+    std::string s = as->async([]() -> std::string { return "async"; }).get();
+    REQUIRE(s == "async");
+    asyik::sleep_for(std::chrono::milliseconds(20));
+    sequence += "B";
+
+    th = std::thread([as, &remote]() {
+      for (int i = 0; i < 5; i++) as->execute([&remote]() { remote++; }).get();
+      as->stop();
+    });
+  });
+  as->run();
+  th.join();
+  REQUIRE(sequence == "AABAB");
+  REQUIRE(remote == 5);
+
+  // every round of the loop is counted, and at least the idle sleeps came
+  // back empty
+  auto stats = as->get_scheduler_stats();
+  REQUIRE(stats.busy_polls > 0);
+  REQUIRE(stats.busy_polls_empty > 0);
+  REQUIRE(stats.busy_polls_empty < stats.busy_polls);
+}
+
+TEST_CASE("busy-poll run mode with auto stopping run()",
+          "[service][busy_poll]")
+{
+  auto as = asyik::make_service();
+  as->set_run_mode(asyik::service_run_mode::busy_poll);
+  int count = 0;
+
+  for (int i = 0; i < 20; i++) {
+    as->execute([&count, as]() {
+      as->async([]() {
+          asyik::sleep_for(std::chrono::milliseconds(rand() % 20));
+        }).get();
+      count++;
+    });
+  }
+
+  as->run(true);
+  REQUIRE(count == 20);
+}
+
+TEST_CASE("use_fiber_future socket I/O runs on the configured io backend",
+          "[service][io_backend]")
+{
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+  REQUIRE(std::string(asyik::io_backend()) == "io_uring");
+#elif defined(__linux__)
+  REQUIRE(std::string(asyik::io_backend()) == "epoll");
+#endif
+
+  auto as = asyik::make_service();
+  as->set_run_mode(asyik::service_run_mode::event_driven);
+  std::string echoed;
+
+  as->execute([&]() {
+    namespace ip = boost::asio::ip;
+    auto& io = as->get_io_service();
+    ip::tcp::acceptor acceptor(io, ip::tcp::endpoint(ip::tcp::v4(), 0));
+    auto port = acceptor.local_endpoint().port();
+
+    as->execute([&]() {
+      ip::tcp::socket peer(io);
+      acceptor.async_accept(peer, asyik::use_fiber_future).get();
+      std::array<char, 5> buf;
+      boost::asio::async_read(peer, boost::asio::buffer(buf),
+                              asyik::use_fiber_future)
+          .get();
+      boost::asio::async_write(peer, boost::asio::buffer(buf),
+                               asyik::use_fiber_future)
+          .get();
+    });
+
+    ip::tcp::socket client(io);
+    client
+        .async_connect(ip::tcp::endpoint(ip::address_v4::loopback(), port),
+                       asyik::use_fiber_future)
+        .get();
+    boost::asio::async_write(client, boost::asio::buffer("hello", 5),
+                             asyik::use_fiber_future)
+        .get();
+    std::array<char, 5> buf;
+    boost::asio::async_read(client, boost::asio::buffer(buf),
+                            asyik::use_fiber_future)
+        .get();
+    echoed.assign(buf.data(), buf.size());
+    as->stop();
+  });
+
+  as->run();
+  REQUIRE(echoed == "hello");
+}
+
+TEST_CASE("work-stealing group moves work away from a blocked worker",
+          "[service][work_stealing]")
+{
+  const std::size_t n = 4;
+  auto group = std::make_shared<asyik::work_stealing_group>(n);
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < n; ++i)
+    workers.emplace_back([group, i]() {
+      fibers::use_scheduling_algorithm<asyik_work_stealing>(group, i);
+      work_stealing_group::task_type tsk;
+      while (group->pop(i, tsk)) fiber(std::move(tsk)).detach();
+    });
+
+  std::atomic<int> done{0};
+  std::atomic<bool> blocked{false};
+  // whichever worker picks this up has its thread blocked outright
+  group->submit([&done, &blocked]() {
+    blocked = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    done++;
+  });
+  while (!blocked) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  for (int i = 0; i < 40; i++)
+    group->submit([&done]() {
+      for (int j = 0; j < 3; j++)
+        boost::this_fiber::sleep_for(std::chrono::milliseconds(1));
+      done++;
+    });
+
+  // the tasks queued on the blocked worker must be stolen, well before its
+  // thread wakes up again
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+  while (done < 40 && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  REQUIRE(done == 40);
+  REQUIRE(group->task_steals() >= 10);
+
+  while (done < 41) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  for (auto depth : group->queue_depths()) REQUIRE(depth == 0);
+
+  group->close();
+  for (auto& t : workers) t.join();
+}
+
+TEST_CASE("when_all and when_any wait on groups of fiber futures",
+          "[service][futures]")
+{
+  auto as = asyik::make_service();
+  as->execute([as]() {
+    auto after = [as](int ms, int v) {
+      return as
+          ->execute([ms, v]() {
+            asyik::sleep_for(std::chrono::milliseconds(ms));
+            return v;
+          })
+          .share();
+    };
+
+    auto a = after(30, 1), b = after(10, 2), c = after(20, 3);
+    REQUIRE(asyik::when_any(a, b, c) == 1);
+    asyik::when_all(a, b, c);
+    REQUIRE(a.get() + b.get() + c.get() == 6);
+    // already ready: no waiting, the first one wins
+    REQUIRE(asyik::when_any(c, a) == 0);
+
+    auto slow = after(200, 4), fast = after(10, 5);
+    REQUIRE(!asyik::when_all_for(std::chrono::milliseconds(50), fast, slow));
+    REQUIRE(fast.get() == 5);
+    REQUIRE(asyik::when_any_for(std::chrono::milliseconds(20), slow) == 1);
+    REQUIRE(asyik::when_all_for(std::chrono::seconds(1), slow));
+    REQUIRE(slow.get() == 4);
+
+    std::vector<fibers::shared_future<int>> fs;
+    for (int i = 0; i < 5; i++) fs.push_back(after(50 - i * 10, i));
+    REQUIRE(asyik::when_any(fs) == 4);
+    REQUIRE(asyik::when_all_for(std::chrono::seconds(1), fs));
+
+    // a future holding an exception is ready as well
+    auto failed = as->execute([]() -> int {
+                      asyik::sleep_for(std::chrono::milliseconds(5));
+                      throw std::runtime_error("upstream failed");
+                    })
+                      .share();
+    REQUIRE(asyik::when_any(after(100, 6), failed) == 1);
+    REQUIRE_THROWS(failed.get());
+
+    as->stop();
+  });
+  as->run();
+}
+
+#if BOOST_ASIO_VERSION >= 101900
+TEST_CASE("when_any cancels the losing operations of a cancellation_scope",
+          "[service][futures]")
+{
+  auto as = asyik::make_service();
+  as->execute([as]() {
+    auto& io = as->get_io_service();
+    boost::asio::steady_timer fast(io, std::chrono::milliseconds(10));
+    boost::asio::steady_timer slow(io, std::chrono::seconds(5));
+    asyik::cancellation_scope scope;
+    auto f = fast.async_wait(scope.token()).share();
+    auto s = slow.async_wait(scope.token()).share();
+    REQUIRE(scope.pending() == 2);
+
+    auto t0 = std::chrono::steady_clock::now();
+    REQUIRE(asyik::when_any(scope, f, s) == 0);
+    REQUIRE_THROWS_AS(s.get(), boost::system::system_error);
+    REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::seconds(1));
+    REQUIRE(scope.pending() == 0);
+
+    // on timeout when_all cancels everything still pending
+    slow.expires_after(std::chrono::seconds(5));
+    auto s2 = slow.async_wait(scope.token()).share();
+    REQUIRE(!asyik::when_all_for(scope, std::chrono::milliseconds(10), s2));
+    REQUIRE_THROWS_AS(s2.get(), boost::system::system_error);
+
+    as->stop();
+  });
+  as->run();
+}
+#endif
+
 // ---------------------------------------------------------------------------
 // Scheduler-level termination tests
 // ---------------------------------------------------------------------------